@@ -0,0 +1,383 @@
+#include <Easy2D.hpp>
+
+using namespace Easy2D;
+
+//----------------------------------------------------------------------------//
+// Asset
+//----------------------------------------------------------------------------//
+
+enum : uint64
+{
+	CookerVersion = 1, //!< change to invalidate all cooked files
+};
+
+//!
+enum class AssetType
+{
+	Copy, //!< unknown file, copied as is
+	Image, //!< image file, cooked to TextureData with mips
+	Texture, //!< descriptor of texture (json with image in "Source"), cooked to TextureData
+	Json, //!< other json, cooked to binary form
+};
+
+//!
+struct Asset
+{
+	String name; //!< name relative to data directory
+	String path;
+	uint64 size = 0;
+	uint64 time = 0;
+	uint64 hash = 0; //!< hash of content
+	AssetType type = AssetType::Copy;
+	String source; //!< image of texture descriptor
+	uint64 key = 0; //!< hash of cooker version, type and content of dependencies
+	bool dirty = false;
+	bool failed = false;
+};
+
+//----------------------------------------------------------------------------//
+// Utils
+//----------------------------------------------------------------------------//
+
+//!
+bool IsImage(const String& _name)
+{
+	static const char* _exts[] = { "png", "jpg", "jpeg", "bmp", "tga", "gif", "psd", "hdr" };
+	String _ext = PathUtils::Extension(_name);
+	for (const char* _e : _exts)
+	{
+		if (!StringUtils::Cmpi(_ext.c_str(), _e))
+			return true;
+	}
+	return false;
+}
+
+//!
+bool ReadFile(const String& _path, Array<uint8>& _dst)
+{
+	FileStream _file;
+	if (!_file.Open(_path, FileStream::Mode::ReadOnly))
+		return false;
+	_dst.resize((size_t)_file.Size());
+	return _file.Read(_dst.data(), _dst.size()) == _dst.size();
+}
+
+//! Write file, creating its directory
+bool WriteFile(const String& _path, const void* _data, size_t _size)
+{
+	size_t _dirEnd = _path.find_last_of('/');
+	if (_dirEnd != String::npos && !FileSystem::CreateDir(_path.substr(0, _dirEnd + 1)))
+		return false;
+
+	FileStream _file;
+	return _file.Open(_path, FileStream::Mode::Overwrite) && _file.Write(_data, _size) == _size;
+}
+
+//!
+String ToHex(uint64 _value)
+{
+	return StringUtils::Format("%016llx", (unsigned long long)_value);
+}
+
+//!
+uint64 FromHex(const String& _str)
+{
+	return strtoull(_str.c_str(), nullptr, 16);
+}
+
+//! List files of directory recursively
+void ListAssets(const String& _dir, const String& _prefix, Array<Asset>& _assets)
+{
+	Array<FileInfo> _files;
+	if (!FileSystem::ListFiles(_dir, _files))
+	{
+		printf("Error: Unable to read directory \"%s\"\n", _dir.c_str());
+		return;
+	}
+
+	for (const FileInfo& _file : _files)
+	{
+		if (_file.isDir)
+		{
+			ListAssets(_dir + _file.name + "/", _prefix + _file.name + "/", _assets);
+		}
+		else
+		{
+			Asset _asset;
+			_asset.name = _prefix + _file.name;
+			_asset.path = _dir + _file.name;
+			_asset.size = _file.size;
+			_asset.time = _file.time;
+			_assets.push_back(_asset);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------//
+// Cook
+//----------------------------------------------------------------------------//
+
+//! Decode image and build TextureData
+bool CookTexture(const String& _path, bool _compress, Texture::Type _type, Array<uint8>& _dst)
+{
+	MappedFileStreamPtr _src = new MappedFileStream;
+	if (!_src->Open(_path, Stream::Access::Sequential))
+		return false;
+
+	ImagePtr _img = new Image;
+	_img->SetName(_path);
+	if (!_img->BeginLoad(_src))
+		return false;
+
+	TextureData::Build(_img->Layer(0), _img->Width(), _img->Height(), _img->Channels(), _compress, true, (uint32)_type, _dst);
+	return true;
+}
+
+//! Process asset and write result to output directory
+bool Cook(const Asset& _asset, const String& _dataDir, const String& _outDir)
+{
+	Array<uint8> _src, _dst;
+	switch (_asset.type)
+	{
+	case AssetType::Image:
+		if (!CookTexture(_asset.path, false, Texture::Type::Default, _dst))
+			return false;
+		break;
+
+	case AssetType::Texture:
+	{
+		Json _desc;
+		if (!ReadFile(_asset.path, _src) || !_desc.Parse(reinterpret_cast<const char*>(_src.data()), _src.size()))
+			return false;
+		if (!CookTexture(_dataDir + _asset.source, _desc["UseCompression"], Texture::TypeFromName(_desc["Type"].AsString()), _dst))
+			return false;
+
+	} break;
+
+	case AssetType::Json:
+	{
+		Json _json;
+		if (!ReadFile(_asset.path, _src) || !_json.Parse(reinterpret_cast<const char*>(_src.data()), _src.size()))
+			return false;
+		_json.PrintBinary(_dst);
+
+	} break;
+
+	default:
+		if (!ReadFile(_asset.path, _dst))
+			return false;
+		break;
+	}
+
+	return WriteFile(_outDir + _asset.name, _dst.data(), _dst.size());
+}
+
+//----------------------------------------------------------------------------//
+// PrintUsage
+//----------------------------------------------------------------------------//
+
+int PrintUsage(void)
+{
+	printf("Usage:\n");
+	printf("  AssetCooker <data directory> <output directory> [-p <output.pak>] [-c] [-f]\n");
+	printf("    -p  pack cooked files to package, -c compresses its entries (LZ4)\n");
+	printf("    -f  cook all files, ignore manifest of previous run\n");
+	return 1;
+}
+
+//----------------------------------------------------------------------------//
+// main
+//----------------------------------------------------------------------------//
+
+int main(int _argc, char** _argv)
+{
+	if (_argc < 3)
+		return PrintUsage();
+
+	String _dataDir = PathUtils::Normalize(_argv[1]) + "/";
+	String _outDir = PathUtils::Normalize(_argv[2]) + "/";
+	String _package;
+	Package::Codec _codec = Package::Codec::None;
+	bool _force = false;
+	for (int i = 3; i < _argc; ++i)
+	{
+		if (!strcmp(_argv[i], "-c"))
+			_codec = Package::Codec::Lz4;
+		else if (!strcmp(_argv[i], "-f"))
+			_force = true;
+		else if (!strcmp(_argv[i], "-p") && i + 1 < _argc)
+			_package = _argv[++i];
+		else
+			return PrintUsage();
+	}
+
+	if (!FileSystem::CreateDir(_outDir))
+		return 2;
+
+	ThreadPool _threads; // assets are hashed and cooked in parallel
+
+	Array<Asset> _assets;
+	ListAssets(_dataDir, "", _assets);
+	HashMap<String, uint> _byName; // key is IndexKey of name
+	for (uint i = 0; i < (uint)_assets.size(); ++i)
+		_byName[FileSystem::IndexKey(_assets[i].name)] = i;
+
+	// manifest of previous run: content hashes of sources and keys of cooked files
+	String _manifestPath = _outDir + "Cooked.manifest";
+	Json _manifest;
+	Array<uint8> _manifestData;
+	FileInfo _manifestInfo;
+	if (_force || !FileSystem::Stat(_manifestPath, _manifestInfo) || !ReadFile(_manifestPath, _manifestData) || !_manifest.ParseBinary(_manifestData.data(), _manifestData.size()) || _manifest["Version"].AsInt() != (int)CookerVersion)
+		_manifest = Json::EmptyObject;
+	const Json& _oldFiles = _manifest["Files"];
+
+	// hash content of changed files
+	_threads.ParallelFor((uint)_assets.size(), [&](uint i)
+	{
+		Asset& _asset = _assets[i];
+		const Json* _old = _oldFiles.Find(_asset.name);
+		if (_old && FromHex((*_old)["Size"]) == _asset.size && FromHex((*_old)["Time"]) == _asset.time)
+		{
+			_asset.hash = FromHex((*_old)["Hash"]);
+			return;
+		}
+
+		Array<uint8> _data;
+		if (!ReadFile(_asset.path, _data))
+		{
+			printf("Error: Unable to read \"%s\"\n", _asset.path.c_str());
+			_asset.failed = true;
+			return;
+		}
+		_asset.hash = Checksum::XxHash64(_data.data(), _data.size());
+
+		if (!StringUtils::Cmpi(PathUtils::Extension(_asset.name).c_str(), "json"))
+		{
+			Json _json;
+			if (_json.Parse(reinterpret_cast<const char*>(_data.data()), _data.size()))
+			{
+				_asset.type = AssetType::Json;
+				if (_json.IsObject() && _json["Source"].IsString() && IsImage(_json["Source"]))
+				{
+					_asset.type = AssetType::Texture;
+					_asset.source = PathUtils::Normalize(_json["Source"]);
+				}
+			}
+		}
+	});
+
+	// dependencies and keys
+	for (Asset& _asset : _assets)
+	{
+		if (_asset.failed)
+			continue;
+
+		const Json* _old = _oldFiles.Find(_asset.name);
+		if (_old && _asset.type == AssetType::Copy && FromHex((*_old)["Hash"]) == _asset.hash) // content was not read, restore type
+		{
+			_asset.type = (AssetType)(*_old)["Type"].AsInt();
+			_asset.source = (*_old)["Source"].AsString();
+		}
+		if (_asset.type == AssetType::Copy && IsImage(_asset.name))
+			_asset.type = AssetType::Image;
+
+		XxHash64 _key(CookerVersion);
+		_key.Update(&_asset.type, sizeof(_asset.type));
+		_key.Update(&_asset.hash, sizeof(_asset.hash));
+		if (_asset.type == AssetType::Texture)
+		{
+			auto _src = _byName.find(FileSystem::IndexKey(_asset.source));
+			if (_src == _byName.end())
+			{
+				printf("Error: Source \"%s\" of \"%s\" not found\n", _asset.source.c_str(), _asset.name.c_str());
+				_asset.failed = true;
+				continue;
+			}
+			_key.Update(&_assets[_src->second].hash, sizeof(uint64));
+		}
+		if (_asset.type == AssetType::Image || _asset.type == AssetType::Texture)
+		{
+			uint32 _version = TextureData::Version;
+			_key.Update(&_version, sizeof(_version));
+		}
+		_asset.key = _key.Digest();
+
+		FileInfo _out;
+		_asset.dirty = !_old || FromHex((*_old)["Key"]) != _asset.key || !FileSystem::Stat(_outDir + _asset.name, _out);
+	}
+
+	// cook
+	Array<Asset*> _dirty;
+	for (Asset& _asset : _assets)
+	{
+		if (_asset.dirty && !_asset.failed)
+			_dirty.push_back(&_asset);
+	}
+
+	std::atomic<uint> _done(0);
+	_threads.ParallelFor((uint)_dirty.size(), [&](uint i)
+	{
+		Asset& _asset = *_dirty[i];
+		if (!Cook(_asset, _dataDir, _outDir))
+		{
+			printf("Error: Unable to cook \"%s\"\n", _asset.name.c_str());
+			_asset.failed = true;
+		}
+		else
+			printf("[%u/%u] %s\n", ++_done, (uint)_dirty.size(), _asset.name.c_str());
+	});
+
+	// delete outputs of removed sources
+	for (auto _it = _oldFiles.Begin(); _it != _oldFiles.End(); ++_it)
+	{
+		if (_byName.find(FileSystem::IndexKey(_it->first)) == _byName.end())
+			FileSystem::Remove(_outDir + _it->first);
+	}
+
+	// new manifest
+	uint _numFailed = 0, _numSkipped = 0;
+	Json _files = Json::EmptyObject;
+	for (const Asset& _asset : _assets)
+	{
+		if (_asset.failed)
+		{
+			++_numFailed;
+			continue;
+		}
+		if (!_asset.dirty)
+			++_numSkipped;
+
+		Json& _file = _files[_asset.name];
+		_file["Size"] = ToHex(_asset.size);
+		_file["Time"] = ToHex(_asset.time);
+		_file["Hash"] = ToHex(_asset.hash);
+		_file["Key"] = ToHex(_asset.key);
+		_file["Type"] = (int)_asset.type;
+		if (!_asset.source.empty())
+			_file["Source"] = _asset.source;
+	}
+	_manifest = Json::EmptyObject;
+	_manifest["Version"] = (int)CookerVersion;
+	_manifest["Files"] = std::move(_files);
+	_manifestData.clear();
+	_manifest.PrintBinary(_manifestData);
+	if (!WriteFile(_manifestPath, _manifestData.data(), _manifestData.size()))
+		return 2;
+
+	printf("%u files, %u cooked, %u up to date, %u failed\n", (uint)_assets.size(), _done.load(), _numSkipped, _numFailed);
+
+	if (!_package.empty())
+	{
+		PackageWriter _writer;
+		_writer.SetCodec(_codec);
+		for (const Asset& _asset : _assets)
+		{
+			if (!_asset.failed)
+				_writer.AddFile(_asset.name, _outDir + _asset.name);
+		}
+		if (!_writer.Save(_package))
+			return 2;
+	}
+
+	return _numFailed ? 3 : 0;
+}
@@ -0,0 +1,449 @@
+#include <Easy2D.hpp>
+#include <chrono>
+#include <thread>
+#include <new>
+
+using namespace Easy2D;
+
+//----------------------------------------------------------------------------//
+// Utils
+//----------------------------------------------------------------------------//
+
+//! \return the best time of _runs calls of _func in milliseconds
+template <class F> double BestTime(uint _runs, F&& _func)
+{
+	double _best = 1e30;
+	for (uint i = 0; i < _runs; ++i)
+	{
+		auto _start = std::chrono::steady_clock::now();
+		_func();
+		_best = Min(_best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count());
+	}
+	return _best;
+}
+
+//! Write file on disk
+bool WriteFile(const String& _name, const void* _data, size_t _size)
+{
+	FileStream _file;
+	return _file.Open(_name, FileStream::Mode::Overwrite) && _file.Write(_data, _size) == _size;
+}
+
+//----------------------------------------------------------------------------//
+// PrintUsage
+//----------------------------------------------------------------------------//
+
+int PrintUsage(void)
+{
+	printf("Usage:\n");
+	printf("  Bench load [MB]              load json and image of given size (32 MB by default): mapped file vs file copied to memory\n");
+	printf("  Bench contention [threads]   look up and request cached resources from 1 to given number of threads (8 by default)\n");
+	printf("  Bench lookup                 build json objects with 10, 1k and 100k keys and look up every key\n");
+	printf("  Bench numbers                parse json array of 300k integers and fractions\n");
+	printf("  Bench document               parse 12 MB level with Json and JsonDocument: time and peak of heap\n");
+	return 1;
+}
+
+//----------------------------------------------------------------------------//
+// BenchLoad
+//----------------------------------------------------------------------------//
+
+//! Array of small objects, about _size bytes
+String MakeJsonText(size_t _size)
+{
+	String _text = "[\n";
+	for (uint i = 0; _text.length() < _size; ++i)
+		_text += StringUtils::Format("\t{ \"Name\": \"Entity_%u\", \"Position\": [%u.5, %u.25], \"Visible\": true },\n", i, i % 1000, i % 777);
+	_text += "\t{}\n]\n";
+	return _text;
+}
+
+//! Uncompressed 32-bit TGA, about _size bytes
+Array<uint8> MakeTgaImage(size_t _size)
+{
+	uint _width = 2048, _height = Clamp((uint)(_size / (_width * 4)), 1u, 65535u);
+	uint8 _header[18] = { 0, 0, 2 };
+	_header[12] = (uint8)_width;
+	_header[13] = (uint8)(_width >> 8);
+	_header[14] = (uint8)_height;
+	_header[15] = (uint8)(_height >> 8);
+	_header[16] = 32;
+
+	Array<uint8> _data(sizeof(_header) + (size_t)_width * _height * 4);
+	memcpy(_data.data(), _header, sizeof(_header));
+	for (size_t i = sizeof(_header); i < _data.size(); ++i)
+		_data[i] = (uint8)(i * 7 + (i >> 12));
+	return _data;
+}
+
+//! Parse json or decode image from _src
+bool LoadFile(Stream* _src, bool _json)
+{
+	if (_json)
+	{
+		Json _doc;
+		return _doc.Load(_src);
+	}
+	ImagePtr _image = new Image;
+	return _image->BeginLoad(_src);
+}
+
+//! Files are read from the file cache of OS: the difference is the copy to memory, not the disk.
+int BenchLoad(uint _sizeMB)
+{
+	const uint _runs = 5;
+	size_t _size = (size_t)_sizeMB << 20;
+
+	String _text = MakeJsonText(_size);
+	Array<uint8> _image = MakeTgaImage(_size);
+	if (!WriteFile("BenchLoad.json", _text.c_str(), _text.length()) || !WriteFile("BenchLoad.tga", _image.data(), _image.size()))
+	{
+		printf("Error: Unable to write files of benchmark\n");
+		return 2;
+	}
+
+	struct { const char* name; bool json; } _files[] = { { "BenchLoad.json", true }, { "BenchLoad.tga", false } };
+	printf("%-16s %8s %10s %10s\n", "file", "MB", "copy ms", "mapped ms");
+	bool _ok = true;
+	for (const auto& _file : _files)
+	{
+		// plain FileStream: Json::Load copies the file to memory, Image reads it through callbacks
+		double _copy = BestTime(_runs, [&]()
+		{
+			FileStreamPtr _src = new FileStream;
+			_ok &= _src->Open(_file.name, FileStream::Mode::ReadOnly) && LoadFile(_src, _file.json);
+		});
+
+		// parsed and decoded straight from the mapping
+		double _mapped = BestTime(_runs, [&]()
+		{
+			MappedFileStreamPtr _src = new MappedFileStream;
+			_ok &= _src->Open(_file.name, Stream::Access::Sequential) && LoadFile(_src, _file.json);
+		});
+
+		FileInfo _info;
+		FileSystem::Stat(_file.name, _info);
+		printf("%-16s %8.1f %10.1f %10.1f\n", _file.name, _info.size / (1024.0 * 1024.0), _copy, _mapped);
+	}
+
+	FileSystem::Remove("BenchLoad.json");
+	FileSystem::Remove("BenchLoad.tga");
+	return _ok ? 0 : 2;
+}
+
+//----------------------------------------------------------------------------//
+// BenchContention
+//----------------------------------------------------------------------------//
+
+//! Resource which only counts its loadings
+class BenchResource : public Resource
+{
+public:
+	RTTI("BenchResource");
+
+	//!
+	bool BeginLoad(Stream* _src) override
+	{
+		++s_loads;
+		return true;
+	}
+
+	static std::atomic<uint> s_loads;
+};
+
+std::atomic<uint> BenchResource::s_loads(0);
+
+//! Run _func(thread, iteration) _count times on each of _threads threads. \return millions of calls per second of all threads
+template <class F> double RunThreads(uint _threads, uint _count, F&& _func)
+{
+	Array<std::thread> _workers;
+	auto _start = std::chrono::steady_clock::now();
+	for (uint t = 0; t < _threads; ++t)
+	{
+		_workers.push_back(std::thread([&_func, t, _count]()
+		{
+			for (uint i = 0; i < _count; ++i)
+				_func(t, i);
+		}));
+	}
+	for (std::thread& _worker : _workers)
+		_worker.join();
+
+	double _seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+	return _threads * _count / _seconds * 1e-6;
+}
+
+//! ResourceCache with 1000 loaded resources: FindResource and RequestResource of them from several threads at once
+int BenchContention(uint _maxThreads)
+{
+	const uint _numResources = 1000, _lookups = 1000000;
+
+	EngineConfig _config = EngineConfig::Headless();
+	_config.threads = -1; // RequestResource loads on workers
+	Engine _engine(_config);
+	Object::Register<BenchResource>();
+
+	Array<String> _names;
+	FileSystem::CreateDir("BenchContention/");
+	for (uint i = 0; i < _numResources; ++i)
+	{
+		_names.push_back(StringUtils::Format("BenchContention/%u.txt", i));
+		WriteFile(_names.back(), "0", 1);
+	}
+
+	// concurrent requests of one resource share one loading
+	Array<ResourcePtr> _requests(_maxThreads * 64);
+	RunThreads(_maxThreads, 64, [&](uint _thread, uint i) { _requests[_thread * 64 + i] = gResources->RequestResource<BenchResource>(_names[0]); });
+	while (gResources->NumLoading())
+	{
+		_engine.BeginFrame();
+		_engine.EndFrame();
+	}
+	bool _same = std::all_of(_requests.begin(), _requests.end(), [&_requests](const ResourcePtr& _res) { return _res == _requests[0]; });
+	printf("%u requests of one resource from %u threads: %u loading(s), same resource %s\n", (uint)_requests.size(), _maxThreads, BenchResource::s_loads.load(), _same ? "yes" : "no");
+	_requests.clear();
+
+	for (const String& _name : _names)
+		gResources->GetResource<BenchResource>(_name);
+
+	printf("%8s %16s %16s\n", "threads", "Find M/s", "Request M/s");
+	for (uint _threads = 1; _threads <= _maxThreads; _threads *= 2)
+	{
+		uint _count = _lookups / _threads;
+		double _find = RunThreads(_threads, _count, [&](uint _thread, uint i) { gResources->FindResource<BenchResource>(_names[(i * 7 + _thread) % _numResources]); });
+		double _request = RunThreads(_threads, _count, [&](uint _thread, uint i) { gResources->RequestResource<BenchResource>(_names[(i * 7 + _thread) % _numResources]); });
+		printf("%8u %16.2f %16.2f\n", _threads, _find, _request);
+	}
+	printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+
+	for (const String& _name : _names)
+		FileSystem::Remove(_name);
+	return _same && BenchResource::s_loads == 1 ? 0 : 2;
+}
+
+//----------------------------------------------------------------------------//
+// BenchLookup
+//----------------------------------------------------------------------------//
+
+//! Search of key without index, as in objects with up to Json::IndexThreshold keys
+const Json* FindLinear(const Json& _object, const String& _key)
+{
+	for (const Json::KeyValue& _item : _object.Container())
+	{
+		if (_item.first == _key)
+			return &_item.second;
+	}
+	return nullptr;
+}
+
+//! Objects with 10, 1k and 100k keys: building through operator [] and lookup of keys with index and without it
+int BenchLookup(void)
+{
+	printf("%8s %12s %16s %16s\n", "keys", "build ms", "indexed ns/key", "linear ns/key");
+	uint _found = 0, _expected = 0;
+	for (uint _size : { 10u, 1000u, 100000u })
+	{
+		Array<String> _keys;
+		for (uint i = 0; i < _size; ++i)
+			_keys.push_back(StringUtils::Format("key_%u", i * 7919));
+
+		uint _reps = Max(100000u / _size, 1u);
+		Json _object;
+		double _build = BestTime(3, [&]()
+		{
+			for (uint r = 0; r < _reps; ++r)
+			{
+				_object = Json();
+				for (const String& _key : _keys)
+					_object[_key] = 1;
+			}
+		});
+
+		const Json& _const = _object;
+		double _indexed = BestTime(3, [&]()
+		{
+			for (uint r = 0; r < _reps; ++r)
+			{
+				for (const String& _key : _keys)
+					_found += _const.Find(_key) != nullptr;
+			}
+		});
+
+		uint _sample = Min(_size, 1000u); // linear search of every key of 100k takes minutes
+		double _linear = BestTime(3, [&]()
+		{
+			for (uint r = 0; r < _reps; ++r)
+			{
+				for (uint i = 0; i < _sample; ++i)
+					_found += FindLinear(_const, _keys[i * (_size / _sample)]) != nullptr;
+			}
+		});
+
+		_expected += 3 * _reps * (_size + _sample);
+		printf("%8u %12.3f %16.1f %16.1f\n", _size, _build / _reps, _indexed * 1e6 / (_reps * _size), _linear * 1e6 / (_reps * _sample));
+	}
+	return _found == _expected ? 0 : 2;
+}
+
+//----------------------------------------------------------------------------//
+// BenchNumbers
+//----------------------------------------------------------------------------//
+
+//! Array of 300k numbers: integers, fractions with 3 digits and fractions with 9 significant digits
+int BenchNumbers(void)
+{
+	String _text = "[";
+	uint32 _random = 2;
+	for (uint i = 0; i < 300000; ++i)
+	{
+		_random = _random * 1664525 + 1013904223;
+		uint _value = _random >> 4;
+		switch (i % 3)
+		{
+		case 0:
+			_text += StringUtils::Format("%u,", _value % 100000);
+			break;
+		case 1:
+			_text += StringUtils::Format("%.3f,", (_value % 1000000) / 100.0);
+			break;
+		default:
+			_text += StringUtils::Format("%.9g,", (_value % 100000000) / 7.0);
+			break;
+		}
+	}
+	_text.back() = ']';
+
+	bool _ok = true;
+	Array<Json> _docs(5); // destroyed after measurement
+	uint _run = 0;
+	double _json = BestTime(5, [&]()
+	{
+		Json& _doc = _docs[_run++];
+		_ok &= _doc.Parse(_text.c_str(), _text.length()) && _doc.Size() == 300000;
+	});
+
+	// lower bound of a parser which uses the C library for numbers
+	double _sum = 0;
+	double _strtod = BestTime(5, [&]()
+	{
+		for (const char* _s = _text.c_str() + 1; *_s; ++_s)
+			_sum += strtod(_s, const_cast<char**>(&_s));
+	});
+
+	double _mb = _text.length() / (1024.0 * 1024.0);
+	printf("%.2f MB of numbers\n", _mb);
+	printf("Json::Parse: %7.1f ms, %6.1f MB/s\n", _json, _mb * 1000 / _json);
+	printf("strtod only: %7.1f ms, %6.1f MB/s\n", _strtod, _mb * 1000 / _strtod);
+	return _ok && _sum != 0 ? 0 : 2;
+}
+
+//----------------------------------------------------------------------------//
+// BenchDocument
+//----------------------------------------------------------------------------//
+
+static std::atomic<size_t> s_heapSize(0); //!< bytes allocated by operator new
+static std::atomic<size_t> s_heapPeak(0);
+
+//! Size of allocation is stored before the block
+void* operator new(size_t _size)
+{
+	size_t* _ptr = (size_t*)malloc(_size + 16);
+	if (!_ptr)
+		throw std::bad_alloc();
+	_ptr[0] = _size;
+
+	size_t _heap = s_heapSize += _size;
+	for (size_t _peak = s_heapPeak; _heap > _peak && !s_heapPeak.compare_exchange_weak(_peak, _heap);)
+		;
+	return _ptr + 2;
+}
+void operator delete(void* _mem) noexcept
+{
+	if (_mem)
+	{
+		size_t* _ptr = (size_t*)_mem - 2;
+		s_heapSize -= _ptr[0];
+		free(_ptr);
+	}
+}
+void* operator new[](size_t _size) { return operator new(_size); }
+void operator delete[](void* _mem) noexcept { operator delete(_mem); }
+void operator delete(void* _mem, size_t) noexcept { operator delete(_mem); }
+void operator delete[](void* _mem, size_t) noexcept { operator delete(_mem); }
+
+//! Level file: 60k entities with names, paths, vectors and tags
+String MakeLevelText(void)
+{
+	String _text = "{\n\t\"Name\": \"Level 1\",\n\t\"Entities\": [\n";
+	uint32 _random = 5;
+	auto _next = [&_random](uint _range) { _random = _random * 1664525 + 1013904223; return (_random >> 8) % _range; };
+	for (uint i = 0; i < 60000; ++i)
+	{
+		_text += StringUtils::Format("\t\t{\n\t\t\t\"Name\": \"Entity_%u\",\n\t\t\t\"Prefab\": \"Prefabs/Props/crate_%u.json\",\n", i, _next(50));
+		_text += StringUtils::Format("\t\t\t\"Position\": [%.3f, %.3f, 0.000],\n\t\t\t\"Rotation\": %.2f,\n\t\t\t\"Layer\": %u,\n", _next(100000) / 10.0, _next(100000) / 10.0, _next(3600) / 10.0, _next(8));
+		_text += "\t\t\t\"Visible\": true,\n\t\t\t\"Tags\": [\"static\", \"collidable\"]\n\t\t},\n";
+	}
+	_text.resize(_text.length() - 2);
+	_text += "\n\t]\n}\n";
+	return _text;
+}
+
+//! Measure parsing and destruction of _text by document of type T. \return false if parsing failed
+template <class T> bool MeasureDocument(const char* _name, const String& _text)
+{
+	double _parse = 1e30, _destroy = 1e30;
+	size_t _peak = 0, _usage = 0;
+	bool _ok = true;
+	for (uint _run = 0; _run < 3; ++_run)
+	{
+		size_t _base = s_heapSize;
+		s_heapPeak = _base;
+
+		auto _start = std::chrono::steady_clock::now();
+		T* _doc = new T;
+		_ok &= _doc->Parse(_text.c_str(), _text.length());
+		auto _parsed = std::chrono::steady_clock::now();
+		_usage = s_heapSize - _base;
+		delete _doc;
+		auto _end = std::chrono::steady_clock::now();
+
+		_peak = s_heapPeak - _base;
+		_parse = Min(_parse, std::chrono::duration<double, std::milli>(_parsed - _start).count());
+		_destroy = Min(_destroy, std::chrono::duration<double, std::milli>(_end - _parsed).count());
+	}
+	printf("%-14s %10.1f %12.2f %10.1f %10.1f\n", _name, _parse, _destroy, _peak / (1024.0 * 1024.0), _usage / (1024.0 * 1024.0));
+	return _ok;
+}
+
+//! Read-only document with arena against mutable Json on the same text
+int BenchDocument(void)
+{
+	String _text = MakeLevelText();
+	printf("level: %.1f MB\n", _text.length() / (1024.0 * 1024.0));
+	printf("%-14s %10s %12s %10s %10s\n", "", "parse ms", "destroy ms", "peak MB", "kept MB");
+
+	bool _ok = MeasureDocument<Json>("Json", _text);
+	_ok &= MeasureDocument<JsonDocument>("JsonDocument", _text);
+	printf("JsonDocument keeps its own copy of text (%.1f MB)\n", _text.length() / (1024.0 * 1024.0));
+	return _ok ? 0 : 2;
+}
+
+//----------------------------------------------------------------------------//
+// main
+//----------------------------------------------------------------------------//
+
+int main(int _argc, char** _argv)
+{
+	if (_argc >= 2 && !strcmp(_argv[1], "load"))
+		return BenchLoad(_argc >= 3 ? Max(atoi(_argv[2]), 1) : 32);
+	if (_argc >= 2 && !strcmp(_argv[1], "contention"))
+		return BenchContention(_argc >= 3 ? Max(atoi(_argv[2]), 1) : 8);
+	if (_argc >= 2 && !strcmp(_argv[1], "lookup"))
+		return BenchLookup();
+	if (_argc >= 2 && !strcmp(_argv[1], "numbers"))
+		return BenchNumbers();
+	if (_argc >= 2 && !strcmp(_argv[1], "document"))
+		return BenchDocument();
+
+	return PrintUsage();
+}
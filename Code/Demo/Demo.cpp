@@ -85,24 +85,106 @@ struct SpriteDesc
 
 };
 
+//! Headless engine in own context: load demo group and batch sprites.
+//! Frames start when all _count engines are loaded. \return seconds of _frames frames
+double RunHeadlessEngine(uint _frames, std::atomic<uint>& _loaded, uint _count)
+{
+	Context _context;
+	Context::Scope _scope(&_context);
+
+	Engine _engine(true);
+
+	gFileSystem->AddPath("Data/");
+	gFileSystem->AddPath("../../Data/");
+
+	SpriteDesc _sprite;
+	_sprite.pivot = { .5f, .5f };
+	_sprite.size = { 64, 64 };
+	_sprite.tc = { 0, 0, 1, 1 };
+	gResources->LoadGroup("DemoGroup.json", [&_sprite](const String& _group, bool _succeeded)
+	{
+		_sprite.texture = gResources->GetResource<Sprite>("Sprite.json")->GetTexture();
+	});
+
+	_engine.BeginFrame(); // callback of group
+	_engine.EndFrame();
+	for (++_loaded; _loaded < _count;)
+		std::this_thread::yield();
+
+	uint32 _random = 1; // rand() can be shared by threads
+	auto _start = std::chrono::steady_clock::now();
+	for (uint _frame = 0; _frame < _frames; ++_frame)
+	{
+		_engine.BeginFrame();
+		_engine.Begin2D({ 0, 0 }, 1);
+
+		for (uint i = 0; i < 20000; ++i)
+		{
+			_random = _random * 1664525 + 1013904223;
+			_sprite.Draw((float)((_random >> 8) % 800), (float)((_random >> 20) % 600), .5f, 1, 1, 0);
+		}
+
+		_engine.EndFrame();
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+}
+
+//! Scaling of headless engines: frames of one engine, then of _count engines on own threads at once
+int RunHeadless(uint _count, uint _frames)
+{
+	std::atomic<uint> _loaded(0);
+	double _single = RunHeadlessEngine(_frames, _loaded, 1);
+
+	_loaded = 0;
+	Array<double> _times(_count);
+	Array<std::thread> _threads;
+	for (uint i = 0; i < _count; ++i)
+		_threads.push_back(std::thread([&_times, &_loaded, i, _frames, _count]() { _times[i] = RunHeadlessEngine(_frames, _loaded, _count); }));
+	for (std::thread& _thread : _threads)
+		_thread.join();
+
+	double _slowest = *std::max_element(_times.begin(), _times.end());
+	double _rate = _frames / _single, _total = _count * _frames / _slowest;
+	printf("1 engine: %.1f frames/s\n", _rate);
+	printf("%u engines: %.1f frames/s each, %.1f frames/s total\n", _count, _frames / _slowest, _total);
+	printf("scaling: %.2fx of 1 engine on %u hardware threads\n", _total / _rate, std::thread::hardware_concurrency());
+	return 0;
+}
+
 #include <Windows.h>
 
-void main(void)
+//! Demo -headless <engines> [frames]: measure scaling of headless engines instead of opening window
+int main(int _argc, char** _argv)
 {
 	// SetThreadAffinityMask(GetCurrentThread(), 1); // test
 
-	Engine _engine;
+	if (_argc >= 3 && !strcmp(_argv[1], "-headless"))
+		return RunHeadless(Max(atoi(_argv[2]), 1), _argc >= 4 ? Max(atoi(_argv[3]), 1) : 100);
+
+	EngineConfig _config;
+	_config.asyncIO = true;
+	_config.derivedData = true;
+	_config.hotReload = true; // development builds only
+	_config.prefetch = true;
+
+	Engine _engine(_config);
 	{
 		gEngine->SetVSync(false);
 
 		gFileSystem->AddPath("Data/");
 		gFileSystem->AddPath("../../Data/");
+		if (gFileWatcher)
+			gFileWatcher->SetPollInterval(1); // if OS notifications are not available
 
 		SpriteDesc _sprite;
 		_sprite.pivot = { .5f, .5f };
 		_sprite.size = { 64, 64 };
 		_sprite.tc = { 0, 0, 1, 1 };
-		_sprite.texture = gResources->GetResource<Texture>("test.json");
+		// drawn without texture until the group is loaded
+		gResources->LoadGroup("DemoGroup.json", [&_sprite](const String& _group, bool _succeeded)
+		{
+			_sprite.texture = gResources->GetResource<Sprite>("Sprite.json")->GetTexture();
+		});
 
 		while (gDevice->IsOpened())
 		{
@@ -125,4 +207,5 @@ void main(void)
 				gDevice->RequireExit();
 		}
 	}
+	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,903 @@
+#include "AsyncIO.hpp"
+#include "Math.hpp"
+#ifdef __linux__
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/io_uring.h>
+#endif
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// AsyncRequest
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	AsyncRequest::State AsyncRequest::Wait(void)
+	{
+		std::unique_lock<std::mutex> _lock(m_mutex);
+		if (m_state == State::Queued && !m_native)
+		{
+			// the workers are busy (or we are the worker), read it here
+			_lock.unlock();
+			_Execute();
+			_lock.lock();
+		}
+		m_signal.wait(_lock, [this] { return IsFinished(); });
+		return m_state;
+	}
+	//----------------------------------------------------------------------------//
+	bool AsyncRequest::Cancel(void)
+	{
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			if (m_state != State::Queued)
+				return false;
+			m_state = State::Running;
+		}
+		_Finish(State::Canceled, 0, false);
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool AsyncRequest::_Start(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		if (m_state != State::Queued)
+			return false;
+		m_state = State::Running;
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncRequest::_Execute(void)
+	{
+		if (!_Start())
+			return; // canceled or executed by Wait
+
+		size_t _size = m_file->ReadAt(m_offset, m_dst, m_size);
+		_Finish(State::Done, _size, true);
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncRequest::_Finish(State _state, size_t _result, bool _direct)
+	{
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			m_result = _result;
+			m_state = _state;
+		}
+		m_signal.notify_all();
+
+		Callback _callback;
+		_callback.swap(m_callback); // callback can hold reference to request
+		if (!_callback)
+			return;
+
+		if (m_delivery == Delivery::Worker && _direct)
+		{
+			_callback(this);
+			return;
+		}
+
+		AsyncRequestPtr _self = this;
+		Context::Scope _scope(m_context);
+		if (!gThreadPool)
+			_callback(this);
+		else if (m_delivery == Delivery::Main)
+			gThreadPool->PushMain([_self, _callback]() { _callback(_self); });
+		else
+			gThreadPool->Push([_self, _callback]() { _callback(_self); }, m_priority);
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// AsyncIO
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	AsyncIO::AsyncIO(uint _queueDepth) :
+		m_context(Context::Current())
+	{
+#ifdef __linux__
+		if (_InitRing(_queueDepth))
+			m_thread = std::thread(&AsyncIO::_Thread, this);
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	AsyncIO::~AsyncIO(void)
+	{
+		_Stop();
+	}
+	//----------------------------------------------------------------------------//
+	bool AsyncIO::OnEvent(int _type, void* _arg)
+	{
+		switch (_type)
+		{
+		case SystemEvent::Shutdown:
+		{
+			_Stop();
+
+		} break;
+		}
+
+		return false;
+	}
+	//----------------------------------------------------------------------------//
+	bool AsyncIO::IsNative(void)
+	{
+#ifdef __linux__
+		return m_ring >= 0;
+#else
+		return false;
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	AsyncRequestPtr AsyncIO::ReadAsync(Stream* _file, uint64 _offset, size_t _size, void* _dst, const AsyncRequest::Callback& _callback, int _priority, AsyncRequest::Delivery _delivery)
+	{
+		ASSERT(!_size || _dst);
+		if (!_file || !_file->IsOpened() || !_file->IsPositional())
+		{
+			LOG("Error: Unable to read \"%s\" asynchronously, stream does not support ReadAt", _file ? _file->Name().c_str() : "");
+			return nullptr;
+		}
+
+		AsyncRequestPtr _request = new AsyncRequest;
+		_request->m_file = _file;
+		_request->m_offset = _offset;
+		_request->m_size = _size;
+		_request->m_dst = reinterpret_cast<uint8*>(_dst);
+		_request->m_priority = _priority;
+		_request->m_callback = _callback;
+		_request->m_delivery = _delivery;
+		_request->m_context = Context::Current();
+
+#ifdef __linux__
+		_request->m_native = IsNative() && _Descriptor(_file) >= 0;
+#endif
+
+		bool _wake = false;
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			if (m_stop)
+				return nullptr;
+
+			++m_stats.requests;
+			m_stats.bytes += _size;
+			if (_request->m_native)
+			{
+				++m_stats.native;
+				_wake = m_queue.empty(); // otherwise I/O thread was already woken or waits for free slot
+				m_queue.push({ _priority, m_order++, _request });
+			}
+		}
+
+#ifdef __linux__
+		if (_request->m_native)
+		{
+			if (_wake)
+				_Wake();
+			return _request;
+		}
+#endif
+
+		if (gThreadPool)
+			gThreadPool->Push([_request]() { _request->_Execute(); }, _priority);
+		else
+			_request->_Execute();
+
+		return _request;
+	}
+	//----------------------------------------------------------------------------//
+	AsyncIO::Stats AsyncIO::GetStats(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		return m_stats;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncIO::_Stop(void)
+	{
+		std::priority_queue<Item> _queue;
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			if (m_stop)
+				return;
+			m_stop = true;
+			_queue.swap(m_queue);
+		}
+
+		for (; !_queue.empty(); _queue.pop())
+			_queue.top().request->Cancel();
+
+#ifdef __linux__
+		if (m_thread.joinable())
+		{
+			_Wake();
+			m_thread.join();
+		}
+		_CloseRing();
+#endif
+	}
+	//----------------------------------------------------------------------------//
+#ifdef __linux__
+	//----------------------------------------------------------------------------//
+	int AsyncIO::_Descriptor(Stream* _file)
+	{
+		if (_file->IsTypeOf<BufferedStream>())
+			return _Descriptor(static_cast<BufferedStream*>(_file)->Source()); // ReadAt goes to source
+		if (_file->IsTypeOf<FileStream>())
+			return static_cast<FileStream*>(_file)->Descriptor();
+		return -1;
+	}
+	//----------------------------------------------------------------------------//
+	bool AsyncIO::_InitRing(uint _depth)
+	{
+		io_uring_params _params = {};
+		m_ring = (int)syscall(__NR_io_uring_setup, _depth + 1, &_params); // + poll of eventfd
+		if (m_ring < 0)
+		{
+			LOG("io_uring is not available (%d), files are read on worker threads", errno);
+			return false;
+		}
+
+		m_sqMapSize = _params.sq_off.array + _params.sq_entries * sizeof(uint32);
+		m_cqMapSize = _params.cq_off.cqes + _params.cq_entries * sizeof(io_uring_cqe);
+		bool _singleMap = (_params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (_singleMap)
+			m_sqMapSize = m_cqMapSize = m_sqMapSize > m_cqMapSize ? m_sqMapSize : m_cqMapSize;
+
+		m_sqMap = mmap(nullptr, m_sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+		if (m_sqMap == MAP_FAILED)
+			m_sqMap = nullptr;
+		m_cqMap = _singleMap ? m_sqMap : mmap(nullptr, m_cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_CQ_RING);
+		if (m_cqMap == MAP_FAILED)
+			m_cqMap = nullptr;
+		m_sqesSize = _params.sq_entries * sizeof(io_uring_sqe);
+		void* _sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES);
+		m_sqes = _sqes != MAP_FAILED ? reinterpret_cast<io_uring_sqe*>(_sqes) : nullptr;
+		m_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+		if (!m_sqMap || !m_cqMap || !m_sqes || m_event < 0)
+		{
+			LOG("Error: Unable to initialize io_uring (%d), files are read on worker threads", errno);
+			_CloseRing();
+			return false;
+		}
+
+		uint8* _sq = reinterpret_cast<uint8*>(m_sqMap);
+		m_sqHead = reinterpret_cast<uint32*>(_sq + _params.sq_off.head);
+		m_sqTail = reinterpret_cast<uint32*>(_sq + _params.sq_off.tail);
+		m_sqMask = *reinterpret_cast<uint32*>(_sq + _params.sq_off.ring_mask);
+		m_sqArray = reinterpret_cast<uint32*>(_sq + _params.sq_off.array);
+
+		uint8* _cq = reinterpret_cast<uint8*>(m_cqMap);
+		m_cqHead = reinterpret_cast<uint32*>(_cq + _params.cq_off.head);
+		m_cqTail = reinterpret_cast<uint32*>(_cq + _params.cq_off.tail);
+		m_cqMask = *reinterpret_cast<uint32*>(_cq + _params.cq_off.ring_mask);
+		m_cqes = _cq + _params.cq_off.cqes;
+
+		// one entry is reserved for poll of eventfd
+		m_ops.resize(_params.sq_entries - 1);
+		m_freeOps.reserve(m_ops.size());
+		for (Op& _op : m_ops)
+			m_freeOps.push_back(&_op);
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncIO::_CloseRing(void)
+	{
+		if (m_sqes)
+			munmap(m_sqes, m_sqesSize);
+		if (m_cqMap && m_cqMap != m_sqMap)
+			munmap(m_cqMap, m_cqMapSize);
+		if (m_sqMap)
+			munmap(m_sqMap, m_sqMapSize);
+		if (m_ring >= 0)
+			close(m_ring);
+		if (m_event >= 0)
+			close(m_event);
+
+		m_sqes = nullptr;
+		m_cqMap = nullptr;
+		m_sqMap = nullptr;
+		m_ring = -1;
+		m_event = -1;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncIO::_Thread(void)
+	{
+		Context::Scope _scope(m_context);
+
+		_SubmitPoll();
+		for (;;)
+		{
+			{
+				std::lock_guard<std::mutex> _lock(m_mutex);
+				if (m_stop)
+					break;
+
+				uint _reads = 0;
+				while (!m_queue.empty() && !m_freeOps.empty())
+				{
+					AsyncRequestPtr _request = m_queue.top().request;
+					m_queue.pop();
+					if (!_request->_Start())
+						continue; // canceled
+
+					Op* _op = m_freeOps.back();
+					m_freeOps.pop_back();
+					_op->request = _request;
+					_op->done = 0;
+					_SubmitRead(_op);
+					++_reads;
+				}
+				if (_reads)
+					++m_stats.batches;
+			}
+
+			_Enter(1);
+			_Reap();
+		}
+
+		// the kernel writes to buffers of requests, wait for reads in flight
+		while (m_freeOps.size() < m_ops.size())
+		{
+			_Enter(1);
+			_Reap();
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncIO::_Wake(void)
+	{
+		uint64 _value = 1;
+		if (write(m_event, &_value, sizeof(_value)) < 0 && errno != EAGAIN)
+			LOG("Error: Unable to wake I/O thread (%d)", errno);
+	}
+	//----------------------------------------------------------------------------//
+	io_uring_sqe* AsyncIO::_NextSqe(void)
+	{
+		uint32 _tail = *m_sqTail; // only this thread writes the tail
+		uint32 _index = _tail & m_sqMask;
+		io_uring_sqe* _sqe = m_sqes + _index;
+		memset(_sqe, 0, sizeof(io_uring_sqe));
+		m_sqArray[_index] = _index;
+		return _sqe;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncIO::_SubmitRead(Op* _op)
+	{
+		AsyncRequest* _request = _op->request;
+		_op->iov.iov_base = _request->m_dst + _op->done;
+		_op->iov.iov_len = _request->m_size - _op->done;
+
+		io_uring_sqe* _sqe = _NextSqe();
+		_sqe->opcode = IORING_OP_READV;
+		_sqe->fd = _Descriptor(_request->m_file);
+		_sqe->off = _request->m_offset + _op->done;
+		_sqe->addr = reinterpret_cast<uint64>(&_op->iov);
+		_sqe->len = 1;
+		_sqe->user_data = reinterpret_cast<uint64>(_op);
+
+		__atomic_store_n(m_sqTail, *m_sqTail + 1, __ATOMIC_RELEASE);
+		++m_toSubmit;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncIO::_SubmitPoll(void)
+	{
+		io_uring_sqe* _sqe = _NextSqe();
+		_sqe->opcode = IORING_OP_POLL_ADD;
+		_sqe->fd = m_event;
+		_sqe->poll_events = POLLIN;
+		_sqe->user_data = 0;
+
+		__atomic_store_n(m_sqTail, *m_sqTail + 1, __ATOMIC_RELEASE);
+		++m_toSubmit;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncIO::_Enter(uint _minComplete)
+	{
+		int _r = (int)syscall(__NR_io_uring_enter, m_ring, m_toSubmit, _minComplete, IORING_ENTER_GETEVENTS, nullptr, 0);
+		if (_r >= 0)
+			m_toSubmit -= (uint)_r;
+		else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			LOG("Error: io_uring_enter failed (%d)", errno);
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncIO::_Reap(void)
+	{
+		uint32 _head = *m_cqHead;
+		uint32 _tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+		for (; _head != _tail; ++_head)
+		{
+			const io_uring_cqe* _cqe = reinterpret_cast<const io_uring_cqe*>(m_cqes) + (_head & m_cqMask);
+			Op* _op = reinterpret_cast<Op*>(_cqe->user_data);
+			int _res = _cqe->res;
+			__atomic_store_n(m_cqHead, _head + 1, __ATOMIC_RELEASE);
+
+			if (!_op)
+			{
+				uint64 _value;
+				if (read(m_event, &_value, sizeof(_value)) < 0 && errno != EAGAIN)
+					LOG("Error: Unable to read eventfd (%d)", errno);
+				_SubmitPoll();
+				continue;
+			}
+
+			AsyncRequest* _request = _op->request;
+			if (_res == -EINTR || _res == -EAGAIN)
+			{
+				_SubmitRead(_op);
+				continue;
+			}
+			if (_res > 0)
+			{
+				_op->done += (size_t)_res;
+				if (_op->done < _request->m_size)
+				{
+					_SubmitRead(_op); // short read
+					continue;
+				}
+			}
+
+			if (_res < 0)
+				LOG("Error: Unable to read \"%s\" (%d)", _request->m_file->Name().c_str(), -_res);
+
+			AsyncRequestPtr _finished = _op->request;
+			_op->request = nullptr;
+			m_freeOps.push_back(_op);
+			_finished->_Finish(_res < 0 ? AsyncRequest::State::Failed : AsyncRequest::State::Done, _op->done, false);
+		}
+	}
+	//----------------------------------------------------------------------------//
+#endif
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// AsyncWriteStream
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	AsyncWriteStream::Writer::~Writer(void)
+	{
+		if (!finished)
+		{
+			closing = true;
+			Run();
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncWriteStream::Writer::Run(void)
+	{
+		std::unique_lock<std::mutex> _lock(mutex);
+		if (running)
+			return;
+		running = true;
+
+		for (;;)
+		{
+			if (!queue.empty())
+			{
+				Array<uint8> _chunk = std::move(queue.front());
+				queue.pop();
+				bool _write = !failed;
+
+				_lock.unlock();
+				size_t _written = _write ? file.Write(_chunk.data(), _chunk.size()) : 0;
+				_lock.lock();
+
+				if (_write && _written != _chunk.size())
+				{
+					LOG("Error: Unable to write file \"%s\"", name.c_str());
+					failed = true;
+				}
+				buffered -= _chunk.size();
+				stats.written += _written;
+				++stats.chunks;
+				_chunk.clear();
+				free.push_back(std::move(_chunk));
+				signal.notify_all();
+			}
+			else if (closing && !finished)
+			{
+				_lock.unlock();
+				bool _ok = Finish();
+				_lock.lock();
+
+				failed |= !_ok;
+				finished = true;
+				signal.notify_all();
+			}
+			else
+			{
+				active = false;
+				running = false;
+				signal.notify_all();
+				break;
+			}
+		}
+	}
+	//----------------------------------------------------------------------------//
+	bool AsyncWriteStream::Writer::Finish(void)
+	{
+		bool _ok = !failed;
+		if (_ok && atomic && !file.Sync())
+		{
+			LOG("Error: Unable to write file \"%s\"", name.c_str());
+			_ok = false;
+		}
+		file.Close();
+
+		if (atomic)
+		{
+			if (_ok)
+				_ok = FileSystem::Rename(path, name);
+			if (!_ok)
+				FileSystem::Remove(path);
+		}
+		return _ok;
+	}
+	//----------------------------------------------------------------------------//
+	AsyncWriteStream::~AsyncWriteStream(void)
+	{
+		Close();
+	}
+	//----------------------------------------------------------------------------//
+	bool AsyncWriteStream::Open(const String& _name, bool _atomic, size_t _maxBuffered, size_t _chunkSize)
+	{
+		Close();
+
+		SharedPtr<Writer> _writer = new Writer;
+		_writer->name = _name;
+		_writer->path = _atomic ? FileSystem::TempName(_name) : _name; // several writers of one file do not share temporary file
+		_writer->atomic = _atomic;
+		if (!_writer->file.Open(_writer->path, FileStream::Mode::Overwrite))
+		{
+			_writer->finished = true;
+			return false;
+		}
+
+		m_name = _name;
+		m_writer = _writer;
+		m_chunkSize = Max<size_t>(_chunkSize, 1);
+		m_maxBuffered = Max(_maxBuffered, m_chunkSize);
+		m_chunk.clear();
+		m_chunk.reserve(m_chunkSize);
+		m_size = 0;
+		m_closed = false;
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncWriteStream::Close(void)
+	{
+		if (!m_writer || m_closed)
+			return;
+
+		_Submit();
+		m_closed = true;
+		Array<uint8>().swap(m_chunk);
+
+		bool _start;
+		{
+			std::lock_guard<std::mutex> _lock(m_writer->mutex);
+			m_writer->closing = true;
+			_start = !m_writer->active;
+			m_writer->active = true;
+		}
+		if (_start)
+			_Start(m_writer);
+	}
+	//----------------------------------------------------------------------------//
+	size_t AsyncWriteStream::Write(const void* _src, size_t _size)
+	{
+		ASSERT(!_size || _src);
+		if (!IsOpened())
+			return 0;
+
+		const uint8* _ptr = reinterpret_cast<const uint8*>(_src);
+		for (size_t _left = _size; _left;)
+		{
+			size_t _n = Min(_left, m_chunkSize - m_chunk.size());
+			m_chunk.insert(m_chunk.end(), _ptr, _ptr + _n);
+			_ptr += _n;
+			_left -= _n;
+			if (m_chunk.size() == m_chunkSize)
+				_Submit();
+		}
+
+		m_size += _size;
+		std::lock_guard<std::mutex> _lock(m_writer->mutex);
+		m_writer->stats.bytes += _size;
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncWriteStream::Flush(void)
+	{
+		if (IsOpened())
+			_Submit();
+	}
+	//----------------------------------------------------------------------------//
+	bool AsyncWriteStream::Wait(void)
+	{
+		if (!m_writer)
+			return false;
+
+		Flush();
+
+		// the writing task may wait behind the calling thread in ThreadPool
+		m_writer->Run();
+
+		std::unique_lock<std::mutex> _lock(m_writer->mutex);
+		m_writer->signal.wait(_lock, [this] { return !m_writer->active; });
+		return !m_writer->failed;
+	}
+	//----------------------------------------------------------------------------//
+	bool AsyncWriteStream::IsFinished(void)
+	{
+		if (!m_writer)
+			return false;
+
+		std::lock_guard<std::mutex> _lock(m_writer->mutex);
+		return m_writer->finished;
+	}
+	//----------------------------------------------------------------------------//
+	AsyncWriteStream::Stats AsyncWriteStream::GetStats(void)
+	{
+		if (!m_writer)
+			return Stats();
+
+		std::lock_guard<std::mutex> _lock(m_writer->mutex);
+		return m_writer->stats;
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncWriteStream::_Submit(void)
+	{
+		if (m_chunk.empty())
+			return;
+
+		Writer* _w = m_writer;
+		Array<uint8> _next;
+		bool _start;
+		{
+			std::unique_lock<std::mutex> _lock(_w->mutex);
+			if (_w->buffered && _w->buffered + m_chunk.size() > m_maxBuffered)
+			{
+				// back-pressure: the writer is behind
+				auto _t = std::chrono::steady_clock::now();
+				if (!_w->running)
+				{
+					// the writing task did not start (workers are busy), write here
+					_lock.unlock();
+					_w->Run();
+					_lock.lock();
+				}
+				_w->signal.wait(_lock, [this, _w] { return !_w->buffered || _w->buffered + m_chunk.size() <= m_maxBuffered; });
+				++_w->stats.stalls;
+				_w->stats.stallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - _t).count();
+			}
+
+			_w->buffered += m_chunk.size();
+			_w->stats.peakBuffered = Max(_w->stats.peakBuffered, _w->buffered);
+			_w->queue.push(std::move(m_chunk));
+			if (!_w->free.empty())
+			{
+				_next = std::move(_w->free.back());
+				_w->free.pop_back();
+			}
+			_start = !_w->active;
+			_w->active = true;
+		}
+
+		m_chunk = std::move(_next);
+		m_chunk.reserve(m_chunkSize);
+		if (_start)
+			_Start(_w);
+	}
+	//----------------------------------------------------------------------------//
+	void AsyncWriteStream::_Start(Writer* _writer)
+	{
+		SharedPtr<Writer> _ref = _writer;
+		if (gThreadPool)
+			gThreadPool->Push([_ref]() { _ref->Run(); });
+		else
+			_writer->Run();
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// Prefetcher
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	Prefetcher::Prefetcher(const String& _manifest, float _recordTime) :
+		m_manifest(_manifest),
+		m_recordTime(_recordTime),
+		m_start(std::chrono::steady_clock::now()),
+		m_recording(_recordTime > 0 && Context::Current() == Context::Default()) // contexts would overwrite manifest of each other
+	{
+		FileInfo _info;
+		if (FileSystem::Stat(m_manifest, _info) && Load(m_manifest, m_replay) && !m_replay.empty())
+		{
+			for (uint i = 0; i < (uint)m_replay.size(); ++i)
+				m_replayIndex.insert({ _Key(m_replay[i].path, m_replay[i].offset), i });
+
+			m_thread = std::thread(&Prefetcher::_Thread, this);
+		}
+	}
+	//----------------------------------------------------------------------------//
+	Prefetcher::~Prefetcher(void)
+	{
+		_Stop();
+	}
+	//----------------------------------------------------------------------------//
+	bool Prefetcher::OnEvent(int _type, void* _arg)
+	{
+		switch (_type)
+		{
+		case SystemEvent::BeginFrame:
+		{
+			if (m_recording && std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count() >= m_recordTime)
+				StopRecording();
+
+		} break;
+
+		case SystemEvent::Shutdown:
+		{
+			StopRecording();
+			_Stop();
+
+		} break;
+		}
+
+		return false;
+	}
+	//----------------------------------------------------------------------------//
+	void Prefetcher::OnOpen(const String& _path, uint64 _offset, uint64 _size)
+	{
+		if (!m_recording)
+			return;
+
+		String _key = _Key(_path, _offset);
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		if (!m_recording || !m_recorded.insert({ _key, (uint)m_record.size() }).second)
+			return; // count first open only
+
+		m_record.push_back({ _path, _offset, _size });
+		++m_stats.recorded;
+
+		if (m_replay.empty())
+			return;
+
+		auto _it = m_replayIndex.find(_key);
+		if (_it == m_replayIndex.end())
+			++m_stats.misses;
+		else if (_it->second < m_progress)
+			++m_stats.hits;
+		else
+			++m_stats.late;
+	}
+	//----------------------------------------------------------------------------//
+	void Prefetcher::StopRecording(void)
+	{
+		Array<Range> _record;
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			if (!m_recording)
+				return;
+			m_recording = false;
+			_record.swap(m_record);
+			m_recorded.clear();
+		}
+
+		Save(m_manifest, _record);
+
+		Stats _stats = GetStats();
+		LOG("Prefetch: %u hits, %u late, %u misses; %u of %u ranges prefetched (%u KB), %u recorded", _stats.hits, _stats.late, _stats.misses,
+			_stats.replayed, (uint)m_replay.size(), (uint)(_stats.bytes >> 10), _stats.recorded);
+	}
+	//----------------------------------------------------------------------------//
+	Prefetcher::Stats Prefetcher::GetStats(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		Stats _stats = m_stats;
+		_stats.replayed = m_progress;
+		_stats.bytes = m_bytes;
+		return _stats;
+	}
+	//----------------------------------------------------------------------------//
+	bool Prefetcher::Load(const String& _path, Array<Range>& _ranges)
+	{
+		FileStream _file;
+		if (!_file.Open(_path, FileStream::Mode::ReadOnly))
+			return false;
+
+		String _text;
+		_text.resize((size_t)_file.Size());
+		_text.resize(_file.Read(&_text[0], _text.size()));
+
+		// "offset size path" per line
+		for (size_t _pos = 0, _end; _pos < _text.size(); _pos = _end + 1)
+		{
+			_end = _text.find('\n', _pos);
+			if (_end == String::npos)
+				_end = _text.size();
+
+			unsigned long long _offset, _size;
+			int _name = 0;
+			if (sscanf(_text.c_str() + _pos, "%llu %llu %n", &_offset, &_size, &_name) == 2 && _name > 0 && _pos + _name < _end)
+				_ranges.push_back({ _text.substr(_pos + _name, _end - _pos - _name), _offset, _size });
+		}
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool Prefetcher::Save(const String& _path, const Array<Range>& _ranges)
+	{
+		AsyncWriteStreamPtr _file = new AsyncWriteStream;
+		if (!_file->Open(_path, true))
+			return false;
+
+		for (const Range& _range : _ranges)
+		{
+			String _line = StringUtils::Format("%llu %llu %s\n", (unsigned long long)_range.offset, (unsigned long long)_range.size, _range.path.c_str());
+			_file->Write(_line.c_str(), _line.length());
+		}
+		_file->Close();
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	String Prefetcher::_Key(const String& _path, uint64 _offset)
+	{
+		return StringUtils::Format("%llu:", (unsigned long long)_offset) + FileSystem::IndexKey(_path);
+	}
+	//----------------------------------------------------------------------------//
+	void Prefetcher::_Thread(void)
+	{
+		Array<uint8> _buffer(ChunkSize);
+		FileStreamPtr _file;
+		String _path;
+
+		for (uint i = 0; i < (uint)m_replay.size() && !m_stop; ++i)
+		{
+			const Range& _range = m_replay[i];
+			if (_path != _range.path)
+			{
+				FileInfo _info;
+				_path = _range.path;
+				_file = new FileStream;
+				if (!FileSystem::Stat(_path, _info) || !_file->Open(_path, FileStream::Mode::ReadOnly))
+					_file = nullptr; // file was deleted since recording
+			}
+
+			if (_file)
+			{
+				// hint for the whole range, then read it to be sure it is in cache before we go further
+				_file->Prefetch(_range.offset, _range.size);
+				uint64 _end = Min(_range.offset + _range.size, _file->Size());
+				for (uint64 _pos = _range.offset; _pos < _end && !m_stop;)
+				{
+					size_t _read = _file->ReadAt(_pos, _buffer.data(), (size_t)Min<uint64>(ChunkSize, _end - _pos));
+					if (!_read)
+						break;
+					_pos += _read;
+					m_bytes += _read;
+				}
+			}
+
+			m_progress = i + 1;
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void Prefetcher::_Stop(void)
+	{
+		m_stop = true;
+		if (m_thread.joinable())
+			m_thread.join();
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
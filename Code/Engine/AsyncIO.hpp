@@ -0,0 +1,433 @@
+#pragma once
+
+#include "File.hpp"
+#include "Thread.hpp"
+#include <chrono>
+#ifdef __linux__
+#include <sys/uio.h>
+#endif
+
+struct io_uring_sqe;
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// AsyncRequest
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class AsyncRequest> AsyncRequestPtr;
+
+	//! Asynchronous read of stream. Created by AsyncIO::ReadAsync.
+	class AsyncRequest : public RefCounted
+	{
+	public:
+		//!
+		enum class State
+		{
+			Queued,
+			Running,
+			Done, //!< data was read; Result() is less than Size() if end of file was reached
+			Failed,
+			Canceled,
+		};
+
+		//! Where callback is called
+		enum class Delivery
+		{
+			Worker, //!< on worker thread of ThreadPool
+			Main, //!< on main thread at the beginning of frame (ThreadPool::ExecuteMain)
+		};
+
+		//!
+		typedef std::function<void(AsyncRequest*)> Callback;
+
+		//!
+		State GetState(void) { return m_state; }
+		//! \return true if request is done, failed or canceled
+		bool IsFinished(void) { return m_state >= State::Done; }
+		//! \return number of bytes read
+		size_t Result(void) { return m_result; }
+
+		//!
+		Stream* File(void) { return m_file; }
+		//!
+		uint64 Offset(void) { return m_offset; }
+		//!
+		size_t Size(void) { return m_size; }
+		//!
+		void* Dst(void) { return m_dst; }
+		//!
+		int Priority(void) { return m_priority; }
+
+		//! Wait for the end of read. Callback with Delivery::Main is called later, at the beginning of frame.
+		State Wait(void);
+		//! Cancel request which was not started yet. Callback is called with State::Canceled.
+		//! \return false if request is running or finished
+		bool Cancel(void);
+
+	protected:
+		friend class AsyncIO;
+
+		//! Change state from Queued to Running. \return false if request was canceled
+		bool _Start(void);
+		//! Read with Stream::ReadAt in calling thread
+		void _Execute(void);
+		//! Set result, wake waiting threads and deliver callback
+		/*!	\param _direct call callback with Delivery::Worker in this thread */
+		void _Finish(State _state, size_t _result, bool _direct);
+
+		std::mutex m_mutex;
+		std::condition_variable m_signal;
+		std::atomic<State> m_state = { State::Queued };
+		size_t m_result = 0;
+		bool m_native = false; //!< submitted to io_uring
+
+		StreamPtr m_file;
+		uint64 m_offset = 0;
+		size_t m_size = 0;
+		uint8* m_dst = nullptr;
+		int m_priority = 0;
+		Callback m_callback;
+		Delivery m_delivery = Delivery::Main;
+		Context* m_context = nullptr;
+	};
+
+	//----------------------------------------------------------------------------//
+	// AsyncIO
+	//----------------------------------------------------------------------------//
+
+#define gAsyncIO AsyncIO::Get()
+
+	//! Asynchronous reading of files.
+	/*!	On Linux reads of FileStream are batched and submitted to io_uring by I/O thread, so many small files do not occupy
+		a thread per read. Other streams, or all streams if io_uring is not available, are read with ReadAt on workers of ThreadPool.
+		Requests with higher priority are started first. Destination buffer and stream must stay valid until the request is finished.
+	*/
+	class AsyncIO : public Module<AsyncIO>
+	{
+	public:
+		enum : uint
+		{
+			DefaultQueueDepth = 64, //!< max number of reads submitted to io_uring at once
+		};
+
+		//!
+		struct Stats
+		{
+			uint64 requests = 0;
+			uint64 bytes = 0; //!< requested bytes
+			uint64 native = 0; //!< requests read through io_uring
+			uint64 batches = 0; //!< calls of io_uring_enter that submitted reads
+		};
+
+		//!
+		AsyncIO(uint _queueDepth = DefaultQueueDepth);
+		//!
+		~AsyncIO(void);
+
+		//!
+		bool OnEvent(int _type, void* _arg) override;
+
+		//! \return true if io_uring is used
+		bool IsNative(void);
+
+		//! Read _size bytes at _offset of _file to _dst.
+		/*!	\param _callback is called once with finished request (also when it was canceled)
+			\return request; nullptr if _file is not readable at offset
+		*/
+		AsyncRequestPtr ReadAsync(Stream* _file, uint64 _offset, size_t _size, void* _dst, const AsyncRequest::Callback& _callback = nullptr, int _priority = ThreadPool::Normal, AsyncRequest::Delivery _delivery = AsyncRequest::Delivery::Main);
+
+		//!
+		Stats GetStats(void);
+
+	protected:
+		//!
+		struct Item
+		{
+			int priority;
+			uint64 order;
+			AsyncRequestPtr request;
+
+			bool operator < (const Item& _rhs) const { return priority < _rhs.priority || (priority == _rhs.priority && order > _rhs.order); }
+		};
+
+		//! Cancel queued requests and stop I/O thread
+		void _Stop(void);
+
+		Context* m_context;
+		std::mutex m_mutex;
+		std::priority_queue<Item> m_queue; //!< requests for io_uring
+		uint64 m_order = 0;
+		Stats m_stats;
+		bool m_stop = false;
+
+#ifdef __linux__
+		//! Read submitted to io_uring
+		struct Op
+		{
+			AsyncRequestPtr request;
+			iovec iov;
+			size_t done; //!< bytes read
+		};
+
+		//! \return file descriptor for io_uring or -1
+		static int _Descriptor(Stream* _file);
+
+		//!
+		bool _InitRing(uint _depth);
+		//!
+		void _CloseRing(void);
+		//!
+		void _Thread(void);
+		//! Wake I/O thread
+		void _Wake(void);
+		//! \return next free entry of submission queue
+		io_uring_sqe* _NextSqe(void);
+		//! Submit read of the rest of request
+		void _SubmitRead(Op* _op);
+		//! Submit poll of eventfd (wake up)
+		void _SubmitPoll(void);
+		//! Submit queued entries and wait for _minComplete completions
+		void _Enter(uint _minComplete);
+		//! Process completions
+		void _Reap(void);
+
+		int m_ring = -1;
+		int m_event = -1; //!< eventfd to wake I/O thread
+		void* m_sqMap = nullptr;
+		size_t m_sqMapSize = 0;
+		void* m_cqMap = nullptr;
+		size_t m_cqMapSize = 0;
+		io_uring_sqe* m_sqes = nullptr;
+		size_t m_sqesSize = 0;
+		uint32* m_sqHead = nullptr;
+		uint32* m_sqTail = nullptr;
+		uint32 m_sqMask = 0;
+		uint32* m_sqArray = nullptr;
+		uint32* m_cqHead = nullptr;
+		uint32* m_cqTail = nullptr;
+		uint32 m_cqMask = 0;
+		uint8* m_cqes = nullptr;
+		uint m_toSubmit = 0;
+
+		Array<Op> m_ops;
+		Array<Op*> m_freeOps;
+		std::thread m_thread;
+#endif
+	};
+
+	//----------------------------------------------------------------------------//
+	// AsyncWriteStream
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class AsyncWriteStream> AsyncWriteStreamPtr;
+
+	//! Write-only file stream which writes in background.
+	/*!	Write copies data to chunks which are written to file by task of ThreadPool (or immediately if there is no ThreadPool).
+		Memory is bounded: if the writer falls behind by MaxBuffered bytes, Write waits for it (back-pressure).
+		With atomic replace the data is written to "<name>.tmp", which is synced and renamed to the name on Close,
+		so the old file stays intact until the new one is complete.
+	*/
+	class AsyncWriteStream : public Stream
+	{
+	public:
+		RTTI("AsyncWriteStream");
+
+		enum : size_t
+		{
+			DefaultChunkSize = 64 * 1024,
+			DefaultMaxBuffered = 4 * 1024 * 1024,
+		};
+
+		//!
+		struct Stats
+		{
+			uint64 bytes = 0; //!< bytes accepted by Write
+			uint64 written = 0; //!< bytes written to file
+			uint64 chunks = 0; //!< number of written chunks
+			uint64 stalls = 0; //!< number of times Write waited for writer
+			double stallTime = 0; //!< time spent in waiting, in seconds
+			size_t peakBuffered = 0; //!< max number of bytes queued for writing
+		};
+
+		//!
+		AsyncWriteStream(void) = default;
+		//! Close stream. The rest of data is written in background.
+		~AsyncWriteStream(void);
+
+		//!	Create file
+		/*!	\param _atomic write to temporary file and replace file _name on Close
+			\param _maxBuffered max number of bytes queued for writing
+		*/
+		bool Open(const String& _name, bool _atomic = false, size_t _maxBuffered = DefaultMaxBuffered, size_t _chunkSize = DefaultChunkSize);
+
+		//!
+		const String& Name(void) override { return m_name; }
+
+		//!
+		bool IsOpened(void) override { return m_writer && !m_closed; }
+		//! Queue the rest of data and finish file in background. Does not wait; see Wait.
+		void Close(void) override;
+
+		//! \return number of written bytes
+		uint64 Size(void) override { return m_size; }
+		//!
+		bool EoF(void) override { return true; }
+		//! Not supported
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override { }
+		//!
+		uint64 Tell(void) override { return m_size; }
+
+		//!
+		bool IsReadOnly(void) override { return false; }
+		//!
+		size_t Read(void* _dst, size_t _size) override { return 0; }
+		//!
+		size_t Write(const void* _src, size_t _size) override;
+		//! Queue partially filled chunk for writing. Does not wait.
+		void Flush(void) override;
+
+		//! Wait until queued data is written (and file is finished if stream was closed).
+		//! \return false if writing failed
+		bool Wait(void);
+		//! \return true if stream was closed and file is finished
+		bool IsFinished(void);
+		//!
+		Stats GetStats(void);
+
+	protected:
+		//! State shared with writing task, so stream can be destroyed before its data was written
+		struct Writer : public RefCounted
+		{
+			std::mutex mutex;
+			std::condition_variable signal;
+			std::queue<Array<uint8>> queue;
+			Array<Array<uint8>> free; //!< written chunks for reuse
+			size_t buffered = 0; //!< bytes in queue
+			bool active = false; //!< writing task is queued or running
+			bool running = false; //!< chunks are being written by some thread
+			bool closing = false; //!< finish file after the last chunk
+			bool finished = false;
+			bool failed = false;
+			Stats stats;
+
+			FileStream file;
+			String name;
+			String path; //!< temporary file for atomic replace
+			bool atomic = false;
+
+			//! Finish the work if the task was dropped (ThreadPool was stopped)
+			~Writer(void);
+			//! Write queued chunks and finish file if stream was closed. Does nothing if other thread is writing.
+			void Run(void);
+			//! Close (sync and rename) file. \return false on failure
+			bool Finish(void);
+		};
+
+		//! Queue current chunk and start writer if needed
+		void _Submit(void);
+		//!
+		void _Start(Writer* _writer);
+
+		String m_name;
+		SharedPtr<Writer> m_writer;
+		Array<uint8> m_chunk;
+		size_t m_chunkSize = DefaultChunkSize;
+		size_t m_maxBuffered = DefaultMaxBuffered;
+		uint64 m_size = 0;
+		bool m_closed = false;
+	};
+
+	//----------------------------------------------------------------------------//
+	// Prefetcher
+	//----------------------------------------------------------------------------//
+
+#define gPrefetcher Prefetcher::Get()
+
+	//! Record-and-replay prefetching of files read at startup.
+	/*!	During the first seconds of session every file opened by FileSystem::OpenFile for reading is recorded in order of opening
+		(path and range of data; files in packages record their range in package). At the end of recording the list is saved to manifest.
+		On next start the manifest is replayed by background thread in the same order: data is read ahead of the main thread,
+		so the page cache is warm when files are opened. Opens of prefetched data are counted as hits, the others as misses.
+		Only prefetcher of default context records and writes the manifest; prefetchers of other contexts replay it.
+	*/
+	class Prefetcher : public Module<Prefetcher>
+	{
+	public:
+		enum : size_t
+		{
+			ChunkSize = 256 * 1024, //!< size of one read of replay
+		};
+
+		//!
+		struct Range
+		{
+			String path;
+			uint64 offset;
+			uint64 size;
+		};
+
+		//!
+		struct Stats
+		{
+			uint recorded = 0; //!< number of recorded ranges
+			uint replayed = 0; //!< number of prefetched ranges
+			uint64 bytes = 0; //!< prefetched bytes
+			uint hits = 0; //!< opens of prefetched ranges
+			uint late = 0; //!< opens of ranges which were in manifest but not prefetched yet
+			uint misses = 0; //!< opens of ranges which were not in manifest
+		};
+
+		//! Load manifest of previous session and start its replay
+		/*!	\param _recordTime length of startup window in seconds, when files are recorded and hits are counted; 0 disables recording.
+			Ignored outside of default context. */
+		Prefetcher(const String& _manifest = "Prefetch.txt", float _recordTime = 10);
+		//!
+		~Prefetcher(void);
+
+		//!
+		bool OnEvent(int _type, void* _arg) override;
+
+		//! Called by FileSystem when file is opened for reading
+		void OnOpen(const String& _path, uint64 _offset, uint64 _size);
+		//! Stop recording and save manifest
+		void StopRecording(void);
+		//!
+		bool IsRecording(void) { return m_recording; }
+		//!
+		Stats GetStats(void);
+
+		//! Read manifest
+		static bool Load(const String& _path, Array<Range>& _ranges);
+		//! Write manifest (atomically, in background)
+		static bool Save(const String& _path, const Array<Range>& _ranges);
+
+	protected:
+		//! Key of range
+		static String _Key(const String& _path, uint64 _offset);
+		//! Read ranges in order
+		void _Thread(void);
+		//! Stop replay
+		void _Stop(void);
+
+		String m_manifest;
+		double m_recordTime;
+		std::chrono::steady_clock::time_point m_start;
+		std::atomic<bool> m_recording = { false };
+
+		std::mutex m_mutex;
+		Array<Range> m_record;
+		HashMap<String, uint> m_recorded; //!< key -> index in m_record
+		Array<Range> m_replay;
+		HashMap<String, uint> m_replayIndex; //!< key -> index in m_replay
+		std::atomic<uint> m_progress = { 0 }; //!< number of prefetched ranges
+		std::atomic<uint64> m_bytes = { 0 };
+		std::atomic<bool> m_stop = { false };
+		std::thread m_thread;
+		Stats m_stats;
+	};
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
@@ -41,6 +41,213 @@ namespace Easy2D
 	}
 	//----------------------------------------------------------------------------//
 
+	//----------------------------------------------------------------------------//
+	// Checksum
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	uint32 Checksum::Crc32(const void* _data, size_t _size, uint32 _crc)
+	{
+		static const struct Table
+		{
+			Table(void)
+			{
+				for (uint32 i = 0; i < 256; ++i)
+				{
+					uint32 _c = i;
+					for (uint j = 0; j < 8; ++j)
+						_c = (_c & 1) ? (0xedb88320 ^ (_c >> 1)) : (_c >> 1);
+					v[i] = _c;
+				}
+			}
+			uint32 v[256];
+		} _table;
+
+		const uint8* _p = reinterpret_cast<const uint8*>(_data);
+		_crc = ~_crc;
+		while (_size--)
+			_crc = _table.v[(_crc ^ *_p++) & 0xff] ^ (_crc >> 8);
+		return ~_crc;
+	}
+	//----------------------------------------------------------------------------//
+	uint32 Checksum::Fnv1a(const void* _data, size_t _size, uint32 _hash)
+	{
+		const uint8* _p = reinterpret_cast<const uint8*>(_data);
+		while (_size--)
+			_hash = (_hash ^ *_p++) * 0x01000193;
+		return _hash;
+	}
+	//----------------------------------------------------------------------------//
+	uint32 Checksum::XxHash32(const void* _data, size_t _size, uint32 _seed)
+	{
+		Easy2D::XxHash32 _hash(_seed);
+		_hash.Update(_data, _size);
+		return _hash.Digest();
+	}
+	//----------------------------------------------------------------------------//
+	uint64 Checksum::XxHash64(const void* _data, size_t _size, uint64 _seed)
+	{
+		Easy2D::XxHash64 _hash(_seed);
+		_hash.Update(_data, _size);
+		return _hash.Digest();
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// XxHash32
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	void XxHash32::Reset(uint32 _seed)
+	{
+		m_seed = _seed;
+		m_acc[0] = _seed + Prime1 + Prime2;
+		m_acc[1] = _seed + Prime2;
+		m_acc[2] = _seed;
+		m_acc[3] = _seed - Prime1;
+		m_total = 0;
+		m_buffSize = 0;
+	}
+	//----------------------------------------------------------------------------//
+	void XxHash32::Update(const void* _data, size_t _size)
+	{
+		const uint8* _p = reinterpret_cast<const uint8*>(_data);
+		const uint8* _end = _p + _size;
+		m_total += _size;
+
+		if (m_buffSize)
+		{
+			uint _n = (uint)(_size < 16 - m_buffSize ? _size : 16 - m_buffSize);
+			memcpy(m_buff + m_buffSize, _p, _n);
+			m_buffSize += _n;
+			_p += _n;
+			if (m_buffSize < 16)
+				return;
+
+			for (uint i = 0; i < 4; ++i)
+				m_acc[i] = _Round(m_acc[i], _Read32(m_buff + i * 4));
+			m_buffSize = 0;
+		}
+
+		for (; _end - _p >= 16; _p += 16)
+		{
+			m_acc[0] = _Round(m_acc[0], _Read32(_p));
+			m_acc[1] = _Round(m_acc[1], _Read32(_p + 4));
+			m_acc[2] = _Round(m_acc[2], _Read32(_p + 8));
+			m_acc[3] = _Round(m_acc[3], _Read32(_p + 12));
+		}
+
+		m_buffSize = (uint)(_end - _p);
+		memcpy(m_buff, _p, m_buffSize);
+	}
+	//----------------------------------------------------------------------------//
+	uint32 XxHash32::Digest(void) const
+	{
+		uint32 _h;
+		if (m_total >= 16)
+			_h = _Rotl(m_acc[0], 1) + _Rotl(m_acc[1], 7) + _Rotl(m_acc[2], 12) + _Rotl(m_acc[3], 18);
+		else
+			_h = m_seed + Prime5;
+		_h += (uint32)m_total;
+
+		const uint8* _p = m_buff;
+		const uint8* _end = m_buff + m_buffSize;
+		for (; _end - _p >= 4; _p += 4)
+			_h = _Rotl(_h + _Read32(_p) * Prime3, 17) * Prime4;
+		for (; _p < _end; ++_p)
+			_h = _Rotl(_h + *_p * Prime5, 11) * Prime1;
+
+		_h ^= _h >> 15;
+		_h *= Prime2;
+		_h ^= _h >> 13;
+		_h *= Prime3;
+		_h ^= _h >> 16;
+		return _h;
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// XxHash64
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	void XxHash64::Reset(uint64 _seed)
+	{
+		m_seed = _seed;
+		m_acc[0] = _seed + Prime1 + Prime2;
+		m_acc[1] = _seed + Prime2;
+		m_acc[2] = _seed;
+		m_acc[3] = _seed - Prime1;
+		m_total = 0;
+		m_buffSize = 0;
+	}
+	//----------------------------------------------------------------------------//
+	void XxHash64::Update(const void* _data, size_t _size)
+	{
+		const uint8* _p = reinterpret_cast<const uint8*>(_data);
+		const uint8* _end = _p + _size;
+		m_total += _size;
+
+		if (m_buffSize)
+		{
+			uint _n = (uint)(_size < 32 - m_buffSize ? _size : 32 - m_buffSize);
+			memcpy(m_buff + m_buffSize, _p, _n);
+			m_buffSize += _n;
+			_p += _n;
+			if (m_buffSize < 32)
+				return;
+
+			for (uint i = 0; i < 4; ++i)
+				m_acc[i] = _Round(m_acc[i], _Read64(m_buff + i * 8));
+			m_buffSize = 0;
+		}
+
+		for (; _end - _p >= 32; _p += 32)
+		{
+			m_acc[0] = _Round(m_acc[0], _Read64(_p));
+			m_acc[1] = _Round(m_acc[1], _Read64(_p + 8));
+			m_acc[2] = _Round(m_acc[2], _Read64(_p + 16));
+			m_acc[3] = _Round(m_acc[3], _Read64(_p + 24));
+		}
+
+		m_buffSize = (uint)(_end - _p);
+		memcpy(m_buff, _p, m_buffSize);
+	}
+	//----------------------------------------------------------------------------//
+	uint64 XxHash64::Digest(void) const
+	{
+		uint64 _h;
+		if (m_total >= 32)
+		{
+			_h = _Rotl(m_acc[0], 1) + _Rotl(m_acc[1], 7) + _Rotl(m_acc[2], 12) + _Rotl(m_acc[3], 18);
+			for (uint i = 0; i < 4; ++i)
+				_h = _Merge(_h, m_acc[i]);
+		}
+		else
+			_h = m_seed + Prime5;
+		_h += m_total;
+
+		const uint8* _p = m_buff;
+		const uint8* _end = m_buff + m_buffSize;
+		for (; _end - _p >= 8; _p += 8)
+			_h = _Rotl(_h ^ _Round(0, _Read64(_p)), 27) * Prime1 + Prime4;
+		if (_end - _p >= 4)
+		{
+			_h = _Rotl(_h ^ (_Read32(_p) * Prime1), 23) * Prime2 + Prime3;
+			_p += 4;
+		}
+		for (; _p < _end; ++_p)
+			_h = _Rotl(_h ^ (*_p * Prime5), 11) * Prime1;
+
+		_h ^= _h >> 33;
+		_h *= Prime2;
+		_h ^= _h >> 29;
+		_h *= Prime3;
+		_h ^= _h >> 32;
+		return _h;
+	}
+	//----------------------------------------------------------------------------//
+
 	//----------------------------------------------------------------------------//
 	//
 	//----------------------------------------------------------------------------//
@@ -14,6 +14,7 @@
 #include <list>
 #include <unordered_map>
 #include <algorithm>
+#include <atomic>
 
 //----------------------------------------------------------------------------//
 // Debug
@@ -28,6 +29,15 @@
 
 #define CHECK(...) ASSERT(##__VA_ARGS__)
 
+//! Development features (hot reload, recording of prefetch manifest). Enabled in debug builds; define E2D_DEVELOPMENT=1 to enable them in release.
+#ifndef E2D_DEVELOPMENT
+#	ifdef _DEBUG
+#		define E2D_DEVELOPMENT 1
+#	else
+#		define E2D_DEVELOPMENT 0
+#	endif
+#endif
+
 #define LOG(msg, ...) {printf(msg, ##__VA_ARGS__); printf("\n");}
 
 namespace Easy2D
@@ -106,6 +116,100 @@ namespace Easy2D
 		static const String EmptyString;
 	};
 
+	//----------------------------------------------------------------------------//
+	// Checksum
+	//----------------------------------------------------------------------------//
+
+	struct Checksum
+	{
+		//!\return CRC-32 (IEEE 802.3)
+		static uint32 Crc32(const void* _data, size_t _size, uint32 _crc = 0);
+		//!\return FNV-1a 32 bit hash
+		static uint32 Fnv1a(const void* _data, size_t _size, uint32 _hash = 0x811c9dc5);
+		//!\return xxHash 32 bit hash
+		static uint32 XxHash32(const void* _data, size_t _size, uint32 _seed = 0);
+		//!\return xxHash 64 bit hash
+		static uint64 XxHash64(const void* _data, size_t _size, uint64 _seed = 0);
+	};
+
+	//! Incremental xxHash32 (checksum of LZ4 frames)
+	class XxHash32
+	{
+	public:
+		//!
+		XxHash32(uint32 _seed = 0) { Reset(_seed); }
+		//!
+		void Reset(uint32 _seed = 0);
+		//!
+		void Update(const void* _data, size_t _size);
+		//!
+		uint32 Digest(void) const;
+
+	protected:
+		enum : uint32
+		{
+			Prime1 = 0x9E3779B1u,
+			Prime2 = 0x85EBCA77u,
+			Prime3 = 0xC2B2AE3Du,
+			Prime4 = 0x27D4EB2Fu,
+			Prime5 = 0x165667B1u,
+		};
+
+		//!
+		static uint32 _Rotl(uint32 _x, int _r) { return (_x << _r) | (_x >> (32 - _r)); }
+		//!
+		static uint32 _Read32(const uint8* _p) { return _p[0] | (_p[1] << 8) | (_p[2] << 16) | ((uint32)_p[3] << 24); }
+		//!
+		static uint32 _Round(uint32 _acc, uint32 _input) { return _Rotl(_acc + _input * Prime2, 13) * Prime1; }
+
+		uint32 m_acc[4];
+		uint32 m_seed;
+		uint64 m_total;
+		uint8 m_buff[16];
+		uint m_buffSize;
+	};
+
+	//! Incremental xxHash64 (content keys of derived data)
+	class XxHash64
+	{
+	public:
+		//!
+		XxHash64(uint64 _seed = 0) { Reset(_seed); }
+		//!
+		void Reset(uint64 _seed = 0);
+		//!
+		void Update(const void* _data, size_t _size);
+		//!
+		uint64 Digest(void) const;
+
+	protected:
+		enum : uint64
+		{
+			Prime1 = 0x9E3779B185EBCA87ull,
+			Prime2 = 0xC2B2AE3D27D4EB4Full,
+			Prime3 = 0x165667B19E3779F9ull,
+			Prime4 = 0x85EBCA77C2B2AE63ull,
+			Prime5 = 0x27D4EB2F165667C5ull,
+		};
+
+		//!
+		static uint64 _Rotl(uint64 _x, int _r) { return (_x << _r) | (_x >> (64 - _r)); }
+		//!
+		static uint32 _Read32(const uint8* _p) { return _p[0] | (_p[1] << 8) | (_p[2] << 16) | ((uint32)_p[3] << 24); }
+		//!
+		static uint64 _Read64(const uint8* _p) { return _Read32(_p) | ((uint64)_Read32(_p + 4) << 32); }
+		//!
+		static uint64 _Round(uint64 _acc, uint64 _input) { return _Rotl(_acc + _input * Prime2, 31) * Prime1; }
+		//!
+		static uint64 _Merge(uint64 _acc, uint64 _val) { return (_acc ^ _Round(0, _val)) * Prime1 + Prime4; }
+
+		uint64 m_acc[4];
+		uint64 m_seed;
+		uint64 m_total;
+		uint8 m_buff[32];
+		uint m_buffSize;
+	};
+
 	//----------------------------------------------------------------------------//
 	// NonCopyable
 	//----------------------------------------------------------------------------//
@@ -0,0 +1,804 @@
+#include "Compression.hpp"
+#include "Thread.hpp"
+#include "Math.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// Lz4
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	size_t Lz4::_Count(const uint8* _a, const uint8* _b, const uint8* _aEnd)
+	{
+		const uint8* _start = _a;
+		while (_a + 8 <= _aEnd)
+		{
+			uint64 _diff = _Read64(_a) ^ _Read64(_b);
+			if (_diff)
+			{
+#ifdef _MSC_VER
+				unsigned long _bit;
+				_BitScanForward64(&_bit, _diff);
+				return (size_t)(_a - _start) + (_bit >> 3);
+#else
+				return (size_t)(_a - _start) + (__builtin_ctzll(_diff) >> 3);
+#endif
+			}
+			_a += 8;
+			_b += 8;
+		}
+		while (_a < _aEnd && *_a == *_b)
+			++_a, ++_b;
+		return (size_t)(_a - _start);
+	}
+	//----------------------------------------------------------------------------//
+	size_t Lz4::CompressBlock(const void* _src, size_t _srcSize, void* _dst, size_t _dstCapacity)
+	{
+		ASSERT(_srcSize <= MaxInputSize);
+
+		const uint8* const _base = reinterpret_cast<const uint8*>(_src);
+		const uint8* const _end = _base + _srcSize;
+		const uint8* _ip = _base;
+		const uint8* _anchor = _base;
+		uint8* const _dstStart = reinterpret_cast<uint8*>(_dst);
+		uint8* const _dstEnd = _dstStart + _dstCapacity;
+		uint8* _op = _dstStart;
+
+		if (_srcSize > MatchLimit)
+		{
+			const uint8* const _matchStartLimit = _end - MatchLimit + 1; // match cannot start after this
+			const uint8* const _matchEndLimit = _end - LastLiterals;
+			uint32 _table[1 << HashLog] = { 0 }; // offsets from _base
+
+			_table[_Hash(_Read32(_ip))] = 0;
+			uint32 _forwardHash = _Hash(_Read32(++_ip));
+
+			for (;;)
+			{
+				// find match; step grows on incompressible data
+				const uint8* _match;
+				const uint8* _forward = _ip;
+				uint _attempts = 1 << 6;
+				do
+				{
+					uint32 _h = _forwardHash;
+					_ip = _forward;
+					_forward += _attempts++ >> 6;
+					if (_forward > _matchStartLimit)
+						goto LastLiterals;
+
+					_match = _base + _table[_h];
+					_forwardHash = _Hash(_Read32(_forward));
+					_table[_h] = (uint32)(_ip - _base);
+
+				} while (_match + MaxDistance < _ip || _Read32(_match) != _Read32(_ip));
+
+				// extend backward
+				while (_ip > _anchor && _match > _base && _ip[-1] == _match[-1])
+					--_ip, --_match;
+
+				// literals
+				size_t _literals = (size_t)(_ip - _anchor);
+				uint8* _token = _op++;
+				if (_op + _literals + _literals / 255 + 2 + 1 + LastLiterals > _dstEnd)
+					return 0;
+				if (_literals >= 15)
+				{
+					*_token = 15 << 4;
+					size_t _len = _literals - 15;
+					for (; _len >= 255; _len -= 255)
+						*_op++ = 255;
+					*_op++ = (uint8)_len;
+				}
+				else
+					*_token = (uint8)(_literals << 4);
+				memcpy(_op, _anchor, _literals);
+				_op += _literals;
+
+				for (;;)
+				{
+					// offset
+					uint16 _offset = (uint16)(_ip - _match);
+					memcpy(_op, &_offset, 2);
+					_op += 2;
+
+					// match length
+					size_t _len = _Count(_ip + MinMatch, _match + MinMatch, _matchEndLimit);
+					_ip += _len + MinMatch;
+					if (_op + _len / 255 + 1 + LastLiterals > _dstEnd)
+						return 0;
+					if (_len >= 15)
+					{
+						*_token += 15;
+						for (_len -= 15; _len >= 255; _len -= 255)
+							*_op++ = 255;
+						*_op++ = (uint8)_len;
+					}
+					else
+						*_token += (uint8)_len;
+
+					_anchor = _ip;
+					if (_ip >= _matchStartLimit)
+						goto LastLiterals;
+
+					_table[_Hash(_Read32(_ip - 2))] = (uint32)(_ip - 2 - _base);
+
+					// immediate next match without literals
+					uint32 _h = _Hash(_Read32(_ip));
+					_match = _base + _table[_h];
+					_table[_h] = (uint32)(_ip - _base);
+					if (_match + MaxDistance < _ip || _Read32(_match) != _Read32(_ip))
+						break;
+
+					if (_op + 1 + 2 + LastLiterals > _dstEnd)
+						return 0;
+					_token = _op++;
+					*_token = 0;
+				}
+
+				_forwardHash = _Hash(_Read32(++_ip));
+			}
+		}
+
+	LastLiterals:
+		size_t _literals = (size_t)(_end - _anchor);
+		if (_op + 1 + (_literals + 255 - 15) / 255 + _literals > _dstEnd)
+			return 0;
+		if (_literals >= 15)
+		{
+			*_op++ = 15 << 4;
+			size_t _len = _literals - 15;
+			for (; _len >= 255; _len -= 255)
+				*_op++ = 255;
+			*_op++ = (uint8)_len;
+		}
+		else
+			*_op++ = (uint8)(_literals << 4);
+		memcpy(_op, _anchor, _literals);
+		_op += _literals;
+
+		return (size_t)(_op - _dstStart);
+	}
+	//----------------------------------------------------------------------------//
+	size_t Lz4::DecompressBlock(const void* _src, size_t _srcSize, void* _dst, size_t _dstCapacity, size_t _dictSize)
+	{
+		static const uint _inc[8] = { 0, 1, 2, 1, 0, 4, 4, 4 };
+		static const int _dec[8] = { 0, 0, 0, -1, -4, 1, 2, 3 };
+
+		const uint8* _ip = reinterpret_cast<const uint8*>(_src);
+		const uint8* const _end = _ip + _srcSize;
+		uint8* const _dstStart = reinterpret_cast<uint8*>(_dst);
+		uint8* const _dstEnd = _dstStart + _dstCapacity;
+		uint8* _op = _dstStart;
+		const uint8* const _lowest = _dstStart - _dictSize;
+
+		for (;;)
+		{
+			if (_ip >= _end)
+				return Error;
+
+			uint _token = *_ip++;
+			size_t _len = _token >> 4;
+
+			if (_len < 15 && _end - _ip >= 16 + 2 && _dstEnd - _op >= 32)
+			{
+				// short literals far from the ends of buffers
+				memcpy(_op, _ip, 16);
+				_op += _len;
+				_ip += _len;
+
+				// short match which does not overlap in 8 byte pieces
+				size_t _offset = _Read16(_ip);
+				size_t _matchLen = (_token & 15) + MinMatch;
+				if (_matchLen < 15 + MinMatch && _offset >= 8 && _offset <= (size_t)(_op - _lowest))
+				{
+					const uint8* _match = _op - _offset;
+					memcpy(_op, _match, 8);
+					memcpy(_op + 8, _match + 8, 8);
+					memcpy(_op + 16, _match + 16, 2);
+					_op += _matchLen;
+					_ip += 2;
+					continue;
+				}
+			}
+			else
+			{
+				// literals
+				if (_len == 15)
+				{
+					uint _s;
+					do
+					{
+						if (_ip >= _end)
+							return Error;
+						_s = *_ip++;
+						_len += _s;
+					} while (_s == 255);
+				}
+
+				if (_len > (size_t)(_end - _ip) || _len > (size_t)(_dstEnd - _op))
+					return Error;
+				memcpy(_op, _ip, _len);
+				_op += _len;
+				_ip += _len;
+
+				if (_ip == _end)
+					break; // block ends with literals
+			}
+
+			// match
+			if (_end - _ip < 2)
+				return Error;
+			size_t _offset = _Read16(_ip);
+			_ip += 2;
+			if (!_offset || _offset > (size_t)(_op - _lowest))
+				return Error;
+			const uint8* _match = _op - _offset;
+
+			_len = _token & 15;
+			if (_len == 15)
+			{
+				uint _s;
+				do
+				{
+					if (_ip >= _end)
+						return Error;
+					_s = *_ip++;
+					_len += _s;
+				} while (_s == 255);
+			}
+			_len += MinMatch;
+
+			if (_len > (size_t)(_dstEnd - _op))
+				return Error;
+			uint8* const _copyEnd = _op + _len;
+
+			if (_dstEnd - _copyEnd < 16 || _len > 64)
+			{
+				// exact copy (near the end of buffer) or long match: the data repeats with period _offset,
+				// so the copied part doubles with each memcpy and the pieces never overlap
+				while (_op < _copyEnd)
+				{
+					size_t _n = Min<size_t>(_op - _match, _copyEnd - _op);
+					memcpy(_op, _match, _n);
+					_op += _n;
+				}
+				continue;
+			}
+
+			if (_offset >= 16)
+			{
+				do
+				{
+					memcpy(_op, _match, 16);
+					_op += 16;
+					_match += 16;
+				} while (_op < _copyEnd);
+			}
+			else
+			{
+				if (_offset < 8)
+				{
+					// spread the pattern, so the distance becomes at least 8
+					_op[0] = _match[0];
+					_op[1] = _match[1];
+					_op[2] = _match[2];
+					_op[3] = _match[3];
+					_match += _inc[_offset];
+					memcpy(_op + 4, _match, 4);
+					_match -= _dec[_offset];
+				}
+				else
+				{
+					memcpy(_op, _match, 8);
+					_match += 8;
+				}
+				_op += 8;
+				while (_op < _copyEnd)
+				{
+					memcpy(_op, _match, 8);
+					_op += 8;
+					_match += 8;
+				}
+			}
+			_op = _copyEnd;
+		}
+
+		return (size_t)(_op - _dstStart);
+	}
+	//----------------------------------------------------------------------------//
+	size_t Lz4::WriteFrameHeader(void* _dst, BlockSize _blockSize, bool _contentChecksum, const uint64* _contentSize)
+	{
+		uint8* _p = reinterpret_cast<uint8*>(_dst);
+		uint32 _magic = FrameMagic;
+		memcpy(_p, &_magic, 4);
+
+		uint8* _desc = _p + 4;
+		_desc[0] = (1 << 6) | (1 << 5); // version 01, independent blocks
+		if (_contentChecksum)
+			_desc[0] |= 1 << 2;
+		if (_contentSize)
+			_desc[0] |= 1 << 3;
+		_desc[1] = (uint8)((int)_blockSize << 4);
+
+		size_t _descSize = 2;
+		if (_contentSize)
+		{
+			memcpy(_desc + 2, _contentSize, 8);
+			_descSize += 8;
+		}
+		_desc[_descSize] = (uint8)(Checksum::XxHash32(_desc, _descSize) >> 8);
+
+		return 4 + _descSize + 1;
+	}
+	//----------------------------------------------------------------------------//
+	bool Lz4::ReadFrameHeader(const void* _src, size_t _size, FrameInfo& _info)
+	{
+		const uint8* _p = reinterpret_cast<const uint8*>(_src);
+		if (_size < 7 || _Read32(_p) != FrameMagic)
+			return false;
+
+		const uint8* _desc = _p + 4;
+		uint _flags = _desc[0], _bd = _desc[1];
+		if ((_flags >> 6) != 1 || (_flags & 0x02) || (_bd & 0x8f))
+			return false; // unknown version or reserved bits
+		uint _blockSize = (_bd >> 4) & 7;
+		if (_blockSize < 4)
+			return false;
+
+		size_t _descSize = 2;
+		_info.independentBlocks = (_flags & (1 << 5)) != 0;
+		_info.blockChecksum = (_flags & (1 << 4)) != 0;
+		_info.hasContentSize = (_flags & (1 << 3)) != 0;
+		_info.contentChecksum = (_flags & (1 << 2)) != 0;
+		_info.blockSize = BlockBytes((BlockSize)_blockSize);
+		_info.contentSize = 0;
+		if (_info.hasContentSize)
+			_descSize += 8;
+		if (_flags & 1)
+			_descSize += 4; // dictionary id
+		if (_size < 4 + _descSize + 1)
+			return false;
+
+		if (_info.hasContentSize)
+			_info.contentSize = _Read64(_desc + 2);
+		if (_flags & 1)
+		{
+			LOG("Error: LZ4 frames with dictionary are not supported");
+			return false;
+		}
+
+		if (_desc[_descSize] != (uint8)(Checksum::XxHash32(_desc, _descSize) >> 8))
+			return false;
+
+		_info.headerSize = 4 + _descSize + 1;
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void Lz4::CompressFrame(const void* _src, size_t _size, Array<uint8>& _dst, BlockSize _blockSize)
+	{
+		const uint8* _data = reinterpret_cast<const uint8*>(_src);
+		size_t _blockBytes = BlockBytes(_blockSize);
+		uint _numBlocks = (uint)((_size + _blockBytes - 1) / _blockBytes);
+
+		Array<Array<uint8>> _blocks(_numBlocks);
+		auto _compress = [&](uint i)
+		{
+			size_t _offset = i * _blockBytes;
+			size_t _rawSize = Min(_blockBytes, _size - _offset);
+			Array<uint8>& _block = _blocks[i];
+			_block.resize(4 + CompressBound(_rawSize));
+			uint32 _packedSize = (uint32)CompressBlock(_data + _offset, _rawSize, _block.data() + 4, _block.size() - 4);
+			if (!_packedSize || _packedSize >= _rawSize)
+			{
+				// incompressible, store raw
+				_packedSize = (uint32)_rawSize;
+				memcpy(_block.data() + 4, _data + _offset, _rawSize);
+				_packedSize |= 0x80000000;
+			}
+			memcpy(_block.data(), &_packedSize, 4);
+			_block.resize(4 + (_packedSize & 0x7fffffff));
+		};
+
+		if (gThreadPool && _numBlocks > 1)
+			gThreadPool->ParallelFor(_numBlocks, _compress);
+		else
+		{
+			for (uint i = 0; i < _numBlocks; ++i)
+				_compress(i);
+		}
+
+		uint8 _header[MaxFrameHeaderSize];
+		uint64 _contentSize = _size;
+		size_t _headerSize = WriteFrameHeader(_header, _blockSize, true, &_contentSize);
+		_dst.insert(_dst.end(), _header, _header + _headerSize);
+
+		for (const Array<uint8>& _block : _blocks)
+			_dst.insert(_dst.end(), _block.begin(), _block.end());
+
+		uint32 _tail[2] = { 0, Checksum::XxHash32(_data, _size) }; // end mark, content checksum
+		_dst.insert(_dst.end(), (const uint8*)_tail, (const uint8*)(_tail + 2));
+	}
+	//----------------------------------------------------------------------------//
+	bool Lz4::DecompressFrame(const void* _src, size_t _size, Array<uint8>& _dst)
+	{
+		const uint8* _p = reinterpret_cast<const uint8*>(_src);
+		const uint8* _end = _p + _size;
+
+		while (_p < _end)
+		{
+			if (_end - _p >= 8 && (_Read32(_p) & 0xfffffff0) == SkippableMagic)
+			{
+				uint32 _skip = _Read32(_p + 4);
+				if (_skip > (size_t)(_end - _p) - 8)
+					return false;
+				_p += 8 + _skip;
+				continue;
+			}
+
+			FrameInfo _info;
+			if (!ReadFrameHeader(_p, _end - _p, _info))
+			{
+				LOG("Error: Invalid LZ4 frame header");
+				return false;
+			}
+			_p += _info.headerSize;
+
+			// size from header is not trusted further than the rest of input can expand
+			if (_info.hasContentSize && _info.contentSize > (uint64)(_end - _p) * MaxRatio)
+			{
+				LOG("Error: Size of LZ4 frame is larger than its data can contain");
+				return false;
+			}
+
+			// with known size the output is allocated once, otherwise it grows by blocks
+			size_t _frameStart = _dst.size();
+			size_t _pos = _frameStart;
+			if (_info.hasContentSize)
+				_dst.resize(_frameStart + (size_t)_info.contentSize);
+
+			for (;;)
+			{
+				if (_end - _p < 4)
+				{
+					_dst.resize(_pos);
+					return false;
+				}
+				uint32 _blockSize = _Read32(_p);
+				_p += 4;
+				if (!_blockSize)
+					break; // end mark
+
+				bool _raw = (_blockSize & 0x80000000) != 0;
+				_blockSize &= 0x7fffffff;
+				bool _valid = _blockSize <= _info.blockSize && _blockSize + (_info.blockChecksum ? 4u : 0u) <= (size_t)(_end - _p);
+				if (_valid && _info.blockChecksum && Checksum::XxHash32(_p, _blockSize) != _Read32(_p + _blockSize))
+					_valid = false;
+
+				if (_valid && !_info.hasContentSize && _dst.size() < _pos + _info.blockSize)
+					_dst.resize(Max(_pos + _info.blockSize, _dst.size() * 2));
+
+				size_t _capacity = Min(_info.blockSize, _dst.size() - _pos);
+				size_t _result = Error;
+				if (_valid && _raw && _blockSize <= _capacity)
+				{
+					memcpy(_dst.data() + _pos, _p, _blockSize);
+					_result = _blockSize;
+				}
+				else if (_valid && !_raw)
+				{
+					// history of linked blocks is the data decompressed before
+					size_t _dictSize = _info.independentBlocks ? 0 : _pos - _frameStart;
+					_result = DecompressBlock(_p, _blockSize, _dst.data() + _pos, _capacity, _dictSize);
+				}
+
+				if (_result == Error)
+				{
+					_dst.resize(_pos);
+					LOG("Error: LZ4 block is corrupted");
+					return false;
+				}
+				_pos += _result;
+				_p += _blockSize + (_info.blockChecksum ? 4 : 0);
+			}
+			_dst.resize(_pos);
+
+			if (_info.hasContentSize && _dst.size() - _frameStart != _info.contentSize)
+			{
+				LOG("Error: Size of LZ4 frame does not match its header");
+				return false;
+			}
+			if (_info.contentChecksum)
+			{
+				if (_end - _p < 4 || Checksum::XxHash32(_dst.data() + _frameStart, _dst.size() - _frameStart) != _Read32(_p))
+				{
+					LOG("Error: LZ4 frame is corrupted");
+					return false;
+				}
+				_p += 4;
+			}
+		}
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// CompressStream
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	CompressStream::CompressStream(Stream* _target, Lz4::BlockSize _blockSize, const uint64* _contentSize) :
+		m_target(_target),
+		m_blockSize(Lz4::BlockBytes(_blockSize)),
+		m_hasContentSize(_contentSize != nullptr),
+		m_contentSize(_contentSize ? *_contentSize : 0)
+	{
+		if (!m_target || !m_target->IsOpened() || m_target->IsReadOnly())
+		{
+			LOG("Error: Unable to write LZ4 frame to \"%s\"", Name().c_str());
+			m_target = nullptr;
+			return;
+		}
+
+		m_buffer.reserve(m_blockSize);
+		m_packed.resize(Lz4::CompressBound(m_blockSize));
+
+		uint8 _header[Lz4::MaxFrameHeaderSize];
+		size_t _size = Lz4::WriteFrameHeader(_header, _blockSize, true, _contentSize);
+		m_target->Write(_header, _size);
+	}
+	//----------------------------------------------------------------------------//
+	CompressStream::~CompressStream(void)
+	{
+		Close();
+	}
+	//----------------------------------------------------------------------------//
+	void CompressStream::Close(void)
+	{
+		if (!m_target)
+			return;
+
+		_WriteBlock();
+
+		if (m_hasContentSize && m_contentSize != m_size)
+			LOG("Error: LZ4 frame \"%s\" has %llu bytes, but %llu bytes were declared", Name().c_str(), (unsigned long long)m_size, (unsigned long long)m_contentSize);
+
+		uint32 _tail[2] = { 0, m_checksum.Digest() }; // end mark, content checksum
+		m_target->Write(_tail, sizeof(_tail));
+		m_target->Flush();
+		m_target = nullptr;
+	}
+	//----------------------------------------------------------------------------//
+	size_t CompressStream::Write(const void* _src, size_t _size)
+	{
+		if (!m_target)
+			return 0;
+
+		const uint8* _p = reinterpret_cast<const uint8*>(_src);
+		size_t _total = 0;
+		while (_total < _size)
+		{
+			size_t _n = Min(_size - _total, m_blockSize - m_buffer.size());
+			m_buffer.insert(m_buffer.end(), _p + _total, _p + _total + _n);
+			_total += _n;
+			if (m_buffer.size() == m_blockSize && !_WriteBlock())
+				break;
+		}
+
+		m_checksum.Update(_src, _total);
+		m_size += _total;
+		return _total;
+	}
+	//----------------------------------------------------------------------------//
+	void CompressStream::Flush(void)
+	{
+		if (m_target)
+		{
+			_WriteBlock();
+			m_target->Flush();
+		}
+	}
+	//----------------------------------------------------------------------------//
+	bool CompressStream::_WriteBlock(void)
+	{
+		if (m_buffer.empty())
+			return true;
+
+		uint32 _size = (uint32)Lz4::CompressBlock(m_buffer.data(), m_buffer.size(), m_packed.data(), m_packed.size());
+		const uint8* _data = m_packed.data();
+		if (!_size || _size >= m_buffer.size())
+		{
+			_size = (uint32)m_buffer.size() | 0x80000000;
+			_data = m_buffer.data();
+		}
+
+		bool _ok = m_target->Write(&_size, 4) == 4;
+		_size &= 0x7fffffff;
+		_ok = _ok && m_target->Write(_data, _size) == _size;
+		m_buffer.clear();
+
+		if (!_ok)
+			LOG("Error: Unable to write LZ4 block to \"%s\"", Name().c_str());
+		return _ok;
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// DecompressStream
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	DecompressStream::DecompressStream(Stream* _source) :
+		m_source(_source),
+		m_start(_source ? _source->Tell() : 0)
+	{
+		if (!m_source || !_Restart())
+		{
+			LOG("Error: \"%s\" is not a LZ4 frame", Name().c_str());
+			m_source = nullptr;
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void DecompressStream::Close(void)
+	{
+		m_source = nullptr;
+		m_buffer.clear();
+		m_packed.clear();
+	}
+	//----------------------------------------------------------------------------//
+	bool DecompressStream::EoF(void)
+	{
+		return m_pos >= m_blockPos + m_blockSize && (m_end || !_NextBlock());
+	}
+	//----------------------------------------------------------------------------//
+	void DecompressStream::Seek(int64 _offset, SeekOrigin _origin)
+	{
+		if (!m_source)
+			return;
+
+		int64 _pos = _offset;
+		if (_origin == SeekOrigin::Current)
+			_pos += m_pos;
+		else if (_origin == SeekOrigin::End)
+			_pos += m_size;
+		if (_pos < 0)
+			_pos = 0;
+
+		if ((uint64)_pos < m_blockPos && !_Restart())
+			return;
+
+		// decompress up to block containing the position
+		while ((uint64)_pos >= m_blockPos + m_blockSize && !m_end && _NextBlock());
+		m_pos = Min<uint64>(_pos, m_blockPos + m_blockSize);
+	}
+	//----------------------------------------------------------------------------//
+	size_t DecompressStream::Read(void* _dst, size_t _size)
+	{
+		if (!m_source)
+			return 0;
+
+		uint8* _p = reinterpret_cast<uint8*>(_dst);
+		size_t _total = 0;
+		while (_total < _size)
+		{
+			if (m_pos >= m_blockPos + m_blockSize && (m_end || !_NextBlock()))
+				break;
+
+			size_t _offset = (size_t)(m_pos - m_blockPos);
+			size_t _n = Min(_size - _total, m_blockSize - _offset);
+			memcpy(_p + _total, m_buffer.data() + m_blockStart + _offset, _n);
+			_total += _n;
+			m_pos += _n;
+		}
+		return _total;
+	}
+	//----------------------------------------------------------------------------//
+	bool DecompressStream::_Restart(void)
+	{
+		uint8 _header[Lz4::MaxFrameHeaderSize];
+		m_source->Seek(m_start, SeekOrigin::Set);
+		size_t _size = m_source->Read(_header, 7);
+		if (_size == 7 && (_header[4] & (1 << 3)))
+			_size += m_source->Read(_header + 7, 8);
+		if (_size >= 7 && (_header[4] & 1))
+			_size += m_source->Read(_header + _size, 4);
+
+		if (!Lz4::ReadFrameHeader(_header, _size, m_info))
+			return false;
+
+		size_t _history = m_info.independentBlocks ? 0 : Lz4::MaxDistance + 1;
+		m_buffer.resize(_history + m_info.blockSize);
+		m_blockStart = 0;
+		m_blockSize = 0;
+		m_blockPos = 0;
+		m_pos = 0;
+		m_size = m_info.contentSize;
+		m_end = false;
+		m_checksum.Reset();
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool DecompressStream::_NextBlock(void)
+	{
+		m_blockPos += m_blockSize;
+
+		if (!m_info.independentBlocks)
+		{
+			// keep the last 64 KB of data for references of next block
+			size_t _used = m_blockStart + m_blockSize;
+			size_t _keep = Min<size_t>(_used, Lz4::MaxDistance + 1);
+			memmove(m_buffer.data(), m_buffer.data() + _used - _keep, _keep);
+			m_blockStart = _keep;
+		}
+		m_blockSize = 0;
+
+		uint32 _packedSize = 0;
+		if (m_source->Read(&_packedSize, 4) != 4)
+		{
+			LOG("Error: Unexpected end of LZ4 frame \"%s\"", Name().c_str());
+			m_end = true;
+			return false;
+		}
+
+		if (!_packedSize)
+		{
+			m_end = true;
+			if (!m_info.hasContentSize)
+				m_size = m_blockPos;
+			else if (m_blockPos != m_info.contentSize)
+				LOG("Error: Size of LZ4 frame \"%s\" does not match its header", Name().c_str());
+
+			uint32 _checksum;
+			if (m_info.contentChecksum && (m_source->Read(&_checksum, 4) != 4 || _checksum != m_checksum.Digest()))
+				LOG("Error: LZ4 frame \"%s\" is corrupted", Name().c_str());
+			return false;
+		}
+
+		bool _raw = (_packedSize & 0x80000000) != 0;
+		_packedSize &= 0x7fffffff;
+		if (_packedSize > m_info.blockSize)
+		{
+			LOG("Error: Invalid LZ4 block in \"%s\"", Name().c_str());
+			m_end = true;
+			return false;
+		}
+
+		uint8* _block = m_buffer.data() + m_blockStart;
+		size_t _size;
+		if (_raw)
+		{
+			_size = m_source->Read(_block, _packedSize);
+			if (_size != _packedSize)
+				_size = Lz4::Error;
+		}
+		else
+		{
+			m_packed.resize(m_info.blockSize);
+			_size = Lz4::Error;
+			if (m_source->Read(m_packed.data(), _packedSize) == _packedSize)
+				_size = Lz4::DecompressBlock(m_packed.data(), _packedSize, _block, m_info.blockSize, m_blockStart);
+		}
+
+		uint32 _checksum;
+		if (_size != Lz4::Error && m_info.blockChecksum && (m_source->Read(&_checksum, 4) != 4 || _checksum != Checksum::XxHash32(_raw ? _block : m_packed.data(), _packedSize)))
+			_size = Lz4::Error;
+		if (_size == Lz4::Error)
+		{
+			LOG("Error: LZ4 block of \"%s\" is corrupted", Name().c_str());
+			m_end = true;
+			return false;
+		}
+
+		m_blockSize = _size;
+		if (m_info.contentChecksum)
+			m_checksum.Update(_block, _size);
+		return _size > 0 || _NextBlock();
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
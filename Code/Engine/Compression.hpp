@@ -0,0 +1,224 @@
+#pragma once
+
+#include "File.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// Lz4
+	//----------------------------------------------------------------------------//
+
+	//! LZ4 compression. Blocks and frames are compatible with the reference implementation (lz4 tool).
+	struct Lz4
+	{
+		enum : size_t
+		{
+			Error = (size_t)-1, //!< result of failed decompression
+			MaxInputSize = 0x7E000000,
+			MaxDistance = 65535,
+			MaxRatio = 255, //!< decompressed block is never larger than its compressed size multiplied by this
+		};
+
+		enum : uint32
+		{
+			FrameMagic = 0x184D2204,
+			SkippableMagic = 0x184D2A50, //!< 0x184D2A50 - 0x184D2A5F
+			MaxFrameHeaderSize = 19,
+		};
+
+		//! Maximal size of blocks in frame
+		enum class BlockSize : uint8
+		{
+			Max64KB = 4,
+			Max256KB = 5,
+			Max1MB = 6,
+			Max4MB = 7,
+		};
+
+		//! Parameters of frame
+		struct FrameInfo
+		{
+			size_t blockSize = 0; //!< maximal size of block
+			bool independentBlocks = true;
+			bool blockChecksum = false;
+			bool contentChecksum = false;
+			bool hasContentSize = false;
+			uint64 contentSize = 0;
+			size_t headerSize = 0;
+		};
+
+		//! \return size of buffer sufficient for compressed block
+		static size_t CompressBound(size_t _size) { return _size + _size / 255 + 16; }
+		//! \return size in bytes
+		static size_t BlockBytes(BlockSize _blockSize) { return (size_t)1 << (8 + 2 * (int)_blockSize); }
+
+		//! Compress block.
+		//! \return compressed size or 0 if _dst is too small
+		static size_t CompressBlock(const void* _src, size_t _srcSize, void* _dst, size_t _dstCapacity);
+		//! Decompress block.
+		/*!	\param _dictSize number of decompressed bytes right before _dst which can be referenced (linked blocks)
+			\return decompressed size or Error
+		*/
+		static size_t DecompressBlock(const void* _src, size_t _srcSize, void* _dst, size_t _dstCapacity, size_t _dictSize = 0);
+
+		//! Write frame header. _dst must have MaxFrameHeaderSize bytes.
+		//! \return size of header
+		static size_t WriteFrameHeader(void* _dst, BlockSize _blockSize, bool _contentChecksum, const uint64* _contentSize = nullptr);
+		//! Parse frame header
+		//! \return false if header is invalid or incomplete
+		static bool ReadFrameHeader(const void* _src, size_t _size, FrameInfo& _info);
+
+		//! Compress data to frame with independent blocks. Blocks are compressed in parallel if gThreadPool exists.
+		static void CompressFrame(const void* _src, size_t _size, Array<uint8>& _dst, BlockSize _blockSize = BlockSize::Max4MB);
+		//! Decompress frame (or several concatenated frames) and append the data to _dst.
+		static bool DecompressFrame(const void* _src, size_t _size, Array<uint8>& _dst);
+
+	protected:
+		enum : size_t
+		{
+			MinMatch = 4,
+			LastLiterals = 5, //!< the last bytes of block are always literals
+			MatchLimit = 12, //!< the last match starts at least this far from the end of block
+			HashLog = 12,
+		};
+
+		//!
+		static uint16 _Read16(const uint8* _p) { uint16 _v; memcpy(&_v, _p, 2); return _v; }
+		//!
+		static uint32 _Read32(const uint8* _p) { uint32 _v; memcpy(&_v, _p, 4); return _v; }
+		//!
+		static uint64 _Read64(const uint8* _p) { uint64 _v; memcpy(&_v, _p, 8); return _v; }
+		//!
+		static uint32 _Hash(uint32 _v) { return (_v * 2654435761u) >> (32 - HashLog); }
+		//! \return number of equal bytes
+		static size_t _Count(const uint8* _a, const uint8* _b, const uint8* _aEnd);
+	};
+
+	//----------------------------------------------------------------------------//
+	// CompressStream
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class CompressStream> CompressStreamPtr;
+
+	//! Write-only stream which writes LZ4 frame to other stream. Frame is finished on Close.
+	class CompressStream : public Stream
+	{
+	public:
+		RTTI("CompressStream");
+
+		//!	\param _contentSize size of data written to header if known in advance
+		CompressStream(Stream* _target, Lz4::BlockSize _blockSize = Lz4::BlockSize::Max64KB, const uint64* _contentSize = nullptr);
+		//!
+		~CompressStream(void);
+
+		//!
+		const String& Name(void) override { return m_target ? m_target->Name() : StringUtils::EmptyString; }
+
+		//!
+		bool IsOpened(void) override { return m_target != nullptr; }
+		//! Write last block and end of frame
+		void Close(void) override;
+
+		//! \return number of written (uncompressed) bytes
+		uint64 Size(void) override { return m_size; }
+		//!
+		bool EoF(void) override { return true; }
+		//! Not supported
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override { }
+		//!
+		uint64 Tell(void) override { return m_size; }
+
+		//!
+		bool IsReadOnly(void) override { return false; }
+		//!
+		size_t Read(void* _dst, size_t _size) override { return 0; }
+		//!
+		size_t Write(const void* _src, size_t _size) override;
+		//! Compress buffered data to block and flush target stream
+		void Flush(void) override;
+
+		//!
+		Stream* Target(void) { return m_target; }
+
+	protected:
+		//!
+		bool _WriteBlock(void);
+
+		StreamPtr m_target;
+		Array<uint8> m_buffer;
+		Array<uint8> m_packed;
+		size_t m_blockSize;
+		uint64 m_size = 0;
+		bool m_hasContentSize;
+		uint64 m_contentSize;
+		XxHash32 m_checksum;
+	};
+
+	//----------------------------------------------------------------------------//
+	// DecompressStream
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class DecompressStream> DecompressStreamPtr;
+
+	//! Read-only stream of data of LZ4 frame. Seeking backward restarts decompression from beginning of frame.
+	class DecompressStream : public Stream
+	{
+	public:
+		RTTI("DecompressStream");
+
+		//! Frame starts at current position of source
+		DecompressStream(Stream* _source);
+
+		//!
+		const String& Name(void) override { return m_source ? m_source->Name() : StringUtils::EmptyString; }
+
+		//!
+		bool IsOpened(void) override { return m_source != nullptr; }
+		//!
+		void Close(void) override;
+
+		//! \return content size from header. If header has no size, it is known when end of frame is reached.
+		uint64 Size(void) override { return m_size; }
+		//!
+		bool EoF(void) override;
+		//!
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override;
+		//!
+		uint64 Tell(void) override { return m_pos; }
+
+		//!
+		bool IsReadOnly(void) override { return true; }
+		//!
+		size_t Read(void* _dst, size_t _size) override;
+		//!
+		size_t Write(const void* _src, size_t _size) override { return 0; }
+		//!
+		void Flush(void) override { }
+
+		//!
+		Stream* Source(void) { return m_source; }
+
+	protected:
+		//! Read frame header from start
+		bool _Restart(void);
+		//! Decompress next block. \return false at end of frame or on error
+		bool _NextBlock(void);
+
+		StreamPtr m_source;
+		uint64 m_start; //!< position of frame in source
+		Lz4::FrameInfo m_info;
+		Array<uint8> m_packed;
+		Array<uint8> m_buffer; //!< history (linked blocks) and current block
+		size_t m_blockStart = 0; //!< offset of current block in buffer
+		size_t m_blockSize = 0;
+		uint64 m_blockPos = 0; //!< position of current block in content
+		uint64 m_pos = 0;
+		uint64 m_size = 0;
+		bool m_end = false;
+		XxHash32 m_checksum;
+	};
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
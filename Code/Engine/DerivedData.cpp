@@ -0,0 +1,230 @@
+#include "DerivedData.hpp"
+#include "Math.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// DerivedDataCache
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	DerivedDataCache::DerivedDataCache(const String& _dir, uint64 _maxSize) :
+		m_dir(PathUtils::Normalize(_dir)),
+		m_maxSize(_maxSize)
+	{
+		if (!m_dir.empty() && !PathUtils::IsDelimeter(m_dir.back()))
+			m_dir += "/";
+
+		if (!FileSystem::CreateDir(m_dir))
+		{
+			m_dir.clear();
+			return;
+		}
+
+		_Scan();
+	}
+	//----------------------------------------------------------------------------//
+	DerivedDataCache::~DerivedDataCache(void)
+	{
+	}
+	//----------------------------------------------------------------------------//
+	void DerivedDataCache::SetMaxSize(uint64 _size)
+	{
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		m_maxSize = _size;
+		_Trim(m_maxSize);
+	}
+	//----------------------------------------------------------------------------//
+	StreamPtr DerivedDataCache::Find(uint64 _key)
+	{
+		String _path = _Path(_key);
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			auto _it = m_entries.find(_key);
+			if (_it == m_entries.end() || (_it->second.writer && !_it->second.writer->IsFinished()))
+			{
+				++m_stats.misses;
+				return nullptr;
+			}
+			_it->second.writer = nullptr;
+		}
+
+		// time of use for other caches in this directory; fails if entry was deleted by one of them
+		if (!FileSystem::Touch(_path))
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			auto _it = m_entries.find(_key);
+			if (_it != m_entries.end() && !_it->second.writer)
+			{
+				m_size -= _it->second.size;
+				m_entries.erase(_it);
+			}
+			++m_stats.misses;
+			return nullptr;
+		}
+		uint64 _time = FileSystem::FileTime();
+
+		MappedFileStreamPtr _file = new MappedFileStream;
+		Header _header;
+		if (!_file->Open(_path, Stream::Access::Sequential) || _file->Read(&_header, sizeof(_header)) != sizeof(_header) ||
+			_header.magic != Magic || _header.version != Version || _header.key != _key || _header.size != _file->Size() - sizeof(_header))
+		{
+			LOG("Error: Derived data \"%s\" is invalid", _path.c_str());
+			_file = nullptr;
+			FileSystem::Remove(_path);
+
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			auto _it = m_entries.find(_key);
+			if (_it != m_entries.end() && !_it->second.writer)
+			{
+				m_size -= _it->second.size;
+				m_entries.erase(_it);
+			}
+			++m_stats.misses;
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		auto _it = m_entries.find(_key);
+		if (_it != m_entries.end())
+			_it->second.time = _time;
+		++m_stats.hits;
+		return _file.Cast<Stream>();
+	}
+	//----------------------------------------------------------------------------//
+	bool DerivedDataCache::Store(uint64 _key, const void* _data, size_t _size)
+	{
+		ASSERT(!_size || _data);
+		if (m_dir.empty())
+			return false;
+
+		Header _header;
+		_header.key = _key;
+		_header.size = _size;
+
+		// buffer is large enough to never block the caller
+		AsyncWriteStreamPtr _writer = new AsyncWriteStream;
+		if (!_writer->Open(_Path(_key), true, Max<size_t>(sizeof(_header) + _size, AsyncWriteStream::DefaultMaxBuffered)))
+			return false;
+		_writer->Write(&_header, sizeof(_header));
+		_writer->Write(_data, _size);
+		_writer->Close();
+
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		Entry& _entry = m_entries[_key];
+		m_size += sizeof(_header) + _size - _entry.size;
+		_entry.size = sizeof(_header) + _size;
+		_entry.time = FileSystem::FileTime();
+		_entry.writer = _writer;
+		++m_stats.stores;
+
+		if (m_size > m_maxSize)
+			_Trim(m_maxSize - m_maxSize / 8); // some space for next entries
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void DerivedDataCache::Clear(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		_Trim(0);
+	}
+	//----------------------------------------------------------------------------//
+	void DerivedDataCache::Trim(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		_Trim(m_maxSize);
+	}
+	//----------------------------------------------------------------------------//
+	DerivedDataCache::Stats DerivedDataCache::GetStats(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		Stats _stats = m_stats;
+		_stats.entries = (uint)m_entries.size();
+		_stats.size = m_size;
+		return _stats;
+	}
+	//----------------------------------------------------------------------------//
+	String DerivedDataCache::_Path(uint64 _key)
+	{
+		char _name[32];
+		snprintf(_name, sizeof(_name), "%016llx.ddc", (unsigned long long)_key);
+		return m_dir + _name;
+	}
+	//----------------------------------------------------------------------------//
+	void DerivedDataCache::_Scan(void)
+	{
+		Array<FileInfo> _files;
+		if (!FileSystem::ListFiles(m_dir, _files))
+			return;
+
+		uint64 _now = FileSystem::FileTime();
+		uint64 _staleAge = FileSystem::FileTimeSpan(StaleTempAge);
+
+		for (const FileInfo& _file : _files)
+		{
+			if (_file.isDir)
+				continue;
+
+			unsigned long long _key;
+			char _ext[8];
+			if (_file.name.length() == 20 && sscanf(_file.name.c_str(), "%16llx.%3s", &_key, _ext) == 2 && !strcmp(_ext, "ddc"))
+			{
+				Entry& _entry = m_entries[_key];
+				_entry.size = _file.size;
+				_entry.time = _file.time;
+				m_size += _file.size;
+			}
+			else if (!StringUtils::Cmpi(PathUtils::Extension(_file.name).c_str(), "tmp") && _file.time + _staleAge < _now)
+			{
+				FileSystem::Remove(m_dir + _file.name); // interrupted write; recent ones can be written by other processes
+			}
+		}
+
+		_Trim(m_maxSize);
+	}
+	//----------------------------------------------------------------------------//
+	void DerivedDataCache::_Trim(uint64 _limit)
+	{
+		if (m_size <= _limit)
+			return;
+
+		Array<std::pair<uint64, uint64>> _order; // time, key
+		_order.reserve(m_entries.size());
+		for (const auto& _it : m_entries)
+		{
+			if (!_it.second.writer || _it.second.writer->IsFinished())
+				_order.push_back({ _it.second.time, _it.first });
+		}
+		std::sort(_order.begin(), _order.end());
+
+		uint64 _tolerance = FileSystem::FileTimeSpan(2);
+		for (size_t i = 0; i < _order.size() && m_size > _limit; ++i)
+		{
+			auto _it = m_entries.find(_order[i].second);
+			String _path = _Path(_it->first);
+
+			// directory can be shared with other caches
+			FileInfo _info;
+			if (FileSystem::Stat(_path, _info))
+			{
+				if (_info.time > _it->second.time + _tolerance)
+				{
+					_it->second.time = _info.time; // used by other cache
+					continue;
+				}
+				if (!FileSystem::Remove(_path))
+					continue; // mapped (on Windows)
+				++m_stats.evictions;
+			}
+			// else deleted by other cache
+
+			m_size -= _it->second.size;
+			m_entries.erase(_it);
+		}
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "AsyncIO.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// DerivedDataCache
+	//----------------------------------------------------------------------------//
+
+#define gDerivedData DerivedDataCache::Get()
+
+	//! Local on-disk cache of processed asset data (decoded and compressed textures etc.).
+	/*!	Entries are addressed by 64-bit content key: XxHash64 of source bytes, descriptor and processing settings,
+		so changed sources or settings produce new keys and the old entries age out.
+		Each entry is file "<key>.ddc" in cache directory, written in background with atomic replace and read mapped to memory.
+		When size of cache exceeds the limit, least recently used entries are deleted (time of use is stored as modification time of file).
+		Directory can be shared by several caches and processes: entries used or deleted by others are detected by their files.
+	*/
+	class DerivedDataCache : public Module<DerivedDataCache>
+	{
+	public:
+		enum : uint32
+		{
+			Magic = 0x44443245, //!< "E2DD"
+			Version = 1,
+		};
+
+		enum : uint64
+		{
+			DefaultMaxSize = 512 * 1024 * 1024,
+			StaleTempAge = 60 * 60, //!< seconds after which temporary file is considered as left by interrupted write
+		};
+
+		//! Header of entry file
+		struct Header
+		{
+			uint32 magic = Magic;
+			uint32 version = Version;
+			uint64 key = 0;
+			uint64 size = 0; //!< size of data after header
+		};
+
+		//!
+		struct Stats
+		{
+			uint hits = 0;
+			uint misses = 0;
+			uint stores = 0;
+			uint evictions = 0; //!< entries deleted by Trim
+			uint entries = 0;
+			uint64 size = 0; //!< size of entry files
+		};
+
+		//! Open cache directory (it is created if needed) and read list of entries
+		DerivedDataCache(const String& _dir = "DerivedData", uint64 _maxSize = DefaultMaxSize);
+		//!
+		~DerivedDataCache(void);
+
+		//!
+		const String& GetDirectory(void) { return m_dir; }
+		//!
+		void SetMaxSize(uint64 _size);
+		//!
+		uint64 GetMaxSize(void) { return m_maxSize; }
+
+		//! Find entry. Data is mapped to memory and starts at current position of stream (Data() + Tell()).
+		//! \return stream or nullptr if entry does not exist or is not written yet
+		StreamPtr Find(uint64 _key);
+		//! Store entry. Data is copied and written in background; stored entry replaces existent one.
+		bool Store(uint64 _key, const void* _data, size_t _size);
+		//! Delete all entries
+		void Clear(void);
+		//! Delete least recently used entries until size of cache is within the limit
+		void Trim(void);
+
+		//!
+		Stats GetStats(void);
+
+	protected:
+		//!
+		struct Entry
+		{
+			uint64 size;
+			uint64 time; //!< time of last use (FileSystem::FileTime)
+			AsyncWriteStreamPtr writer; //!< entry is being written
+		};
+
+		//! \return path of entry file
+		String _Path(uint64 _key);
+		//! Read list of entry files and delete stale temporary files
+		void _Scan(void);
+		//! Delete entries until size is within _limit. m_mutex must be locked.
+		void _Trim(uint64 _limit);
+
+		String m_dir; //!< ends with delimeter
+		uint64 m_maxSize;
+		std::mutex m_mutex; //!< resources are loaded on worker threads
+		HashMap<uint64, Entry> m_entries;
+		uint64 m_size = 0;
+		Stats m_stats;
+	};
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
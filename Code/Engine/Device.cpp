@@ -32,11 +32,17 @@ namespace Easy2D
 			SDL_GetWindowSize(m_window, &m_size.x, &m_size.y);
 
 			m_opened = true;
+			m_contextAlive = true;
 
 		} break;
 
 		case SystemEvent::Shutdown:
 		{
+			{
+				std::lock_guard<std::mutex> _lock(m_deleteMutex);
+				m_contextAlive = false;
+			}
+			_FlushDeleted();
 			_Shutdown();
 			m_opened = false;
 
@@ -44,6 +50,8 @@ namespace Easy2D
 
 		case SystemEvent::BeginFrame:
 		{
+			_FlushDeleted();
+
 			SDL_Event _event;
 			while (SDL_PollEvent(&_event))
 			{
@@ -80,6 +88,31 @@ namespace Easy2D
 		m_opened = !_exit;
 	}
 	//----------------------------------------------------------------------------//
+	void Device::DeleteTexture(uint _handle)
+	{
+		if (!_handle)
+			return;
+
+		std::lock_guard<std::mutex> _lock(m_deleteMutex);
+		if (m_contextAlive)
+			m_deletedTextures.push_back(_handle);
+		// else context is destroyed already, handle is released with it
+	}
+	//----------------------------------------------------------------------------//
+	void Device::_FlushDeleted(void)
+	{
+		{
+			std::lock_guard<std::mutex> _lock(m_deleteMutex);
+			m_deletingTextures.swap(m_deletedTextures);
+		}
+
+		if (!m_deletingTextures.empty())
+		{
+			_DeleteTextures(m_deletingTextures.data(), (uint)m_deletingTextures.size());
+			m_deletingTextures.clear();
+		}
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	//
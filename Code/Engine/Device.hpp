@@ -2,6 +2,7 @@
 
 #include "System.hpp"
 #include "Math.hpp"
+#include <mutex>
 
 struct SDL_Window;
 
@@ -11,7 +12,7 @@ namespace Easy2D
 	// Device
 	//----------------------------------------------------------------------------//
 
-#define gDevice Easy2D::Device::Instance
+#define gDevice Easy2D::Device::Get()
 
 	class Device abstract : public Module<Device>
 	{
@@ -33,18 +34,30 @@ namespace Easy2D
 		//!
 		void RequireExit(bool _exit = true);
 
+		//!	Queue deletion of texture handle. Can be called from any thread; handles are deleted on main thread at begin of frame and before shutdown.
+		void DeleteTexture(uint _handle);
+
 
 	protected:
 		//!	Create window and graphics
 		virtual bool _Startup(void) = 0;
 		//!	Destroy window and graphics
 		virtual void _Shutdown(void) = 0;
+		//!	Delete queued texture handles. Called on main thread while context is alive.
+		virtual void _DeleteTextures(const uint* _handles, uint _count) = 0;
+		//!
+		void _FlushDeleted(void);
 
 		SDL_Window* m_window = nullptr;
 		IntVector2 m_size = { 0, 0 };
 
 		bool m_opened = false;
 		bool m_userRequireExit = false;
+
+		std::mutex m_deleteMutex;
+		bool m_contextAlive = false;
+		Array<uint> m_deletedTextures;
+		Array<uint> m_deletingTextures;
 	};
 
 	//----------------------------------------------------------------------------//
@@ -131,7 +131,7 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 			return true;
 
 		if (m_pixels)
-			delete[] m_pixels;
+			free(m_pixels);
 
 		m_size.x = _width;
 		m_size.y = _height;
@@ -157,10 +157,29 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 		return m_pixels + m_size.x * m_size.y * m_channels * _index;
 	}
 	//----------------------------------------------------------------------------//
-	bool Image::Load(Stream* _src)
+	bool Image::BeginLoad(Stream* _src)
 	{
 		ASSERT(_src != nullptr);
 
+		StreamPtr _cooked = TextureData::Read(_src);
+		if (_cooked)
+		{
+			const TextureData::Header* _header = TextureData::Parse(_cooked->Data() + _cooked->Tell(), (size_t)(_cooked->Size() - _cooked->Tell()));
+			if (_header->compression != TextureData::Compression::None)
+			{
+				LOG("Error: Unable to load image \"%s\": data is compressed", m_name.c_str());
+				return false;
+			}
+
+			uint _w, _h;
+			size_t _size;
+			const uint8* _level = TextureData::Level(_header, 0, _w, _h, _size);
+			if (!Realloc(_w, _h, 1, _header->channels))
+				return false;
+			memcpy(m_pixels, _level, _size);
+			return true;
+		}
+
 		stbi_io_callbacks _cb =
 		{
 			//read
@@ -184,9 +203,14 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 		};
 
 		int _w = 0, _h = 0, _c = 0;
+		uint8* _data;
+		const uint8* _mem = _src->Data();
+
+		if (_mem) // decode in place
+			_data = stbi_load_from_memory(_mem + _src->Tell(), (int)(_src->Size() - _src->Tell()), &_w, &_h, &_c, 0);
+		else
+			_data = stbi_load_from_callbacks(&_cb, _src, &_w, &_h, &_c, 0);
 
-		uint8* _data = stbi_load_from_callbacks(&_cb, _src, &_w, &_h, &_c, 0);
-	
 		if (m_pixels)
 			free(m_pixels);
 
@@ -210,6 +234,18 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 		return Resource::Save(_dst);
 	}
 	//----------------------------------------------------------------------------//
+	void Image::_Swap(Resource* _other)
+	{
+		Resource::_Swap(_other);
+
+		Image* _img = static_cast<Image*>(_other);
+		std::swap(m_size, _img->m_size);
+		std::swap(m_depth, _img->m_depth);
+		std::swap(m_channels, _img->m_channels);
+		std::swap(m_pixels, _img->m_pixels);
+		std::swap(m_compressedFormat, _img->m_compressedFormat);
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	// PixelFormat
@@ -284,12 +320,24 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 
 	const uint GLUnusedTextureSlot = 5;
 
+	//----------------------------------------------------------------------------//
+	Texture::~Texture(void)
+	{
+		Destroy();
+	}
+	//----------------------------------------------------------------------------//
+	Texture::Type Texture::TypeFromName(const String& _name)
+	{
+		return StringUtils::Cmpi(_name.c_str(), "volume") ? Type::Default : Type::Volume;
+	}
 	//----------------------------------------------------------------------------//
 	void Texture::Create(Type _type, PixelFormat::Enum _format)
 	{
 		Destroy();
 		m_type = _type;
 		m_format = _format;
+		if (!gDevice)
+			return; // headless
 		glGenTextures(1, &m_handle);
 		_Bind(1);
 	}
@@ -298,12 +346,14 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 	{
 		if (m_handle)
 		{
-			glDeleteTextures(1, &m_handle);
+			// last reference can be released on worker thread or after shutdown of device
+			if (gDevice)
+				gDevice->DeleteTexture(m_handle);
 			m_handle = 0;
 		}
 	}
 	//----------------------------------------------------------------------------//
-	void Texture::Realloc(uint _width, uint _height, uint _depth)
+	void Texture::Realloc(uint _width, uint _height, uint _depth, uint _levels)
 	{
 		if (_depth == 0)
 			_depth = m_depth;
@@ -313,47 +363,59 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 		m_size.x = _width;
 		m_size.y = _height;
 		m_depth = _depth;
+		m_levels = Max(_levels, 1u);
+
+		if (!m_handle)
+			return;
 
 		const GLPixelFormatDesc& _pf = GLPixelFormat[m_format];
 
 		_Bind(GLUnusedTextureSlot);
-		if (m_type == Type::Default)
-		{
-			glTexImage2D(GLTextureType[(uint)m_type], 0, _pf.iformat, _width, _height, 0, _pf.format, _pf.type, nullptr);
-		}
-		else
+		for (uint i = 0; i < m_levels; ++i)
 		{
-			glTexImage3D(GLTextureType[(uint)m_type], 0, _pf.iformat, _width, _height, _depth, 0, _pf.format, _pf.type, nullptr);
+			uint _w = Max(_width >> i, 1u), _h = Max(_height >> i, 1u), _d = Max(_depth >> i, 1u);
+			if (m_type == Type::Default)
+			{
+				glTexImage2D(GLTextureType[(uint)m_type], i, _pf.iformat, _w, _h, 0, _pf.format, _pf.type, nullptr);
+			}
+			else
+			{
+				glTexImage3D(GLTextureType[(uint)m_type], i, _pf.iformat, _w, _h, _d, 0, _pf.format, _pf.type, nullptr);
+			}
 		}
+		glTexParameteri(GLTextureType[(uint)m_type], GL_TEXTURE_MAX_LEVEL, m_levels - 1);
 	}
 	//----------------------------------------------------------------------------//
-	void Texture::Write(int _x, int _y, int _z, uint _w, uint _h, uint _d, PixelFormat::Enum _format, const void* _data)
+	void Texture::Write(int _x, int _y, int _z, uint _w, uint _h, uint _d, PixelFormat::Enum _format, const void* _data, uint _level)
 	{
+		if (!m_handle)
+			return;
+
 		const GLPixelFormatDesc& _pf = GLPixelFormat[_format];
 
 		_Bind(GLUnusedTextureSlot);
 		if (PixelFormat::IsCompressed(_format))
 		{
-			uint _size = (_pf.bpp * _w * _h * _d) >> 3;
+			uint _size = ((_w + 3) / 4) * ((_h + 3) / 4) * _d * _pf.bpp * 2; // 4x4 blocks
 
 			if (m_type == Type::Default)
 			{
-				glCompressedTexSubImage2D(GLTextureType[(uint)m_type], 0, _x, _y, _w, _h, _pf.iformat, _size, _data);
+				glCompressedTexSubImage2D(GLTextureType[(uint)m_type], _level, _x, _y, _w, _h, _pf.iformat, _size, _data);
 			}
 			else
 			{
-				glCompressedTexSubImage3D(GLTextureType[(uint)m_type], 0, _x, _y, _z, _w, _h, _d, _pf.iformat, _size, _data);
+				glCompressedTexSubImage3D(GLTextureType[(uint)m_type], _level, _x, _y, _z, _w, _h, _d, _pf.iformat, _size, _data);
 			}
 		}
 		else
 		{
 			if (m_type == Type::Default)
 			{
-				glTexSubImage2D(GLTextureType[(uint)m_type], 0, _x, _y, _w, _h, _pf.format, _pf.type, _data);
+				glTexSubImage2D(GLTextureType[(uint)m_type], _level, _x, _y, _w, _h, _pf.format, _pf.type, _data);
 			}
 			else
 			{
-				glTexSubImage3D(GLTextureType[(uint)m_type], 0, _x, _y, _z, _w, _h, _d, _pf.format, _pf.type, _data);
+				glTexSubImage3D(GLTextureType[(uint)m_type], _level, _x, _y, _z, _w, _h, _d, _pf.format, _pf.type, _data);
 			}
 		}
 	}
@@ -364,16 +426,37 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 		glBindTexture(GLTextureType[(uint)m_type], m_handle);
 	}
 	//----------------------------------------------------------------------------//
-	bool Texture::Load(Stream* _src)
+	void Texture::GetDependencies(Stream* _src, Array<Dependency>& _deps)
+	{
+		if (StringUtils::Cmpi(PathUtils::Extension(_src->Name()).c_str(), "json"))
+			return;
+
+		uint32 _magic = 0;
+		uint64 _start = _src->Tell();
+		if (_src->Read(&_magic, sizeof(_magic)) == sizeof(_magic) && _magic == TextureData::Magic)
+			return; // cooked
+		_src->Seek(_start, Stream::SeekOrigin::Set);
+
+		Json _desc;
+		if (_desc.Load(_src) && _desc["Source"].IsString())
+			_deps.push_back({ StringUtils::EmptyString, _desc["Source"] });
+	}
+	//----------------------------------------------------------------------------//
+	bool Texture::BeginLoad(Stream* _src)
 	{
 		ASSERT(_src != nullptr);
 
 		Type _type = Type::Default;
 		String _source;
+		String _descText;
 		bool _useCompression = false;
 		StreamPtr _imgSrc = _src;
 		bool _flipX = false, _flipY = false;
 
+		m_data = TextureData::Read(_src);
+		if (m_data) // cooked
+			return true;
+
 		String _ext = PathUtils::Extension(_src->Name());
 		if (!StringUtils::Cmpi(_ext.c_str(), "json"))
 		{
@@ -384,49 +467,195 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 				return false;
 			}
 
-			_type = StringUtils::Cmpi(_desc["Type"].AsString().c_str(), "volume") ? Type::Default : Type::Volume;
+			_type = TypeFromName(_desc["Type"].AsString());
 			_source = _desc["Source"];
 			_flipX = _desc["FlipX"];
 			_flipY = _desc["FlipY"];
 			_useCompression = _desc["UseCompression"];
+			_descText = _desc.Print();
 
 			_imgSrc = gFileSystem->OpenFile(_source);
 		}
 
+		if (!_imgSrc || !_imgSrc->IsOpened())
+		{
+			LOG("Error: Unable to load Texture \"%s\" from \"%s\"", m_name.c_str(), _src->Name().c_str());
+			return false;
+		}
+
+		// whole source is needed for key of derived data and for decoding
+		const uint8* _srcData = _imgSrc->Data();
+		size_t _srcSize = (size_t)(_imgSrc->Size() - _imgSrc->Tell());
+		Array<uint8> _buff;
+		if (_srcData)
+		{
+			_srcData += _imgSrc->Tell();
+		}
+		else
+		{
+			_buff.resize(_srcSize);
+			_buff.resize(_imgSrc->Read(_buff.data(), _buff.size()));
+			_srcData = _buff.data();
+			_srcSize = _buff.size();
+		}
+
+		uint64 _key = 0;
+		if (gDerivedData)
+		{
+			XxHash64 _hash(TextureData::Version);
+			_hash.Update(TypeName, strlen(TypeName));
+			_hash.Update(_descText.c_str(), _descText.length());
+			_hash.Update(&_useCompression, sizeof(_useCompression));
+			_hash.Update(_srcData, _srcSize);
+			_key = _hash.Digest();
+
+			StreamPtr _cached = gDerivedData->Find(_key);
+			if (_cached && TextureData::Parse(_cached->Data() + _cached->Tell(), (size_t)(_cached->Size() - _cached->Tell())))
+			{
+				m_data = _cached;
+				return true;
+			}
+		}
+
 		ImagePtr _img = new Image;
-		if (!_img->Load(_imgSrc))
+		if (!_img->BeginLoad(SpanStreamPtr(new SpanStream(_srcData, _srcSize, _imgSrc->Name()))))
 		{
 			LOG("Error: Unable to load Texture \"%s\" from \"%s\"", m_name.c_str(), _src->Name().c_str());
 			return false;
 		}
 
-		PixelFormat::Enum _format;
-		switch (_img->Channels())
+		MemoryStreamPtr _data = new MemoryStream(_imgSrc->Name());
+		TextureData::Build(_img->Layer(0), _img->Width(), _img->Height(), _img->Channels(), _useCompression, true, (uint32)_type, _data->Buffer());
+		if (gDerivedData)
+			gDerivedData->Store(_key, _data->Data(), _data->Buffer().size());
+
+		m_data = _data;
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool Texture::EndLoad(void)
+	{
+		if (!m_data)
+			return false;
+
+		const TextureData::Header* _header = TextureData::Parse(m_data->Data() + m_data->Tell(), (size_t)(m_data->Size() - m_data->Tell()));
+		if (!_header)
 		{
-		case 1:
-			_format = PixelFormat::R8;
-			break;
-		case 2:
-			_format = PixelFormat::RG8;
-			break;
-		case 3:
-			_format = PixelFormat::RGB8;
-			break;
-		case 4:
-			_format = PixelFormat::RGBA8;
-			break;
+			m_data = nullptr;
+			return false;
 		}
 
-		Create(_type, _useCompression ? PixelFormat::GetCompressedFormat(_format) : _format);
-		Realloc(_img->Width(), _img->Height(), _img->Depth());
-		Write(0, 0, 0, _img->Width(), _img->Height(), _img->Depth(), _format, _img->Layer(0));
+		static const PixelFormat::Enum _formats[] = { PixelFormat::R8, PixelFormat::RG8, PixelFormat::RGB8, PixelFormat::RGBA8 };
+		PixelFormat::Enum _format = _formats[_header->channels - 1];
+		if (_header->compression == TextureData::Compression::Dxt1)
+			_format = PixelFormat::DXT1;
+		else if (_header->compression == TextureData::Compression::Dxt5)
+			_format = PixelFormat::DXT5;
+
+		Create(_header->type == (uint32)Type::Volume ? Type::Volume : Type::Default, _format);
+		Realloc(_header->width, _header->height, 1, _header->levels);
+		for (uint i = 0; i < _header->levels; ++i)
+		{
+			uint _w, _h;
+			size_t _size;
+			const uint8* _level = TextureData::Level(_header, i, _w, _h, _size);
+			Write(0, 0, 0, _w, _h, 1, _format, _level, i);
+		}
 
-		// temp
-		glGenerateMipmap(GLTextureType[(uint)m_type]);
+		m_data = nullptr;
 
 		return true;
 	}
 	//----------------------------------------------------------------------------//
+	size_t Texture::GetGpuSize(void)
+	{
+		if (!m_handle)
+			return 0;
+
+		const GLPixelFormatDesc& _pf = GLPixelFormat[m_format];
+		size_t _size = 0;
+		for (uint i = 0; i < m_levels; ++i)
+		{
+			size_t _w = Max(m_size.x >> i, 1), _h = Max(m_size.y >> i, 1), _d = Max(m_depth >> i, 1u);
+			if (PixelFormat::IsCompressed(m_format))
+				_size += ((_w + 3) / 4) * ((_h + 3) / 4) * _d * _pf.bpp * 2; // 4x4 blocks
+			else
+				_size += _w * _h * _d * _pf.bpp / 8;
+		}
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+	void Texture::_Swap(Resource* _other)
+	{
+		Resource::_Swap(_other);
+
+		Texture* _tex = static_cast<Texture*>(_other);
+		std::swap(m_type, _tex->m_type);
+		std::swap(m_format, _tex->m_format);
+		std::swap(m_size, _tex->m_size);
+		std::swap(m_depth, _tex->m_depth);
+		std::swap(m_levels, _tex->m_levels);
+		std::swap(m_handle, _tex->m_handle);
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// Sprite
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	void Sprite::GetDependencies(Stream* _src, Array<Dependency>& _deps)
+	{
+		Json _desc;
+		if (_desc.Load(_src) && _desc["Texture"].IsString())
+			_deps.push_back({ Texture::TypeName, _desc["Texture"] });
+	}
+	//----------------------------------------------------------------------------//
+	bool Sprite::BeginLoad(Stream* _src)
+	{
+		ASSERT(_src != nullptr);
+
+		Json _desc;
+		if (!_desc.Load(_src) || !_desc["Texture"].IsString())
+		{
+			LOG("Error: Unable to load Sprite \"%s\" from \"%s\"", m_name.c_str(), _src->Name().c_str());
+			return false;
+		}
+
+		m_textureName = _desc["Texture"].AsString();
+		const Json& _cells = _desc["Cells"];
+		if (_cells.IsArray())
+			m_cells = { Max(_cells[0u].AsInt(), 1), Max(_cells[1u].AsInt(), 1) };
+		const Json& _border = _desc["Border"];
+		if (_border.IsArray())
+			m_border = { _border[0u].AsInt(), _border[1u].AsInt() };
+		const Json& _pivot = _desc["Pivot"];
+		if (_pivot.IsArray())
+			m_pivot = { _pivot[0u].AsFloat(), _pivot[1u].AsFloat() };
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool Sprite::EndLoad(void)
+	{
+		// texture is loaded already as dependency
+		m_texture = gResources ? gResources->GetResource<Texture>(m_textureName) : nullptr;
+		return m_texture && m_texture->GetState() != State::Failed;
+	}
+	//----------------------------------------------------------------------------//
+	void Sprite::_Swap(Resource* _other)
+	{
+		Resource::_Swap(_other);
+
+		Sprite* _sprite = static_cast<Sprite*>(_other);
+		std::swap(m_textureName, _sprite->m_textureName);
+		std::swap(m_texture, _sprite->m_texture);
+		std::swap(m_cells, _sprite->m_cells);
+		std::swap(m_border, _sprite->m_border);
+		std::swap(m_pivot, _sprite->m_pivot);
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	// OpenGL
@@ -439,42 +668,84 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
-	Engine::Engine(void)
+	Engine::Engine(bool _headless) :
+		Engine(_headless ? EngineConfig::Headless() : EngineConfig())
 	{
+	}
+	//----------------------------------------------------------------------------//
+	Engine::Engine(const EngineConfig& _config) :
+		m_config(_config),
+		m_headless(_config.headless)
+	{
+#if !E2D_DEVELOPMENT
+		m_config.hotReload = false;
+		m_config.prefetch = false;
+#endif
+
 		new Time;
 		new FileSystem;
-		new GLDevice;
+		if (!m_headless)
+			new GLDevice;
 		new ResourceCache;
+		if (m_config.hotReload)
+			new FileWatcher;
+		if (m_config.threads != 0)
+			new ThreadPool(m_config.threads < 0 ? 0 : m_config.threads);
+		if (m_config.asyncIO)
+			new AsyncIO;
+		if (m_config.prefetch)
+			new Prefetcher;
+		if (m_config.derivedData)
+			new DerivedDataCache;
 
 		System::SendEvent(SystemEvent::Startup);
 
-		// load opengl
+		if (!m_headless)
 		{
-			wglSwapIntervalEXT = reinterpret_cast<decltype(wglSwapIntervalEXT)>(wglGetProcAddress("wglSwapIntervalEXT"));
+			// load opengl
+			{
+				wglSwapIntervalEXT = reinterpret_cast<decltype(wglSwapIntervalEXT)>(wglGetProcAddress("wglSwapIntervalEXT"));
 
-		}
+			}
 
-		SetVSync(true);
+			SetVSync(true);
+		}
+		else
+			m_vsync = false;
 
 
 		m_batch = new Vertex[m_batchMaxSize];
 
 		Object::Register<Image>();
 		Object::Register<Texture>();
+		Object::Register<Sprite>();
 	}
 	//----------------------------------------------------------------------------//
 	Engine::~Engine(void)
 	{
 		// TODO
-		glFlush();
-		glFinish();
+		if (!m_headless)
+		{
+			glFlush();
+			glFinish();
+		}
 
-		System::SendEvent(SystemEvent::Shutdown, nullptr, false);
+		m_texture = nullptr;
 
+		// reverse order: workers are stopped before resources are released, resources are released before device
+		System::SendEvent(SystemEvent::Shutdown);
+
+		delete gDerivedData;
+		delete gPrefetcher;
+		delete gAsyncIO;
+		delete gThreadPool;
+		delete gFileWatcher;
 		delete gResources;
 		delete gDevice;
 		delete gFileSystem;
 		delete gTime;
+
+		delete[] m_batch;
 	}
 	//----------------------------------------------------------------------------//
 	void Engine::BeginFrame(void)
@@ -482,6 +753,9 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 		System::SendEvent(SystemEvent::BeginFrame);
 
 		m_texture = nullptr;
+		if (m_headless)
+			return;
+
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, 0);
 		glDisable(GL_TEXTURE_2D);
@@ -518,6 +792,9 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 	void Engine::Begin2D(const Vector2& _cameraPos, float _zoom)
 	{
 		Flush();
+		if (m_headless)
+			return;
+
 		glMatrixMode(GL_PROJECTION);
 		glLoadIdentity();
 		glOrtho(0, gDevice->WindowSize().x, gDevice->WindowSize().y, 0, 0, 1);
@@ -538,12 +815,16 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 			GL_QUADS, // Quads
 		};
 
-		glDrawArrays(GLPrimitveType[m_batchType], 0, m_batchSize);
+		if (!m_headless)
+			glDrawArrays(GLPrimitveType[m_batchType], 0, m_batchSize);
 		m_batchSize = 0;
 	}
 	//----------------------------------------------------------------------------//
 	void Engine::Clear(FrameBufferType::Enum _buffers, const Vector4& _color, float _depth, int _stencil)
 	{
+		if (m_headless)
+			return;
+
 		uint _mask = 0;
 
 		int _colorMask[4];
@@ -621,7 +902,11 @@ STBIDEF unsigned char *stbi_xload(char const *filename, int *x, int *y, int *fra
 		{
 			Flush();
 			m_texture = _texture;
-			if (m_texture)
+			if (m_headless)
+			{
+				// no graphics
+			}
+			else if (m_texture)
 			{
 				m_texture->_Bind(0);
 				glEnable(GL_TEXTURE_2D); // temp
@@ -5,13 +5,20 @@
 #include "Object.hpp"
 #include "System.hpp"
 
+#include "AsyncIO.hpp"
+#include "Compression.hpp"
+#include "DerivedData.hpp"
 #include "File.hpp"
+#include "FileWatcher.hpp"
+#include "Package.hpp"
+#include "Thread.hpp"
 #include "Time.hpp"
 
 #include "Json.hpp"
 #include "Math.hpp"
 
 #include "Device.hpp"
+#include "TextureData.hpp"
 
 #include "Resource.hpp"
 
@@ -92,14 +99,19 @@ namespace Easy2D
 		//!
 		uint8* Layer(uint _index);
 
-		//! \sa	Resource::Load
-		//!	jpeg, png, bmp, hdr, psd, tga, gif
-		bool Load(Stream* _src) override;
+		//! \sa	Resource::BeginLoad
+		//!	jpeg, png, bmp, hdr, psd, tga, gif or uncompressed TextureData (cooked image)
+		bool BeginLoad(Stream* _src) override;
 		//! \sa	Resource::Save
 		bool Save(Stream* _dst) override;
+		//! \sa	Resource::GetCpuSize
+		size_t GetCpuSize(void) override { return m_pixels ? (size_t)m_size.x * m_size.y * m_depth * m_channels : 0; }
+
+		//! \sa	Resource::_Swap
+		void _Swap(Resource* _other) override;
 
 	protected:
-		IntVector2 m_size;
+		IntVector2 m_size = { 0, 0 };
 		uint m_depth = 1;
 		uint m_channels = 4;
 		uint8* m_pixels = nullptr;
@@ -136,6 +148,9 @@ namespace Easy2D
 	// Texture
 	//----------------------------------------------------------------------------//
 
+	//!
+	typedef SharedPtr<class Texture> TexturePtr;
+
 	class Texture : public Resource
 	{
 	public:
@@ -147,17 +162,39 @@ namespace Easy2D
 			Volume,	//!< 3D
 		};
 
+		//!
+		~Texture(void);
+
+		//! \return Volume for "volume" (case insensitive), otherwise Default. Used for "Type" of json descriptor.
+		static Type TypeFromName(const String& _name);
+
 		//!
 		void Create(Type _type, PixelFormat::Enum _format);
 		//!
 		void Destroy(void);
 		//!
-		void Realloc(uint _width, uint _height, uint _depth);
+		void Realloc(uint _width, uint _height, uint _depth, uint _levels = 1);
 		//!
-		void Write(int _x, int _y, int _z, uint _w, uint _h, uint _d, PixelFormat::Enum _format, const void* _data);
-
-		//! \sa	Resource::Load, Image::Load
-		bool Load(Stream* _src) override;
+		void Write(int _x, int _y, int _z, uint _w, uint _h, uint _d, PixelFormat::Enum _format, const void* _data, uint _level = 0);
+
+		//! \sa	Resource::GetDependencies
+		//!	Image of json descriptor ("Source")
+		void GetDependencies(Stream* _src, Array<Dependency>& _deps) override;
+		//! \sa	Resource::BeginLoad, Image::BeginLoad
+		//!	Decoded and processed image is stored in DerivedDataCache; warm loads map it instead of decoding.
+		//!	Cooked TextureData (see AssetCooker) is used as is; type of texture is stored in it.
+		bool BeginLoad(Stream* _src) override;
+		//! Create texture from loaded data
+		bool EndLoad(void) override;
+		//! \sa Resource::GetUploadSize
+		size_t GetUploadSize(void) override { return m_data ? (size_t)(m_data->Size() - m_data->Tell()) : 0; }
+		//! \sa Resource::GetCpuSize
+		size_t GetCpuSize(void) override { return GetUploadSize(); }
+		//! Size of all levels in video memory
+		size_t GetGpuSize(void) override;
+
+		//! \sa	Resource::_Swap
+		void _Swap(Resource* _other) override;
 
 		void _Bind(uint _slot);
 
@@ -166,24 +203,97 @@ namespace Easy2D
 		PixelFormat::Enum m_format = PixelFormat::RGBA8;
 		IntVector2 m_size = { 0, 0 };
 		uint m_depth = 1;
+		uint m_levels = 1;
 		uint m_handle = 0;
+
+		StreamPtr m_data; //!< TextureData between BeginLoad and EndLoad (in memory or mapped entry of DerivedDataCache)
+	};
+
+	//----------------------------------------------------------------------------//
+	// Sprite
+	//----------------------------------------------------------------------------//
+
+	//! Grid of frames in texture. Loaded from json: { "Texture": "name", "Cells": [ x, y ], "Border": [ x, y ], "Pivot": [ x, y ] }
+	class Sprite : public Resource
+	{
+	public:
+		RTTI("Sprite");
+
+		//!
+		Texture* GetTexture(void) { return m_texture; }
+		//! Number of frames in columns and rows
+		const IntVector2& Cells(void) { return m_cells; }
+		//! Space between frames in pixels
+		const IntVector2& Border(void) { return m_border; }
+		//!
+		const Vector2& Pivot(void) { return m_pivot; }
+
+		//! \sa	Resource::GetDependencies
+		void GetDependencies(Stream* _src, Array<Dependency>& _deps) override;
+		//! \sa	Resource::BeginLoad
+		bool BeginLoad(Stream* _src) override;
+		//! Get texture from ResourceCache
+		bool EndLoad(void) override;
+
+		//! \sa	Resource::_Swap
+		void _Swap(Resource* _other) override;
+
+	protected:
+		String m_textureName;
+		TexturePtr m_texture;
+		IntVector2 m_cells = { 1, 1 };
+		IntVector2 m_border = { 0, 0 };
+		Vector2 m_pivot = { .5f, .5f };
 	};
 
 	//----------------------------------------------------------------------------//
 	// Engine
 	//----------------------------------------------------------------------------//
 
-#define gEngine Engine::Instance
+#define gEngine Engine::Get()
 
-	//!
-	class Engine : public Singleton<Engine>
+	//! Modules created by Engine. Optional modules are opt-in; development modules are never created if E2D_DEVELOPMENT is 0.
+	struct EngineConfig
+	{
+		//!	Create engine without device and graphics (simulation, server)
+		bool headless = false;
+		//!	Number of worker threads: -1 is number of cores - 1, 0 is no ThreadPool (background work runs on calling thread)
+		int threads = -1;
+		//!	Asynchronous reads of files (AsyncIO)
+		bool asyncIO = false;
+		//!	Cache of cooked data (DerivedDataCache)
+		bool derivedData = false;
+		//!	Reload changed files (FileWatcher). Development only.
+		bool hotReload = false;
+		//!	Record and prefetch files opened at startup (Prefetcher). Development only.
+		bool prefetch = false;
+
+		//!	Config of headless engine: no device and no worker threads
+		static EngineConfig Headless(void)
+		{
+			EngineConfig _config;
+			_config.headless = true;
+			_config.threads = 0;
+			return _config;
+		}
+	};
+
+	//! Engine of current context. Create Context and make it current (Context::Scope) to run several engines in one process.
+	class Engine : public ContextSingleton<Engine>
 	{
 	public:
+		//!	\param _headless create engine without device, graphics and worker threads (simulation, server)
+		Engine(bool _headless = false);
 		//!
-		Engine(void);
+		Engine(const EngineConfig& _config);
 		//!
 		~Engine(void);
 
+		//!
+		bool IsHeadless(void) { return m_headless; }
+		//!
+		const EngineConfig& GetConfig(void) { return m_config; }
+
 		// [LOOP]
 
 		//!
@@ -209,6 +319,8 @@ namespace Easy2D
 
 	protected:
 
+		EngineConfig m_config;
+		bool m_headless = false;
 		bool m_vsync = true;
 
 		PrimitiveType::Enum m_batchType = PrimitiveType::Points;
@@ -1,8 +1,22 @@
 #include "File.hpp"
-#ifdef _MSC_VER
+#include "Package.hpp"
+#include "AsyncIO.hpp"
+#include "Thread.hpp"
+#include "Math.hpp"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
 #include <direct.h>
+#include <io.h>
+#include <errno.h>
 #else
-// TODO
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <time.h>
 #endif
 
 namespace Easy2D
@@ -42,10 +56,22 @@ namespace Easy2D
 			return false;
 		}
 
-		uint _pos = Tell();
+#ifdef _WIN32
+		m_positional = CreateFileA(_name.c_str(), m_readOnly ? GENERIC_READ : (GENERIC_READ | GENERIC_WRITE), FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_positional == INVALID_HANDLE_VALUE)
+			m_positional = nullptr;
+#endif
+
+#ifdef _WIN32
+		uint64 _pos = Tell();
 		Seek(0, SeekOrigin::End);
 		m_size = Tell();
 		Seek(_pos, SeekOrigin::Set);
+#else
+		// fseek of glibc reads a block to the buffer; opening of file must not wait for the disk
+		struct stat _st;
+		m_size = fstat(fileno(m_handle), &_st) == 0 ? (uint64)_st.st_size : 0;
+#endif
 
 		return true;
 	}
@@ -57,6 +83,13 @@ namespace Easy2D
 			fclose(m_handle);
 			m_handle = nullptr;
 		}
+#ifdef _WIN32
+		if (m_positional)
+		{
+			CloseHandle(m_positional);
+			m_positional = nullptr;
+		}
+#endif
 	}
 	//----------------------------------------------------------------------------//
 	bool FileStream::EoF(void)
@@ -64,27 +97,46 @@ namespace Easy2D
 		return m_handle && feof(m_handle);
 	}
 	//----------------------------------------------------------------------------//
-	void FileStream::Seek(int _offset, SeekOrigin _origin)
+	void FileStream::Seek(int64 _offset, SeekOrigin _origin)
 	{
 		if (m_handle)
-			fseek(m_handle, _offset, (int)_origin);
+		{
+#ifdef _WIN32
+			_fseeki64(m_handle, _offset, (int)_origin);
+#else
+			fseeko(m_handle, (off_t)_offset, (int)_origin);
+#endif
+		}
 	}
 	//----------------------------------------------------------------------------//
-	uint FileStream::Tell(void)
+	uint64 FileStream::Tell(void)
 	{
-		return m_handle ? (uint)ftell(m_handle) : 0;
+		if (!m_handle)
+			return 0;
+#ifdef _WIN32
+		return (uint64)_ftelli64(m_handle);
+#else
+		return (uint64)ftello(m_handle);
+#endif
 	}
 	//----------------------------------------------------------------------------//
-	uint FileStream::Read(void* _dst, uint _size)
+	size_t FileStream::Read(void* _dst, size_t _size)
 	{
 		ASSERT(!_size || _dst);
-		return m_handle ? (uint)fread(_dst, 1, _size, m_handle) : 0;
+		return m_handle ? fread(_dst, 1, _size, m_handle) : 0;
 	}
 	//----------------------------------------------------------------------------//
-	uint FileStream::Write(const void* _src, uint _size)
+	size_t FileStream::Write(const void* _src, size_t _size)
 	{
 		ASSERT(!_size || _src);
-		return (m_handle && !m_readOnly) ? (uint)fwrite(_src, 1, _size, m_handle) : 0;
+		if (!m_handle || m_readOnly)
+			return 0;
+
+		size_t _written = fwrite(_src, 1, _size, m_handle);
+		uint64 _end = Tell();
+		if (m_size < _end)
+			m_size = _end;
+		return _written;
 	}
 	//----------------------------------------------------------------------------//
 	void FileStream::Flush(void)
@@ -93,6 +145,623 @@ namespace Easy2D
 			fflush(m_handle);
 	}
 	//----------------------------------------------------------------------------//
+	bool FileStream::Sync(void)
+	{
+		if (!m_handle || m_readOnly || fflush(m_handle))
+			return false;
+#ifdef _WIN32
+		return _commit(_fileno(m_handle)) == 0;
+#else
+		return fsync(fileno(m_handle)) == 0;
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	bool FileStream::IsPositional(void)
+	{
+#ifdef _WIN32
+		return m_positional != nullptr;
+#else
+		return m_handle != nullptr;
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	size_t FileStream::ReadAt(uint64 _offset, void* _dst, size_t _size)
+	{
+		ASSERT(!_size || _dst);
+		if (!IsPositional())
+			return 0;
+
+		uint8* _ptr = reinterpret_cast<uint8*>(_dst);
+		size_t _total = 0;
+		while (_total < _size)
+		{
+#ifdef _WIN32
+			DWORD _chunk = (DWORD)((_size - _total) < 0x40000000 ? (_size - _total) : 0x40000000), _readed = 0;
+			OVERLAPPED _ov = {};
+			_ov.Offset = (DWORD)_offset;
+			_ov.OffsetHigh = (DWORD)(_offset >> 32);
+			if (!ReadFile(m_positional, _ptr + _total, _chunk, &_readed, &_ov) || !_readed)
+				break;
+#else
+			ssize_t _readed = pread(fileno(m_handle), _ptr + _total, _size - _total, (off_t)_offset);
+			if (_readed < 0 && errno == EINTR)
+				continue;
+			if (_readed <= 0)
+				break;
+#endif
+			_total += _readed;
+			_offset += _readed;
+		}
+		return _total;
+	}
+	//----------------------------------------------------------------------------//
+	size_t FileStream::WriteAt(uint64 _offset, const void* _src, size_t _size)
+	{
+		ASSERT(!_size || _src);
+		if (!IsPositional() || m_readOnly)
+			return 0;
+
+		const uint8* _ptr = reinterpret_cast<const uint8*>(_src);
+		size_t _total = 0;
+		while (_total < _size)
+		{
+#ifdef _WIN32
+			DWORD _chunk = (DWORD)((_size - _total) < 0x40000000 ? (_size - _total) : 0x40000000), _written = 0;
+			OVERLAPPED _ov = {};
+			_ov.Offset = (DWORD)_offset;
+			_ov.OffsetHigh = (DWORD)(_offset >> 32);
+			if (!WriteFile(m_positional, _ptr + _total, _chunk, &_written, &_ov) || !_written)
+				break;
+#else
+			ssize_t _written = pwrite(fileno(m_handle), _ptr + _total, _size - _total, (off_t)_offset);
+			if (_written < 0 && errno == EINTR)
+				continue;
+			if (_written <= 0)
+				break;
+#endif
+			_total += _written;
+			_offset += _written;
+		}
+
+		uint64 _end = _offset, _prev = m_size;
+		while (_prev < _end && !m_size.compare_exchange_weak(_prev, _end));
+		return _total;
+	}
+	//----------------------------------------------------------------------------//
+	void FileStream::Advise(Access _access)
+	{
+#ifndef _WIN32
+		static const int _advice[] =
+		{
+			POSIX_FADV_NORMAL, // Normal
+			POSIX_FADV_SEQUENTIAL, // Sequential
+			POSIX_FADV_RANDOM, // Random
+		};
+
+		if (m_handle)
+			posix_fadvise(fileno(m_handle), 0, 0, _advice[(int)_access]);
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	void FileStream::Prefetch(uint64 _offset, uint64 _size)
+	{
+#ifndef _WIN32
+		if (m_handle)
+			posix_fadvise(fileno(m_handle), (off_t)_offset, (off_t)_size, POSIX_FADV_WILLNEED);
+#endif
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// MappedFileStream
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	MappedFileStream::~MappedFileStream(void)
+	{
+		Close();
+	}
+	//----------------------------------------------------------------------------//
+	bool MappedFileStream::Open(const String& _name, Access _access)
+	{
+		Close();
+
+		m_name = _name;
+
+#ifdef _WIN32
+		DWORD _flags = FILE_ATTRIBUTE_NORMAL;
+		if (_access == Access::Sequential)
+			_flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+		else if (_access == Access::Random)
+			_flags |= FILE_FLAG_RANDOM_ACCESS;
+
+		HANDLE _file = CreateFileA(_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, _flags, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+		{
+			LOG("Error: Unable to open file \"%s\"", _name.c_str());
+			return false;
+		}
+
+		LARGE_INTEGER _size;
+		if (!GetFileSizeEx(_file, &_size) || !_size.QuadPart || (uint64)_size.QuadPart > (size_t)-1)
+		{
+			CloseHandle(_file);
+			return false;
+		}
+
+		m_file = _file;
+		m_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping)
+			m_data = reinterpret_cast<const uint8*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (!m_data)
+		{
+			LOG("Error: Unable to map file \"%s\"", _name.c_str());
+			Close();
+			return false;
+		}
+
+		m_size = (uint64)_size.QuadPart;
+#else
+		int _file = open(_name.c_str(), O_RDONLY);
+		if (_file < 0)
+		{
+			LOG("Error: Unable to open file \"%s\"", _name.c_str());
+			return false;
+		}
+
+		struct stat _stat;
+		if (fstat(_file, &_stat) || !_stat.st_size || (uint64)_stat.st_size > (size_t)-1)
+		{
+			close(_file);
+			return false;
+		}
+
+		void* _data = mmap(nullptr, (size_t)_stat.st_size, PROT_READ, MAP_PRIVATE, _file, 0);
+		close(_file); // mapping holds reference to file
+
+		if (_data == MAP_FAILED)
+		{
+			LOG("Error: Unable to map file \"%s\"", _name.c_str());
+			return false;
+		}
+
+		m_data = reinterpret_cast<const uint8*>(_data);
+		m_size = (uint64)_stat.st_size;
+		Advise(_access);
+#endif
+
+		m_pos = 0;
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void MappedFileStream::Close(void)
+	{
+#ifdef _WIN32
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mapping)
+			CloseHandle(m_mapping);
+		if (m_file)
+			CloseHandle(m_file);
+		m_mapping = nullptr;
+		m_file = nullptr;
+#else
+		if (m_data)
+			munmap(const_cast<uint8*>(m_data), (size_t)m_size);
+#endif
+		m_data = nullptr;
+		m_size = 0;
+		m_pos = 0;
+	}
+	//----------------------------------------------------------------------------//
+	void MappedFileStream::Seek(int64 _offset, SeekOrigin _origin)
+	{
+		int64 _pos = _offset;
+		if (_origin == SeekOrigin::Current)
+			_pos += m_pos;
+		else if (_origin == SeekOrigin::End)
+			_pos += m_size;
+		if (_pos < 0)
+			_pos = 0;
+		else if ((uint64)_pos > m_size)
+			_pos = m_size;
+		m_pos = (uint64)_pos;
+	}
+	//----------------------------------------------------------------------------//
+	size_t MappedFileStream::Read(void* _dst, size_t _size)
+	{
+		_size = ReadAt(m_pos, _dst, _size);
+		m_pos += _size;
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+	size_t MappedFileStream::ReadAt(uint64 _offset, void* _dst, size_t _size)
+	{
+		ASSERT(!_size || _dst);
+		if (_offset >= m_size)
+			return 0;
+		if (_size > m_size - _offset)
+			_size = (size_t)(m_size - _offset);
+		memcpy(_dst, m_data + _offset, _size);
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+	void MappedFileStream::Advise(Access _access)
+	{
+#ifdef _WIN32
+		// access pattern is specified on open
+#else
+		static const int _advice[] =
+		{
+			MADV_NORMAL, // Normal
+			MADV_SEQUENTIAL, // Sequential
+			MADV_RANDOM, // Random
+		};
+
+		if (m_data)
+			madvise(const_cast<uint8*>(m_data), (size_t)m_size, _advice[(int)_access]);
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	void MappedFileStream::Prefetch(uint64 _offset, uint64 _size)
+	{
+#ifndef _WIN32
+		if (!m_data || _offset >= m_size)
+			return;
+
+		uint64 _page = (uint64)sysconf(_SC_PAGESIZE);
+		uint64 _start = _offset & ~(_page - 1);
+		uint64 _end = Min<uint64>(_offset + _size, m_size);
+		madvise(const_cast<uint8*>(m_data) + _start, (size_t)(_end - _start), MADV_WILLNEED);
+#endif
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// MemoryStream
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	MemoryStream::MemoryStream(const void* _data, size_t _size, const String& _name) :
+		m_name(_name),
+		m_data(reinterpret_cast<const uint8*>(_data), reinterpret_cast<const uint8*>(_data) + _size)
+	{
+	}
+	//----------------------------------------------------------------------------//
+	void MemoryStream::Close(void)
+	{
+		Array<uint8>().swap(m_data);
+		m_pos = 0;
+	}
+	//----------------------------------------------------------------------------//
+	void MemoryStream::Seek(int64 _offset, SeekOrigin _origin)
+	{
+		int64 _pos = _offset;
+		if (_origin == SeekOrigin::Current)
+			_pos += m_pos;
+		else if (_origin == SeekOrigin::End)
+			_pos += m_data.size();
+		if (_pos < 0)
+			_pos = 0;
+		else if ((uint64)_pos > m_data.size())
+			_pos = m_data.size();
+		m_pos = (size_t)_pos;
+	}
+	//----------------------------------------------------------------------------//
+	size_t MemoryStream::Read(void* _dst, size_t _size)
+	{
+		_size = ReadAt(m_pos, _dst, _size);
+		m_pos += _size;
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+	size_t MemoryStream::Write(const void* _src, size_t _size)
+	{
+		_size = WriteAt(m_pos, _src, _size);
+		m_pos += _size;
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+	size_t MemoryStream::ReadAt(uint64 _offset, void* _dst, size_t _size)
+	{
+		ASSERT(!_size || _dst);
+		if (_offset >= m_data.size())
+			return 0;
+		if (_size > m_data.size() - _offset)
+			_size = (size_t)(m_data.size() - _offset);
+		memcpy(_dst, m_data.data() + _offset, _size);
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+	size_t MemoryStream::WriteAt(uint64 _offset, const void* _src, size_t _size)
+	{
+		ASSERT(!_size || _src);
+		if (!_size)
+			return 0;
+		if (_offset + _size > m_data.size())
+			m_data.resize((size_t)(_offset + _size));
+		memcpy(m_data.data() + _offset, _src, _size);
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// SpanStream
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	void SpanStream::Seek(int64 _offset, SeekOrigin _origin)
+	{
+		int64 _pos = _offset;
+		if (_origin == SeekOrigin::Current)
+			_pos += m_pos;
+		else if (_origin == SeekOrigin::End)
+			_pos += m_size;
+		if (_pos < 0)
+			_pos = 0;
+		else if ((uint64)_pos > m_size)
+			_pos = m_size;
+		m_pos = (size_t)_pos;
+	}
+	//----------------------------------------------------------------------------//
+	size_t SpanStream::Read(void* _dst, size_t _size)
+	{
+		_size = ReadAt(m_pos, _dst, _size);
+		m_pos += _size;
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+	size_t SpanStream::ReadAt(uint64 _offset, void* _dst, size_t _size)
+	{
+		ASSERT(!_size || _dst);
+		if (_offset >= m_size)
+			return 0;
+		if (_size > m_size - _offset)
+			_size = (size_t)(m_size - _offset);
+		memcpy(_dst, m_data + _offset, _size);
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// BufferedStream
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	BufferedStream::BufferedStream(Stream* _source, size_t _bufferSize, Access _access) :
+		m_source(_source),
+		m_size(_source ? _source->Size() : 0),
+		m_pos(_source ? _source->Tell() : 0),
+		m_sourcePos(m_pos),
+		m_bufferSize(Clamp<size_t>(_bufferSize, MinBufferSize, MaxBufferSize)),
+		m_access(_access),
+		m_positional(_source && _source->IsPositional())
+	{
+		if (m_source)
+			m_source->Advise(_access);
+	}
+	//----------------------------------------------------------------------------//
+	BufferedStream::~BufferedStream(void)
+	{
+		Close();
+	}
+	//----------------------------------------------------------------------------//
+	void BufferedStream::Close(void)
+	{
+		if (m_readAhead)
+		{
+			std::unique_lock<std::mutex> _lock(m_readAhead->mutex);
+			if (m_readAhead->state == ReadAhead::Queued)
+				m_readAhead->state = ReadAhead::Done; // cancel
+			else
+				m_readAhead->signal.wait(_lock, [this] { return m_readAhead->state == ReadAhead::Done; });
+		}
+
+		m_readAhead = nullptr;
+		m_source = nullptr;
+		m_block = Block();
+		m_size = 0;
+		m_pos = 0;
+	}
+	//----------------------------------------------------------------------------//
+	void BufferedStream::Seek(int64 _offset, SeekOrigin _origin)
+	{
+		int64 _pos = _offset;
+		if (_origin == SeekOrigin::Current)
+			_pos += m_pos;
+		else if (_origin == SeekOrigin::End)
+			_pos += m_size;
+		if (_pos < 0)
+			_pos = 0;
+		else if ((uint64)_pos > m_size)
+			_pos = m_size;
+		m_pos = (uint64)_pos;
+	}
+	//----------------------------------------------------------------------------//
+	size_t BufferedStream::Read(void* _dst, size_t _size)
+	{
+		ASSERT(!_size || _dst);
+		uint8* _ptr = reinterpret_cast<uint8*>(_dst);
+		size_t _total = 0;
+
+		while (_total < _size && m_pos < m_size)
+		{
+			if (!m_block.Contains(m_pos))
+			{
+				if (m_positional && _size - _total >= m_bufferSize)
+				{
+					// large read goes directly to destination
+					size_t _read = m_source->ReadAt(m_pos, _ptr + _total, _size - _total);
+					if (!_read)
+						break;
+					_total += _read;
+					m_pos += _read;
+					continue;
+				}
+
+				if (!_Fill(m_pos))
+					break;
+			}
+
+			size_t _offset = (size_t)(m_pos - m_block.offset);
+			size_t _read = Min(m_block.size - _offset, _size - _total);
+			memcpy(_ptr + _total, m_block.data.data() + _offset, _read);
+			_total += _read;
+			m_pos += _read;
+		}
+
+		return _total;
+	}
+	//----------------------------------------------------------------------------//
+	void BufferedStream::Advise(Access _access)
+	{
+		m_access = _access;
+		if (m_source)
+			m_source->Advise(_access);
+	}
+	//----------------------------------------------------------------------------//
+	bool BufferedStream::_Fill(uint64 _pos)
+	{
+		if (!m_source)
+			return false;
+
+		if (m_readAhead)
+		{
+			m_readAhead->Wait();
+			if (m_readAhead->block.Contains(_pos))
+				std::swap(m_block, m_readAhead->block);
+			m_readAhead = nullptr;
+		}
+
+		if (!m_block.Contains(_pos))
+			_ReadBlock(m_block, _pos);
+
+		if (!m_block.size)
+			return false;
+
+		uint64 _next = m_block.offset + m_block.size;
+		if (m_access == Access::Sequential && m_positional && gThreadPool && _next < m_size)
+			_StartReadAhead(_next);
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void BufferedStream::_ReadBlock(Block& _block, uint64 _offset)
+	{
+		size_t _size = (size_t)Min<uint64>(m_bufferSize, m_size - _offset);
+		_block.data.resize(m_bufferSize);
+		_block.offset = _offset;
+
+		if (m_positional)
+		{
+			_block.size = m_source->ReadAt(_offset, _block.data.data(), _size);
+		}
+		else
+		{
+			if (m_sourcePos != _offset)
+				m_source->Seek(_offset, SeekOrigin::Set);
+			_block.size = m_source->Read(_block.data.data(), _size);
+			m_sourcePos = _offset + _block.size;
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void BufferedStream::_StartReadAhead(uint64 _offset)
+	{
+		SharedPtr<ReadAhead> _task = new ReadAhead;
+		_task->source = m_source;
+		_task->block.offset = _offset;
+		_task->block.size = (size_t)Min<uint64>(m_bufferSize, m_size - _offset);
+		_task->block.data.resize(m_bufferSize);
+
+		m_source->Prefetch(_offset, _task->block.size);
+		m_readAhead = _task;
+
+		gThreadPool->Push([_task]() { _task->Execute(); }, ThreadPool::High);
+	}
+	//----------------------------------------------------------------------------//
+	void BufferedStream::ReadAhead::Execute(void)
+	{
+		{
+			std::lock_guard<std::mutex> _lock(mutex);
+			if (state != Queued)
+				return; // cancelled or executed by Wait
+			state = Running;
+		}
+
+		size_t _size = source->ReadAt(block.offset, block.data.data(), block.size);
+
+		{
+			std::lock_guard<std::mutex> _lock(mutex);
+			block.size = _size;
+			state = Done;
+		}
+		signal.notify_all();
+	}
+	//----------------------------------------------------------------------------//
+	void BufferedStream::ReadAhead::Wait(void)
+	{
+		std::unique_lock<std::mutex> _lock(mutex);
+		if (state == Queued)
+		{
+			// the workers are busy (or we are the worker), read it here
+			_lock.unlock();
+			Execute();
+			return;
+		}
+		signal.wait(_lock, [this] { return state == Done; });
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// MeteredStream
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	void MeteredStream::Seek(int64 _offset, SeekOrigin _origin)
+	{
+		auto _start = std::chrono::steady_clock::now();
+		m_source->Seek(_offset, _origin);
+		_AddTime(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count());
+	}
+	//----------------------------------------------------------------------------//
+	size_t MeteredStream::Read(void* _dst, size_t _size)
+	{
+		auto _start = std::chrono::steady_clock::now();
+		size_t _read = m_source->Read(_dst, _size);
+		_AddTime(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count());
+		if (!m_direct)
+			m_bytesRead += _read;
+		return _read;
+	}
+	//----------------------------------------------------------------------------//
+	size_t MeteredStream::ReadAt(uint64 _offset, void* _dst, size_t _size)
+	{
+		auto _start = std::chrono::steady_clock::now();
+		size_t _read = m_source->ReadAt(_offset, _dst, _size);
+		_AddTime(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count());
+		if (!m_direct)
+			m_bytesRead += _read;
+		return _read;
+	}
+	//----------------------------------------------------------------------------//
+	const uint8* MeteredStream::Data(void)
+	{
+		const uint8* _data = m_source->Data();
+		if (_data && !m_direct)
+		{
+			m_direct = true;
+			m_bytesRead = m_source->Size(); // whole content is available
+		}
+		return _data;
+	}
+	//----------------------------------------------------------------------------//
+	void MeteredStream::_AddTime(float _milliseconds)
+	{
+		for (float _old = m_readTime; !m_readTime.compare_exchange_weak(_old, _old + _milliseconds);)
+			;
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	// PathUtils
@@ -107,7 +776,7 @@ namespace Easy2D
 			const char* _dev = strchr(_path, ':');
 			return _dev && (_dev[1] == '\\' || _dev[1] == '/');
 #else
-			// TODO
+			return _path[0] == '/';
 #endif
 		}
 		return false;
@@ -118,7 +787,7 @@ namespace Easy2D
 #ifdef _WIN32
 		return _ch == '\\' || _ch == '/';
 #else
-		// TODO
+		return _ch == '/';
 #endif
 	}
 	//----------------------------------------------------------------------------//
@@ -141,6 +810,26 @@ namespace Easy2D
 		return StringUtils::EmptyString;
 	}
 	//----------------------------------------------------------------------------//
+	String PathUtils::Normalize(const String& _path)
+	{
+		String _r;
+		_r.reserve(_path.length());
+		const char* _s = _path.c_str();
+
+		while (_s[0] == '.' && IsDelimeter(_s[1]))
+			_s += 2;
+
+		for (; *_s; ++_s)
+		{
+			char _ch = *_s == '\\' ? '/' : *_s;
+			if (_ch == '/' && !_r.empty() && _r.back() == '/')
+				continue;
+			_r += _ch;
+		}
+
+		return _r;
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	// FileSystem
@@ -150,6 +839,7 @@ namespace Easy2D
 	FileSystem::FileSystem(void)
 	{
 		AddPath(""); // root dir
+		m_mounts.front().root = true;
 	}
 	//----------------------------------------------------------------------------//
 	FileSystem::~FileSystem(void)
@@ -176,51 +866,207 @@ namespace Easy2D
 			_fp = _path;
 		}
 
-		if (!PathUtils::IsDelimeter(_fp.back()))
+		bool _isPackage = !StringUtils::Cmpi(PathUtils::Extension(_fp).c_str(), "pak");
+		if (!_isPackage && !PathUtils::IsDelimeter(_fp.back()))
 			_fp += "/";
 
-		uint _hash = StringUtils::Hash(_fp.c_str());
-		if (m_paths.find(_hash) == m_paths.end())
 		{
-			LOG("Add Path \"%s\" as \"%s\"", _path.c_str(), _fp.c_str());
-			m_paths[_hash] = _fp;
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			for (const auto& i : m_mounts)
+			{
+				if (!StringUtils::Cmpi(i.path.c_str(), _fp.c_str()))
+					return;
+			}
+		}
+
+		Mount _mount;
+		_mount.path = _fp;
+		if (_isPackage)
+		{
+			_mount.package = new Package;
+			if (!_mount.package->Open(_fp))
+				return;
+		}
+
+		LOG("Add Path \"%s\" as \"%s\"", _path.c_str(), _fp.c_str());
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			m_mounts.push_back(_mount);
 		}
+
+		Rescan();
 	}
 	//----------------------------------------------------------------------------//
-	bool FileSystem::FileExists(const String& _name, String* _path)
+	void FileSystem::Rescan(void)
 	{
-		if (PathUtils::IsFullPath(_name.c_str()))
+		std::lock_guard<std::mutex> _lock(m_mutex);
+
+		m_index.clear();
+		m_scannedDirs.clear();
+
+		for (size_t i = 0; i < m_mounts.size(); ++i)
 		{
-			FILE* _test = fopen(_name.c_str(), "rb");
-			if (_test)
-			{
-				fclose(_test);
-				if (_path)
-					*_path = _name;
-				return true;
-			}
+			if (m_mounts[i].package)
+				_IndexPackage((int)i);
 		}
-		else
+
+		m_stats.files = (uint)m_index.size();
+	}
+	//----------------------------------------------------------------------------//
+	Array<String> FileSystem::GetPaths(bool _withRoot)
+	{
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		Array<String> _paths;
+		for (const Mount& _mount : m_mounts)
+		{
+			if (_withRoot || !_mount.root)
+				_paths.push_back(_mount.path);
+		}
+		return _paths;
+	}
+	//----------------------------------------------------------------------------//
+	FileSystem::IndexStats FileSystem::GetIndexStats(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		return m_stats;
+	}
+	//----------------------------------------------------------------------------//
+	bool FileSystem::FileExists(const String& _name, String* _path)
+	{
+		IndexEntry _entry;
+		return _FindFile(_name, _entry, _path);
+	}
+	//----------------------------------------------------------------------------//
+	void FileSystem::Invalidate(const String& _name)
+	{
+		if (PathUtils::IsFullPath(_name.c_str()))
+			return;
+
+		String _key = IndexKey(_name);
+		size_t _sep = _key.rfind('/');
+		String _dirKey = _sep == String::npos ? StringUtils::EmptyString : _key.substr(0, _sep);
+
+		std::lock_guard<std::mutex> _lock(m_mutex);
+
+		// directory will be listed again on next lookup
+		m_index.erase(_key);
+		m_scannedDirs.erase(_dirKey);
+
+		for (size_t i = 0; i < m_mounts.size(); ++i)
 		{
-			for (const auto& i : m_paths)
+			Package* _package = m_mounts[i].package;
+			const Package::Entry* _e = _package ? _package->Find(_key) : nullptr;
+			if (_e)
 			{
-				ASSERT(PathUtils::IsFullPath(i.second.c_str()));
-				if (FileExists(i.second + _name, _path))
-					return true;
+				IndexEntry _entry = { (int)i, _package->EntryName(_e), _e->size, 0, (uint)(_e - _package->Entries().data()) };
+				_AddEntry(_key, _entry);
 			}
 		}
-		return false;
 	}
 	//----------------------------------------------------------------------------//
-	StreamPtr FileSystem::OpenFile(const String& _name, FileStream::Mode _mode)
+	bool FileSystem::GetFileInfo(const String& _name, FileInfo& _info)
+	{
+		if (PathUtils::IsFullPath(_name.c_str()))
+			return Stat(_name, _info);
+
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		const IndexEntry* _entry = _Lookup(_name);
+		if (!_entry)
+			return false;
+
+		_info.name = _entry->name;
+		_info.size = _entry->size;
+		_info.time = _entry->time;
+		_info.isDir = false;
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	StreamPtr FileSystem::OpenFile(const String& _name, FileStream::Mode _mode, Stream::Access _access)
 	{
-		FileStreamPtr _file = new FileStream;
 		String _path;
+		Mount _mount;
+		IndexEntry _index;
+		bool _exists = _FindFile(_name, _index, &_path, &_mount);
+
+		if (_exists && _mount.package)
+		{
+			if (_mode != FileStream::Mode::ReadOnly)
+			{
+				LOG("Error: File \"%s\" is in package \"%s\" and cannot be opened for writing", _name.c_str(), _mount.path.c_str());
+				return nullptr;
+			}
+
+			const Package::Entry* _entry = &_mount.package->Entries()[_index.packageEntry];
+			if (gPrefetcher)
+				gPrefetcher->OnOpen(_mount.path, _entry->offset, _entry->packedSize);
+
+			return _mount.package->OpenEntry(_entry);
+		}
 
-		if (FileExists(_name, &_path) || _mode == FileStream::Mode::Overwrite || _mode == FileStream::Mode::ReadWrite)
+		if (_exists && _mode == FileStream::Mode::ReadOnly)
+		{
+			uint64 _size = _index.size;
+			bool _sequential = _access == Stream::Access::Sequential;
+
+			if (gPrefetcher)
+				gPrefetcher->OnOpen(_path, 0, _size);
+
+			if (!_sequential || _size > SmallFileSize)
+			{
+				MappedFileStreamPtr _mapped = new MappedFileStream;
+				if (_mapped->Open(_path, _access))
+					return _mapped.Cast<Stream>();
+			}
+
+			FileStreamPtr _file = new FileStream;
+			if (!_file->Open(_path, _mode))
+				return _file.Cast<Stream>();
+
+			if (_file->Size() <= SmallFileSize)
+			{
+				// one read instead of many small ones
+				MemoryStreamPtr _mem = new MemoryStream(_path);
+				_mem->Buffer().resize((size_t)_file->Size());
+				_mem->Buffer().resize(_file->Read(_mem->Buffer().data(), _mem->Buffer().size()));
+				return _mem.Cast<Stream>();
+			}
+
+			// mapping failed
+			return new BufferedStream(_file, _sequential ? BufferedStream::MaxBufferSize : BufferedStream::DefaultBufferSize, _access);
+		}
+
+		FileStreamPtr _file = new FileStream;
+		if (_exists)
 		{
 			_file->Open(_path, _mode);
 		}
+		else if (_mode == FileStream::Mode::Overwrite || _mode == FileStream::Mode::ReadWrite)
+		{
+			if (PathUtils::IsFullPath(_name.c_str()))
+			{
+				_file->Open(_name, _mode);
+			}
+			else
+			{
+				// create new file in first directory
+				IndexEntry _entry = { -1, PathUtils::Normalize(_name), 0, 0, ~0u };
+				{
+					std::lock_guard<std::mutex> _lock(m_mutex);
+					for (size_t i = 0; i < m_mounts.size() && _entry.mount < 0; ++i)
+					{
+						if (!m_mounts[i].package)
+							_entry.mount = (int)i, _path = m_mounts[i].path + _entry.name;
+					}
+				}
+
+				if (_entry.mount >= 0 && _file->Open(_path, _mode))
+				{
+					std::lock_guard<std::mutex> _lock(m_mutex);
+					_AddEntry(IndexKey(_name), _entry);
+					m_stats.files = (uint)m_index.size();
+				}
+			}
+		}
 		else
 		{
 			LOG("Error: File \"%s\" not found", _name.c_str());
@@ -229,6 +1075,324 @@ namespace Easy2D
 		return _file.Cast<Stream>();
 	}
 	//----------------------------------------------------------------------------//
+	bool FileSystem::ListFiles(const String& _path, Array<FileInfo>& _files)
+	{
+		String _dir = _path;
+		if (!_dir.empty() && !PathUtils::IsDelimeter(_dir.back()))
+			_dir += "/";
+
+#ifdef _WIN32
+		WIN32_FIND_DATAA _fd;
+		HANDLE _find = FindFirstFileA((_dir + "*").c_str(), &_fd);
+		if (_find == INVALID_HANDLE_VALUE)
+			return false;
+
+		do
+		{
+			if (!strcmp(_fd.cFileName, ".") || !strcmp(_fd.cFileName, ".."))
+				continue;
+
+			FileInfo _info;
+			_info.name = _fd.cFileName;
+			_info.isDir = (_fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+			_info.size = ((uint64)_fd.nFileSizeHigh << 32) | _fd.nFileSizeLow;
+			_info.time = ((uint64)_fd.ftLastWriteTime.dwHighDateTime << 32) | _fd.ftLastWriteTime.dwLowDateTime;
+			_files.push_back(_info);
+
+		} while (FindNextFileA(_find, &_fd));
+
+		FindClose(_find);
+#else
+		DIR* _find = opendir(_dir.empty() ? "." : _dir.c_str());
+		if (!_find)
+			return false;
+
+		while (dirent* _de = readdir(_find))
+		{
+			if (!strcmp(_de->d_name, ".") || !strcmp(_de->d_name, ".."))
+				continue;
+
+			struct stat _stat;
+			if (fstatat(dirfd(_find), _de->d_name, &_stat, 0))
+				continue;
+
+			FileInfo _info;
+			_info.name = _de->d_name;
+			_info.isDir = S_ISDIR(_stat.st_mode);
+			_info.size = (uint64)_stat.st_size;
+			_info.time = (uint64)_stat.st_mtime;
+			_files.push_back(_info);
+		}
+
+		closedir(_find);
+#endif
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool FileSystem::Stat(const String& _path, FileInfo& _info)
+	{
+#ifdef _WIN32
+		WIN32_FILE_ATTRIBUTE_DATA _fa;
+		if (!GetFileAttributesExA(_path.c_str(), GetFileExInfoStandard, &_fa))
+			return false;
+
+		_info.isDir = (_fa.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+		_info.size = ((uint64)_fa.nFileSizeHigh << 32) | _fa.nFileSizeLow;
+		_info.time = ((uint64)_fa.ftLastWriteTime.dwHighDateTime << 32) | _fa.ftLastWriteTime.dwLowDateTime;
+#else
+		struct stat _stat;
+		if (stat(_path.c_str(), &_stat))
+			return false;
+
+		_info.isDir = S_ISDIR(_stat.st_mode);
+		_info.size = (uint64)_stat.st_size;
+		_info.time = (uint64)_stat.st_mtime;
+#endif
+		_info.name = _path;
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool FileSystem::Rename(const String& _from, const String& _to)
+	{
+#ifdef _WIN32
+		bool _ok = MoveFileExA(_from.c_str(), _to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		bool _ok = rename(_from.c_str(), _to.c_str()) == 0;
+#endif
+		if (!_ok)
+			LOG("Error: Unable to rename file \"%s\" to \"%s\"", _from.c_str(), _to.c_str());
+		return _ok;
+	}
+	//----------------------------------------------------------------------------//
+	bool FileSystem::Remove(const String& _path)
+	{
+#ifdef _WIN32
+		return DeleteFileA(_path.c_str()) != 0;
+#else
+		return unlink(_path.c_str()) == 0;
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	bool FileSystem::Touch(const String& _path)
+	{
+#ifdef _WIN32
+		HANDLE _file = CreateFileA(_path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+			return false;
+		FILETIME _time;
+		GetSystemTimeAsFileTime(&_time);
+		bool _ok = SetFileTime(_file, nullptr, nullptr, &_time) != 0;
+		CloseHandle(_file);
+		return _ok;
+#else
+		return utimensat(AT_FDCWD, _path.c_str(), nullptr, 0) == 0;
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	bool FileSystem::CreateDir(const String& _path)
+	{
+		String _dir = PathUtils::Normalize(_path);
+		while (!_dir.empty() && PathUtils::IsDelimeter(_dir.back()))
+			_dir.pop_back();
+		if (_dir.empty())
+			return true;
+
+		FileInfo _info;
+		if (Stat(_dir, _info))
+			return _info.isDir;
+
+		// create parents first
+		size_t _sep = _dir.find_last_of('/');
+		if (_sep != String::npos && _sep > 0 && !CreateDir(_dir.substr(0, _sep)))
+			return false;
+
+#ifdef _WIN32
+		bool _ok = _mkdir(_dir.c_str()) == 0 || errno == EEXIST;
+#else
+		bool _ok = mkdir(_dir.c_str(), 0777) == 0 || errno == EEXIST;
+#endif
+		if (!_ok)
+			LOG("Error: Unable to create directory \"%s\"", _dir.c_str());
+		return _ok;
+	}
+	//----------------------------------------------------------------------------//
+	String FileSystem::TempName(const String& _path)
+	{
+		static std::atomic<uint> _counter(0);
+#ifdef _WIN32
+		uint _pid = (uint)GetCurrentProcessId();
+#else
+		uint _pid = (uint)getpid();
+#endif
+		char _suffix[32];
+		snprintf(_suffix, sizeof(_suffix), ".%u.%u.tmp", _pid, _counter++);
+		return _path + _suffix;
+	}
+	//----------------------------------------------------------------------------//
+	uint64 FileSystem::FileTime(void)
+	{
+#ifdef _WIN32
+		FILETIME _time;
+		GetSystemTimeAsFileTime(&_time);
+		return ((uint64)_time.dwHighDateTime << 32) | _time.dwLowDateTime;
+#else
+		return (uint64)time(nullptr);
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	uint64 FileSystem::FileTimeSpan(double _seconds)
+	{
+#ifdef _WIN32
+		return (uint64)(_seconds * 10000000); // 100 ns
+#else
+		return (uint64)_seconds;
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	String FileSystem::IndexKey(const String& _name)
+	{
+		String _key = PathUtils::Normalize(_name);
+		for (char& c : _key)
+			c = (char)tolower((uint8)c);
+		return _key;
+	}
+	//----------------------------------------------------------------------------//
+	bool FileSystem::_FindFile(const String& _name, IndexEntry& _entry, String* _path, Mount* _mountInfo)
+	{
+		if (PathUtils::IsFullPath(_name.c_str()))
+		{
+			FileInfo _info;
+			if (!Stat(_name, _info) || _info.isDir)
+				return false;
+
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			_entry = { (int)m_mounts.size(), _name, _info.size, _info.time, ~0u };
+			if (_path)
+				*_path = _name;
+			return true;
+		}
+
+		std::lock_guard<std::mutex> _lock(m_mutex);
+		const IndexEntry* _found = _Lookup(_name);
+		if (!_found)
+			return false;
+
+		_entry = *_found;
+		const Mount& _mount = m_mounts[_entry.mount];
+		if (_path)
+			*_path = _mount.package ? _mount.path + "/" + _entry.name : _mount.path + _entry.name;
+		if (_mountInfo)
+			*_mountInfo = _mount;
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	const FileSystem::IndexEntry* FileSystem::_Lookup(const String& _name)
+	{
+		String _key = IndexKey(_name);
+		size_t _sep = _key.rfind('/');
+		String _dirKey = _sep == String::npos ? StringUtils::EmptyString : _key.substr(0, _sep);
+
+		if (m_scannedDirs.find(_dirKey) == m_scannedDirs.end())
+		{
+			String _dir = PathUtils::Normalize(_name);
+			_dir.resize(_dirKey.length());
+			_ScanDir(_dir, _dirKey);
+		}
+
+		auto _it = m_index.find(_key);
+		if (_it == m_index.end())
+		{
+			++m_stats.misses;
+			return nullptr;
+		}
+
+		++m_stats.hits;
+		return &_it->second;
+	}
+	//----------------------------------------------------------------------------//
+	void FileSystem::_ScanDir(const String& _dir, const String& _key)
+	{
+		String _prefix = _dir.empty() ? _dir : _dir + "/";
+		String _realPrefix;
+		Array<FileInfo> _files;
+		for (size_t i = 0; i < m_mounts.size(); ++i)
+		{
+			if (m_mounts[i].package)
+				continue;
+
+			// the directory can be named in another case than in the request
+			_realPrefix = _prefix;
+			_files.clear();
+			if (!ListFiles(m_mounts[i].path + _realPrefix, _files))
+			{
+				if (!_ResolveDir(m_mounts[i].path, _dir, _realPrefix) || _realPrefix == _prefix)
+					continue;
+
+				_files.clear();
+				if (!ListFiles(m_mounts[i].path + _realPrefix, _files))
+					continue;
+			}
+
+			++m_stats.scans;
+			for (const FileInfo& _file : _files)
+			{
+				if (_file.isDir)
+					continue;
+
+				IndexEntry _entry = { (int)i, _realPrefix + _file.name, _file.size, _file.time, ~0u };
+				_AddEntry(IndexKey(_entry.name), _entry);
+			}
+		}
+
+		// every mount is listed or has no such directory in any case
+		m_scannedDirs[_key] = true;
+		m_stats.files = (uint)m_index.size();
+	}
+	//----------------------------------------------------------------------------//
+	bool FileSystem::_ResolveDir(const String& _root, const String& _dir, String& _real)
+	{
+		_real.clear();
+		Array<FileInfo> _files;
+		for (size_t _start = 0; _start < _dir.length();)
+		{
+			size_t _end = _dir.find('/', _start);
+			if (_end == String::npos)
+				_end = _dir.length();
+
+			_files.clear();
+			if (!ListFiles(_root + _real, _files))
+				return false;
+
+			String _name = _dir.substr(_start, _end - _start);
+			auto _it = std::find_if(_files.begin(), _files.end(), [&_name](const FileInfo& _f) { return _f.isDir && !StringUtils::Cmpi(_f.name.c_str(), _name.c_str()); });
+			if (_it == _files.end())
+				return false;
+
+			_real += _it->name + "/";
+			_start = _end + 1;
+		}
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void FileSystem::_AddEntry(const String& _key, const IndexEntry& _entry)
+	{
+		auto _it = m_index.find(_key);
+		if (_it == m_index.end())
+			m_index[_key] = _entry;
+		else if (_it->second.mount >= _entry.mount)
+			_it->second = _entry;
+	}
+	//----------------------------------------------------------------------------//
+	void FileSystem::_IndexPackage(int _mount)
+	{
+		Package* _package = m_mounts[_mount].package;
+		for (const Package::Entry& _e : _package->Entries())
+		{
+			IndexEntry _entry = { _mount, _package->EntryName(&_e), _e.size, 0, (uint)(&_e - _package->Entries().data()) };
+			_AddEntry(IndexKey(_entry.name), _entry);
+		}
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	//
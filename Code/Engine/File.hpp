@@ -1,6 +1,8 @@
 #pragma once
 
 #include "System.hpp"
+#include <mutex>
+#include <condition_variable>
 
 namespace Easy2D
 {
@@ -18,6 +20,20 @@ namespace Easy2D
 		static String Extension(const char* _path);
 		//!
 		static String Extension(const String& _path) { return Extension(_path.c_str()); }
+		//! Replace backslashes, remove duplicate delimeters and leading "./"
+		static String Normalize(const String& _path);
+	};
+
+	//----------------------------------------------------------------------------//
+	// FileInfo
+	//----------------------------------------------------------------------------//
+
+	struct FileInfo
+	{
+		String name;
+		uint64 size = 0;
+		uint64 time = 0; //!< time of last modification (platform-specific units)
+		bool isDir = false;
 	};
 
 	//----------------------------------------------------------------------------//
@@ -39,6 +55,14 @@ namespace Easy2D
 			End = SEEK_END,
 		};
 
+		//! Expected access pattern (hint for the OS)
+		enum class Access
+		{
+			Normal,
+			Sequential,
+			Random,
+		};
+
 		//!
 		virtual const String& Name(void) = 0;
 
@@ -48,23 +72,37 @@ namespace Easy2D
 		virtual void Close(void) = 0;
 
 		//!
-		virtual uint Size(void) = 0;
+		virtual uint64 Size(void) = 0;
 		//!
 		virtual bool EoF(void) = 0;
 		//!
-		virtual void Seek(int _offset, SeekOrigin _origin = SeekOrigin::Current) = 0;
+		virtual void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) = 0;
 		//!
-		virtual uint Tell(void) = 0;
+		virtual uint64 Tell(void) = 0;
 
 		//!
 		virtual bool IsReadOnly(void) = 0;
 		//!
-		virtual uint Read(void* _dst, uint _size) = 0;
+		virtual size_t Read(void* _dst, size_t _size) = 0;
 		//!
-		virtual uint Write(const void* _src, uint _size) = 0;
+		virtual size_t Write(const void* _src, size_t _size) = 0;
 		//!
 		virtual void Flush(void) = 0;
 
+		//! \return true if stream supports ReadAt/WriteAt
+		virtual bool IsPositional(void) { return false; }
+		//! Read data at given offset. Does not use and does not change the current position; safe to call from several threads.
+		virtual size_t ReadAt(uint64 _offset, void* _dst, size_t _size) { return 0; }
+		//! Write data at given offset. Does not use and does not change the current position; safe to call from several threads.
+		virtual size_t WriteAt(uint64 _offset, const void* _src, size_t _size) { return 0; }
+
+		//! \return pointer to whole content of stream or nullptr if stream has no direct access to data.
+		virtual const uint8* Data(void) { return nullptr; }
+		//! Set expected access pattern
+		virtual void Advise(Access _access) { }
+		//! Hint that range of data will be read soon
+		virtual void Prefetch(uint64 _offset, uint64 _size) { }
+
 	protected:
 	};
 
@@ -103,52 +141,545 @@ namespace Easy2D
 		void Close(void) override;
 
 		//!
-		uint Size(void) override { return m_size; }
+		uint64 Size(void) override { return m_size; }
 		//!
 		bool EoF(void) override;
 		//!
-		void Seek(int _offset, SeekOrigin _origin = SeekOrigin::Current) override;
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override;
 		//!
-		uint Tell(void) override;
+		uint64 Tell(void) override;
 
 		//!
 		bool IsReadOnly(void) override { return m_readOnly; }
 		//!
-		uint Read(void* _dst, uint _size) override;
+		size_t Read(void* _dst, size_t _size) override;
 		//!
-		uint Write(const void* _src, uint _size) override;
+		size_t Write(const void* _src, size_t _size) override;
 		//!
 		void Flush(void) override;
+		//! Flush and wait until data is written to disk (fsync)
+		bool Sync(void);
+
+		//!
+		bool IsPositional(void) override;
+		//! \sa Stream::ReadAt
+		size_t ReadAt(uint64 _offset, void* _dst, size_t _size) override;
+		//! Positional writes bypass the buffer of stream. Call Flush before mixing them with Write.
+		size_t WriteAt(uint64 _offset, const void* _src, size_t _size) override;
+
+		//! posix_fadvise
+		void Advise(Access _access) override;
+		//! posix_fadvise(WILLNEED)
+		void Prefetch(uint64 _offset, uint64 _size) override;
+
+#ifndef _WIN32
+		//! \return file descriptor or -1
+		int Descriptor(void) { return m_handle ? fileno(m_handle) : -1; }
+#endif
 
 	protected:
 		String m_name;
 		bool m_readOnly = true;
-		uint m_size = 0;
+		std::atomic<uint64> m_size = { 0 };
 		FILE* m_handle = nullptr;
+#ifdef _WIN32
+		void* m_positional = nullptr; //!< second handle for positional I/O; does not share file pointer with m_handle
+#endif
+	};
+
+	//----------------------------------------------------------------------------//
+	// MappedFileStream
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class MappedFileStream> MappedFileStreamPtr;
+
+	//! Read-only file mapped to memory
+	class MappedFileStream : public Stream
+	{
+	public:
+		RTTI("MappedFile");
+
+		//!
+		MappedFileStream(void) = default;
+		//!
+		~MappedFileStream(void);
+
+		//!
+		const String& Name(void) override { return m_name; }
+
+		//! Map existent file. Empty files cannot be mapped.
+		bool Open(const String& _name, Access _access = Access::Normal);
+		//!
+		bool IsOpened(void) override { return m_data != nullptr; }
+		//!
+		void Close(void) override;
+
+		//!
+		uint64 Size(void) override { return m_size; }
+		//!
+		bool EoF(void) override { return m_pos >= m_size; }
+		//!
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override;
+		//!
+		uint64 Tell(void) override { return m_pos; }
+
+		//!
+		bool IsReadOnly(void) override { return true; }
+		//!
+		size_t Read(void* _dst, size_t _size) override;
+		//!
+		size_t Write(const void* _src, size_t _size) override { return 0; }
+		//!
+		void Flush(void) override { }
+
+		//!
+		bool IsPositional(void) override { return m_data != nullptr; }
+		//!
+		size_t ReadAt(uint64 _offset, void* _dst, size_t _size) override;
+
+		//!
+		const uint8* Data(void) override { return m_data; }
+		//!
+		void Advise(Access _access) override;
+		//!
+		void Prefetch(uint64 _offset, uint64 _size) override;
+
+	protected:
+		String m_name;
+		uint64 m_size = 0;
+		uint64 m_pos = 0;
+		const uint8* m_data = nullptr;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+
+	//----------------------------------------------------------------------------//
+	// MemoryStream
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class MemoryStream> MemoryStreamPtr;
+
+	//! Growable stream in memory
+	class MemoryStream : public Stream
+	{
+	public:
+		RTTI("MemoryStream");
+
+		//!
+		MemoryStream(const String& _name = StringUtils::EmptyString) : m_name(_name) { }
+		//! Copy data
+		MemoryStream(const void* _data, size_t _size, const String& _name = StringUtils::EmptyString);
+
+		//!
+		const String& Name(void) override { return m_name; }
+		//!
+		void SetName(const String& _name) { m_name = _name; }
+
+		//!
+		bool IsOpened(void) override { return true; }
+		//! Release data
+		void Close(void) override;
+
+		//!
+		uint64 Size(void) override { return m_data.size(); }
+		//!
+		bool EoF(void) override { return m_pos >= m_data.size(); }
+		//!
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override;
+		//!
+		uint64 Tell(void) override { return m_pos; }
+
+		//!
+		bool IsReadOnly(void) override { return false; }
+		//!
+		size_t Read(void* _dst, size_t _size) override;
+		//!
+		size_t Write(const void* _src, size_t _size) override;
+		//!
+		void Flush(void) override { }
+
+		//! ReadAt is safe for several threads while nobody writes.
+		bool IsPositional(void) override { return true; }
+		//!
+		size_t ReadAt(uint64 _offset, void* _dst, size_t _size) override;
+		//! Expands the stream if needed
+		size_t WriteAt(uint64 _offset, const void* _src, size_t _size) override;
+
+		//! \return pointer to data or nullptr if stream is empty. Pointer is invalidated by writing.
+		const uint8* Data(void) override { return m_data.empty() ? nullptr : m_data.data(); }
+
+		//!
+		void Reserve(size_t _size) { m_data.reserve(_size); }
+		//!
+		Array<uint8>& Buffer(void) { return m_data; }
+
+	protected:
+		String m_name;
+		Array<uint8> m_data;
+		size_t m_pos = 0;
+	};
+
+	//----------------------------------------------------------------------------//
+	// SpanStream
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class SpanStream> SpanStreamPtr;
+
+	//! Read-only stream over buffer of caller. Buffer must be alive while stream is used.
+	class SpanStream : public Stream
+	{
+	public:
+		RTTI("SpanStream");
+
+		//!
+		SpanStream(const void* _data, size_t _size, const String& _name = StringUtils::EmptyString) :
+			m_name(_name),
+			m_data(reinterpret_cast<const uint8*>(_data)),
+			m_size(_data ? _size : 0)
+		{
+		}
+
+		//!
+		const String& Name(void) override { return m_name; }
+
+		//!
+		bool IsOpened(void) override { return m_data != nullptr; }
+		//!
+		void Close(void) override { m_data = nullptr; m_size = 0; m_pos = 0; }
+
+		//!
+		uint64 Size(void) override { return m_size; }
+		//!
+		bool EoF(void) override { return m_pos >= m_size; }
+		//!
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override;
+		//!
+		uint64 Tell(void) override { return m_pos; }
+
+		//!
+		bool IsReadOnly(void) override { return true; }
+		//!
+		size_t Read(void* _dst, size_t _size) override;
+		//!
+		size_t Write(const void* _src, size_t _size) override { return 0; }
+		//!
+		void Flush(void) override { }
+
+		//!
+		bool IsPositional(void) override { return m_data != nullptr; }
+		//!
+		size_t ReadAt(uint64 _offset, void* _dst, size_t _size) override;
+
+		//!
+		const uint8* Data(void) override { return m_data; }
+
+	protected:
+		String m_name;
+		const uint8* m_data;
+		size_t m_size;
+		size_t m_pos = 0;
+	};
+
+	//----------------------------------------------------------------------------//
+	// BufferedStream
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class BufferedStream> BufferedStreamPtr;
+
+	//! Read-only buffer over other stream.
+	/*!	Small reads and seeks are served from the buffer without calls to source.
+		With sequential access the next block is read ahead on worker thread (source must support ReadAt).
+	*/
+	class BufferedStream : public Stream
+	{
+	public:
+		RTTI("BufferedStream");
+
+		enum : size_t
+		{
+			MinBufferSize = 64 * 1024,
+			DefaultBufferSize = 256 * 1024,
+			MaxBufferSize = 1024 * 1024,
+		};
+
+		//!
+		BufferedStream(Stream* _source, size_t _bufferSize = DefaultBufferSize, Access _access = Access::Sequential);
+		//!
+		~BufferedStream(void);
+
+		//!
+		const String& Name(void) override { return m_source ? m_source->Name() : StringUtils::EmptyString; }
+
+		//!
+		bool IsOpened(void) override { return m_source && m_source->IsOpened(); }
+		//!
+		void Close(void) override;
+
+		//!
+		uint64 Size(void) override { return m_size; }
+		//!
+		bool EoF(void) override { return m_pos >= m_size; }
+		//!
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override;
+		//!
+		uint64 Tell(void) override { return m_pos; }
+
+		//!
+		bool IsReadOnly(void) override { return true; }
+		//!
+		size_t Read(void* _dst, size_t _size) override;
+		//!
+		size_t Write(const void* _src, size_t _size) override { return 0; }
+		//!
+		void Flush(void) override { }
+
+		//! Positional reads go directly to source
+		bool IsPositional(void) override { return m_positional; }
+		//!
+		size_t ReadAt(uint64 _offset, void* _dst, size_t _size) override { return m_positional ? m_source->ReadAt(_offset, _dst, _size) : 0; }
+
+		//! Read-ahead is used for sequential access only
+		void Advise(Access _access) override;
+
+		//!
+		Stream* Source(void) { return m_source; }
+
+	protected:
+		//!
+		struct Block
+		{
+			Array<uint8> data;
+			uint64 offset = 0;
+			size_t size = 0;
+
+			bool Contains(uint64 _pos) { return _pos >= offset && _pos < offset + size; }
+		};
+
+		//! Block read on worker thread. Shared with task, so stream can be destroyed before the task was executed.
+		struct ReadAhead : public RefCounted
+		{
+			enum State
+			{
+				Queued,
+				Running,
+				Done,
+			};
+
+			std::mutex mutex;
+			std::condition_variable signal;
+			State state = Queued;
+			StreamPtr source;
+			Block block;
+
+			//! Read block if it was not started yet
+			void Execute(void);
+			//! Wait for block. Reads it in calling thread if task was not started.
+			void Wait(void);
+		};
+
+		//! Make block containing _pos current
+		bool _Fill(uint64 _pos);
+		//! Read block from source in calling thread
+		void _ReadBlock(Block& _block, uint64 _offset);
+		//! Start reading of next block on worker thread
+		void _StartReadAhead(uint64 _offset);
+
+		StreamPtr m_source;
+		uint64 m_size;
+		uint64 m_pos = 0;
+		uint64 m_sourcePos = 0; //!< position of non-positional source
+		size_t m_bufferSize;
+		Access m_access;
+		bool m_positional;
+		Block m_block;
+		SharedPtr<ReadAhead> m_readAhead;
+	};
+
+	//----------------------------------------------------------------------------//
+	// MeteredStream
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class MeteredStream> MeteredStreamPtr;
+
+	//! Read-only stream which forwards calls to other stream and measures reading (for instrumentation of resource loading).
+	/*!	Direct access to data (Data()) counts the rest of stream as read; time of page faults of mapped files is not measured. */
+	class MeteredStream : public Stream
+	{
+	public:
+		RTTI("MeteredStream");
+
+		//!
+		MeteredStream(Stream* _source) : m_source(_source) { ASSERT(_source != nullptr); }
+
+		//!
+		const String& Name(void) override { return m_source->Name(); }
+
+		//!
+		bool IsOpened(void) override { return m_source->IsOpened(); }
+		//!
+		void Close(void) override { m_source->Close(); }
+
+		//!
+		uint64 Size(void) override { return m_source->Size(); }
+		//!
+		bool EoF(void) override { return m_source->EoF(); }
+		//!
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override;
+		//!
+		uint64 Tell(void) override { return m_source->Tell(); }
+
+		//!
+		bool IsReadOnly(void) override { return true; }
+		//!
+		size_t Read(void* _dst, size_t _size) override;
+		//!
+		size_t Write(const void* _src, size_t _size) override { return 0; }
+		//!
+		void Flush(void) override { }
+
+		//!
+		bool IsPositional(void) override { return m_source->IsPositional(); }
+		//!
+		size_t ReadAt(uint64 _offset, void* _dst, size_t _size) override;
+
+		//!
+		const uint8* Data(void) override;
+		//!
+		void Advise(Access _access) override { m_source->Advise(_access); }
+		//!
+		void Prefetch(uint64 _offset, uint64 _size) override { m_source->Prefetch(_offset, _size); }
+
+		//!
+		Stream* Source(void) { return m_source; }
+		//! \return milliseconds spent in Read, ReadAt and Seek
+		float ReadTime(void) { return m_readTime; }
+		//!
+		uint64 BytesRead(void) { return m_bytesRead; }
+
+	protected:
+		//!
+		void _AddTime(float _milliseconds);
+
+		StreamPtr m_source;
+		std::atomic<float> m_readTime = { 0 }; //!< ReadAt can be called from several threads
+		std::atomic<uint64> m_bytesRead = { 0 };
+		bool m_direct = false; //!< Data() was used
 	};
 
 	//----------------------------------------------------------------------------//
 	// FileSystem
 	//----------------------------------------------------------------------------//
 
-#define gFileSystem Easy2D::FileSystem::Instance
+#define gFileSystem Easy2D::FileSystem::Get()
+
+	typedef SharedPtr<class Package> PackagePtr;
 
 	class FileSystem : public Module<FileSystem>
 	{
 	public:
+		//! Counters of file index
+		struct IndexStats
+		{
+			uint hits = 0; //!< lookups resolved by index
+			uint misses = 0; //!< lookups of missing files
+			uint files = 0; //!< number of indexed files
+			uint scans = 0; //!< number of directory listings
+		};
+
 		//!
 		FileSystem(void);
 		//!
 		~FileSystem(void);
 
+		//! Add search path. Path can be a directory or a package (*.pak). Paths are searched in order of addition.
 		void AddPath(const String& _path);
+		//! Drop the file index. Directories are listed again on next lookup.
+		void Rescan(void);
+		//! Drop file from index after it was changed, created or deleted
+		void Invalidate(const String& _name);
+		//! Get search paths. Paths of directories end with delimeter.
+		//!	\param _withRoot include working directory which is mounted by constructor
+		Array<String> GetPaths(bool _withRoot = true);
 
 		bool FileExists(const String& _name, String* _path = nullptr);
+		//! Get size and time of file from index. The values are actual at the time of last scan.
+		bool GetFileInfo(const String& _name, FileInfo& _info);
+
+		enum : uint64
+		{
+			SmallFileSize = 64 * 1024, //!< sequentially read files up to this size are read to memory at once
+			LargeFileSize = 16 * 1024 * 1024, //!< compressed entries of packages larger than this are decompressed on reading
+		};
 
-		StreamPtr OpenFile(const String& _name, FileStream::Mode _mode = FileStream::Mode::ReadOnly);
+		//! Open file. Stream for reading is chosen by size and access: small sequential files are read to memory, other files are mapped.
+		//!	If file cannot be mapped (address space), it is buffered with read-ahead.
+		StreamPtr OpenFile(const String& _name, FileStream::Mode _mode = FileStream::Mode::ReadOnly, Stream::Access _access = Stream::Access::Sequential);
+
+		//!
+		IndexStats GetIndexStats(void);
+
+		//! Get content of directory (not recursive)
+		static bool ListFiles(const String& _path, Array<FileInfo>& _files);
+		//! Get info of file on disk
+		static bool Stat(const String& _path, FileInfo& _info);
+		//! Rename file on disk. Existent file _to is replaced atomically.
+		static bool Rename(const String& _from, const String& _to);
+		//! Delete file on disk
+		static bool Remove(const String& _path);
+		//! Set time of last modification to current time
+		static bool Touch(const String& _path);
+		//! Create directory and its parents
+		static bool CreateDir(const String& _path);
+		//! Unique name of temporary file for _path in this process: "<path>.<pid>.<counter>.tmp"
+		static String TempName(const String& _path);
+		//! Current time in units of FileInfo::time
+		static uint64 FileTime(void);
+		//! Convert seconds to units of FileInfo::time
+		static uint64 FileTimeSpan(double _seconds);
+		//! Normalized case-folded name of file
+		static String IndexKey(const String& _name);
 
 	protected:
-		HashMap<uint, String> m_paths;
+		//!
+		struct Mount
+		{
+			String path;
+			PackagePtr package;
+			bool root = false; //!< working directory, mounted implicitly
+		};
+
+		//!
+		struct IndexEntry
+		{
+			int mount;
+			String name; //!< name relative to mount
+			uint64 size;
+			uint64 time;
+			uint packageEntry; //!< index of entry in package of mount
+		};
+
+		//! Find file and copy its entry of index. Files with full path are not indexed and have mount equal to number of mounts.
+		//! \return false if file is not found
+		bool _FindFile(const String& _name, IndexEntry& _entry, String* _path = nullptr, Mount* _mount = nullptr);
+		//! \return entry of relative file or nullptr. m_mutex must be locked.
+		const IndexEntry* _Lookup(const String& _name);
+		//! List directory in all mounts
+		void _ScanDir(const String& _dir, const String& _key);
+		//! Find directory in mount by case-insensitive comparison of each name in path
+		//! \return false if directory does not exist. _real is path relative to _root ending with delimeter.
+		static bool _ResolveDir(const String& _root, const String& _dir, String& _real);
+		//! Add entry if it has higher priority than existent
+		void _AddEntry(const String& _key, const IndexEntry& _entry);
+		//!
+		void _IndexPackage(int _mount);
+
+		Array<Mount> m_mounts;
+		HashMap<String, IndexEntry> m_index; //!< key is IndexKey of name
+		HashMap<String, bool> m_scannedDirs; //!< key is IndexKey of directory
+		IndexStats m_stats;
+		std::mutex m_mutex; //!< guards mounts and index; files can be opened from worker threads
 	};
 
 	//----------------------------------------------------------------------------//
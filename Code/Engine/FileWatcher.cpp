@@ -0,0 +1,246 @@
+#include "FileWatcher.hpp"
+#include "Time.hpp"
+#ifdef __linux__
+#include <unistd.h>
+#include <errno.h>
+#include <sys/inotify.h>
+#endif
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// FileWatcher
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	FileWatcher::FileWatcher(void)
+	{
+#ifdef __linux__
+		m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_inotify < 0)
+			LOG("Error: Unable to initialize inotify (%d), polling is used", errno);
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	FileWatcher::~FileWatcher(void)
+	{
+#ifdef __linux__
+		if (m_inotify >= 0)
+			close(m_inotify);
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	bool FileWatcher::OnEvent(int _type, void* _arg)
+	{
+		switch (_type)
+		{
+		case SystemEvent::BeginFrame:
+		{
+			Update();
+
+		} break;
+		}
+
+		return false;
+	}
+	//----------------------------------------------------------------------------//
+	bool FileWatcher::IsNative(void)
+	{
+#ifdef __linux__
+		return m_inotify >= 0;
+#else
+		return false;
+#endif
+	}
+	//----------------------------------------------------------------------------//
+	void FileWatcher::Watch(const String& _name)
+	{
+		if (IsNative() || m_pollInterval <= 0)
+			return;
+
+		String _key = FileSystem::IndexKey(_name);
+		if (m_polled.find(_key) != m_polled.end())
+			return;
+
+		PolledFile _file;
+		FileInfo _info;
+		_file.name = PathUtils::Normalize(_name);
+		if (!gFileSystem->FileExists(_name, &_file.path) || !FileSystem::Stat(_file.path, _info))
+			return; // not found or in package
+
+		_file.size = _info.size;
+		_file.time = _info.time;
+		m_polled[_key] = _file;
+	}
+	//----------------------------------------------------------------------------//
+	void FileWatcher::Update(void)
+	{
+		double _time = gTime->Current();
+
+#ifdef __linux__
+		if (m_inotify >= 0)
+		{
+			_UpdatePaths();
+			_ReadEvents();
+		}
+		else
+#endif
+		if (m_pollInterval > 0 && _time - m_lastPoll >= m_pollInterval)
+		{
+			m_lastPoll = _time;
+			_Poll();
+		}
+
+		Array<String> _changed;
+		for (auto i = m_changes.begin(); i != m_changes.end();)
+		{
+			if (_time - i->second >= m_delay)
+			{
+				_changed.push_back(i->first);
+				i = m_changes.erase(i);
+			}
+			else
+				++i;
+		}
+
+		for (const String& _name : _changed)
+		{
+			LOG("File \"%s\" was changed", _name.c_str());
+			gFileSystem->Invalidate(_name);
+			System::SendEvent(SystemEvent::FileChanged, const_cast<String*>(&_name));
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void FileWatcher::_OnChanged(const String& _name)
+	{
+		m_changes[PathUtils::Normalize(_name)] = gTime->Current();
+	}
+	//----------------------------------------------------------------------------//
+	void FileWatcher::_Poll(void)
+	{
+		for (auto& i : m_polled)
+		{
+			PolledFile& _file = i.second;
+			FileInfo _info;
+			if (!FileSystem::Stat(_file.path, _info))
+				_info.size = 0, _info.time = 0;
+
+			if (_info.size != _file.size || _info.time != _file.time)
+			{
+				_file.size = _info.size;
+				_file.time = _info.time;
+				_OnChanged(_file.name);
+			}
+		}
+	}
+	//----------------------------------------------------------------------------//
+#ifdef __linux__
+	//----------------------------------------------------------------------------//
+	void FileWatcher::_UpdatePaths(void)
+	{
+		HashMap<String, bool> _paths;
+		for (const String& _path : gFileSystem->GetPaths(false)) // working directory contains caches and build outputs
+		{
+			if (PathUtils::IsDelimeter(_path.back())) // not a package
+				_paths[_path] = true;
+		}
+
+		for (auto i = m_paths.begin(); i != m_paths.end();)
+		{
+			if (_paths.find(i->first) != _paths.end())
+			{
+				++i;
+				continue;
+			}
+
+			for (auto _root = m_roots.begin(); _root != m_roots.end();)
+			{
+				if (_root->second == i->first)
+				{
+					inotify_rm_watch(m_inotify, _root->first);
+					m_watches.erase(_root->first);
+					_root = m_roots.erase(_root);
+				}
+				else
+					++_root;
+			}
+			i = m_paths.erase(i);
+		}
+
+		for (const auto& _path : _paths)
+		{
+			if (m_paths.find(_path.first) == m_paths.end())
+			{
+				m_paths[_path.first] = true;
+				_AddDir(_path.first, StringUtils::EmptyString);
+			}
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void FileWatcher::_AddDir(const String& _root, const String& _dir)
+	{
+		const uint32 _mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+		int _wd = inotify_add_watch(m_inotify, (_root + _dir).c_str(), _mask);
+		if (_wd < 0)
+		{
+			LOG("Error: Unable to watch directory \"%s\" (%d)", (_root + _dir).c_str(), errno);
+			return;
+		}
+
+		m_watches[_wd] = _dir;
+		m_roots[_wd] = _root;
+
+		Array<FileInfo> _files;
+		FileSystem::ListFiles(_root + _dir, _files);
+		for (const FileInfo& _file : _files)
+		{
+			if (_file.isDir)
+				_AddDir(_root, _dir + _file.name + "/");
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void FileWatcher::_ReadEvents(void)
+	{
+		alignas(inotify_event) char _buff[16 * 1024];
+		for (;;)
+		{
+			ssize_t _size = read(m_inotify, _buff, sizeof(_buff));
+			if (_size <= 0)
+				break;
+
+			for (char* _p = _buff; _p < _buff + _size;)
+			{
+				inotify_event* _e = reinterpret_cast<inotify_event*>(_p);
+				_p += sizeof(inotify_event) + _e->len;
+
+				if (_e->mask & IN_IGNORED)
+				{
+					m_watches.erase(_e->wd);
+					m_roots.erase(_e->wd);
+					continue;
+				}
+
+				auto _dir = m_watches.find(_e->wd);
+				if (_dir == m_watches.end() || !_e->len)
+					continue;
+
+				String _name = _dir->second + _e->name;
+				if (_e->mask & IN_ISDIR)
+				{
+					if (_e->mask & (IN_CREATE | IN_MOVED_TO))
+						_AddDir(m_roots[_e->wd], _name + "/");
+					continue;
+				}
+
+				_OnChanged(_name);
+			}
+		}
+	}
+	//----------------------------------------------------------------------------//
+#endif
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
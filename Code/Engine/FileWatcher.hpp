@@ -0,0 +1,84 @@
+#pragma once
+
+#include "File.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// FileWatcher
+	//----------------------------------------------------------------------------//
+
+#define gFileWatcher FileWatcher::Get()
+
+	//! Watches search paths of FileSystem and sends SystemEvent::FileChanged. Created by Engine in development builds only (EngineConfig::hotReload).
+	/*!	Uses inotify where available; the working directory mounted by FileSystem is not watched, only paths added with AddPath.
+		Otherwise modification time of files registered with Watch can be polled on main thread (disabled by default, see SetPollInterval).
+		Bursts of events for one file are coalesced: the event is sent once the file was quiet for GetDelay() seconds.
+	*/
+	class FileWatcher : public Module<FileWatcher>
+	{
+	public:
+		//!
+		FileWatcher(void);
+		//!
+		~FileWatcher(void);
+
+		//!
+		bool OnEvent(int _type, void* _arg) override;
+
+		//! \return true if notifications of OS are used
+		bool IsNative(void);
+		//! Watch file. Required for polling only; with native notifications all files of search paths are watched.
+		//!	Ignored if polling is disabled.
+		void Watch(const String& _name);
+
+		//!
+		void SetDelay(double _seconds) { m_delay = _seconds; }
+		//!
+		double GetDelay(void) { return m_delay; }
+		//!	Enable polling if native notifications are not available. Files are polled every _seconds; 0 disables polling.
+		//!	Must be set before resources are loaded.
+		void SetPollInterval(double _seconds) { m_pollInterval = _seconds; }
+
+		//! Check for changes and send events. Called at the beginning of frame.
+		void Update(void);
+
+	protected:
+		//!
+		struct PolledFile
+		{
+			String name;
+			String path;
+			uint64 size;
+			uint64 time;
+		};
+
+		//!
+		void _OnChanged(const String& _name);
+		//!
+		void _Poll(void);
+#ifdef __linux__
+		//! Add watches for new search paths and remove watches of removed ones
+		void _UpdatePaths(void);
+		//! Watch directory and its subdirectories
+		void _AddDir(const String& _root, const String& _dir);
+		//!
+		void _ReadEvents(void);
+
+		int m_inotify = -1;
+		HashMap<int, String> m_watches; //!< descriptor -> directory relative to search path (empty or ends with '/')
+		HashMap<int, String> m_roots; //!< descriptor -> search path
+		HashMap<String, bool> m_paths; //!< watched search paths
+#endif
+
+		HashMap<String, double> m_changes; //!< name -> time of last event
+		HashMap<String, PolledFile> m_polled; //!< key is FileSystem::IndexKey
+		double m_delay = 0.1;
+		double m_pollInterval = 0;
+		double m_lastPoll = 0;
+	};
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
@@ -57,6 +57,11 @@ namespace Easy2D
 		}
 	}
 	//----------------------------------------------------------------------------//
+	void GLDevice::_DeleteTextures(const uint* _handles, uint _count)
+	{
+		glDeleteTextures(_count, _handles);
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	// 
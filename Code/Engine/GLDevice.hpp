@@ -10,7 +10,7 @@ namespace Easy2D
 	// GLDevice
 	//----------------------------------------------------------------------------//
 
-#define gGLDevice static_cast<GLDevice*>(GLDevice::Instance)
+#define gGLDevice static_cast<GLDevice*>(GLDevice::Get())
 
 	class GLDevice : public Device
 	{
@@ -21,6 +21,8 @@ namespace Easy2D
 		bool _Startup(void) override;
 		//!	Destroy window and graphics
 		void _Shutdown(void) override;
+		//!
+		void _DeleteTextures(const uint* _handles, uint _count) override;
 
 		SDL_GLContext m_context = nullptr;
 	};
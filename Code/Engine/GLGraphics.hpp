@@ -8,7 +8,7 @@ namespace Easy2D
 	// GLGraphics
 	//----------------------------------------------------------------------------//
 
-#define gGLGraphics static_cast<GLGraphics*>(GLGraphics::Instance)
+#define gGLGraphics static_cast<GLGraphics*>(GLGraphics::Get())
 
 	class GLGraphics : public Graphics
 	{
@@ -13,7 +13,7 @@ namespace Easy2D
 	// Graphics
 	//----------------------------------------------------------------------------//
 
-#define gGraphics Easy2D::Graphics::Instance
+#define gGraphics Easy2D::Graphics::Get()
 
 	class Graphics abstract : public Module<Graphics>
 	{
@@ -1,5 +1,14 @@
 #include "Json.hpp"
 #include "File.hpp"
+#include <locale.h>
+#include <float.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define JSON_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace Easy2D
 {
@@ -10,28 +19,28 @@ namespace Easy2D
 	//----------------------------------------------------------------------------//
 	void Tokenizer::Advance(int _num)
 	{
-		while (_num-- && *s)
+		while (_num-- && s < end && *s)
 			++s;
 	}
 	//----------------------------------------------------------------------------//
 	int Tokenizer::SkipWhiteSpace(void)
 	{
 		const char* _start = s;
-		while (AnyOf(" \t\n\r"))
-			Advance();
-		return s - _start;
+		s = SkipSpaces(s, end);
+		return (int)(s - _start);
 	}
 	//----------------------------------------------------------------------------//
 	int Tokenizer::SkipComments(void)
 	{
 		const char* _start = s;
-		if (s[0] == '/' && (s[1] == '/' || s[1] == '*')) // comment
+		const Tokenizer& _str = *this;
+		if (_str[0] == '/' && (_str[1] == '/' || _str[1] == '*')) // comment
 		{
-			if (s[1] == '/')
+			if (_str[1] == '/')
 			{
 				Advance(2);
-				while (!EoF() && !AnyOf("\n\r"))
-					Advance();
+				while (s < end && *s && *s != '\n' && *s != '\r')
+					++s;
 			}
 			else
 			{
@@ -59,7 +68,7 @@ namespace Easy2D
 	//----------------------------------------------------------------------------//
 	bool Tokenizer::IsNumber(void) const
 	{
-		return AnyOf("0123456789+-.");
+		return s < end && ((*s >= '0' && *s <= '9') || *s == '-' || *s == '+' || *s == '.');
 	}
 	//----------------------------------------------------------------------------//
 	bool Tokenizer::ParseNumber(Number& _val)
@@ -67,66 +76,147 @@ namespace Easy2D
 		if (!IsNumber())
 			return RaiseError("Expected numeric constant not found");
 
+		// up to 19 significant digits are accumulated while scanning, the rest only shifts the exponent
 		const char* _start = s;
-		if (s[0] == '-')
-			Advance();
+		bool _negative = *s == '-';
+		if (*s == '-' || *s == '+')
+			++s;
 
-		int _readed = 0, _result = 0;
-		while (AnyOf("0123456789"))
-			Advance(), _readed++;
+		uint64 _mantissa = 0;
+		int _digits = 0; // significant digits in mantissa
+		int _exponent = 0;
+		int _read = 0;
+		bool _truncated = false; // non-zero digits were dropped
+		for (; s < end && *s >= '0' && *s <= '9'; ++s, ++_read)
+		{
+			if (_digits < 19)
+			{
+				_mantissa = _mantissa * 10 + (*s - '0');
+				_digits += _mantissa != 0;
+			}
+			else
+			{
+				++_exponent;
+				_truncated |= *s != '0';
+			}
+		}
 
-		if (s[0] == '.')
+		_val.isFloat = false;
+		if (s < end && *s == '.')
 		{
 			_val.isFloat = true;
+			++s;
 
-			Advance();
-			_readed = 0;
-			while (AnyOf("0123456789"))
-				Advance(), _readed++;
+			int _fraction = 0;
+			for (; s < end && *s >= '0' && *s <= '9'; ++s, ++_fraction)
+			{
+				if (_digits < 19)
+				{
+					_mantissa = _mantissa * 10 + (*s - '0');
+					_digits += _mantissa != 0;
+					--_exponent;
+				}
+				else
+					_truncated |= *s != '0';
+			}
 
-			if (!_readed)
+			if (!_fraction)
 				return RaiseError("Wrong numeric constant");
+		}
+		else if (!_read)
+		{
+			return RaiseError("Wrong numeric constant");
+		}
 
-			if (AnyOf("eE"))
-			{
-				Advance();
-				if (!AnyOf("+-"))
-					return RaiseError("Wrong numeric constant");
-				Advance();
-
-				_readed = 0;
-				while (AnyOf("0123456789"))
-					Advance(), _readed++;
+		if (s < end && (*s == 'e' || *s == 'E'))
+		{
+			_val.isFloat = true;
+			++s;
 
-				if (!_readed)
-					return RaiseError("Wrong numeric constant");
+			bool _negativeExp = false;
+			if (s < end && (*s == '+' || *s == '-'))
+				_negativeExp = *s++ == '-';
 
-				_result = sscanf(_start, "%e", &_val.fValue);
+			int _exp = 0, _expDigits = 0;
+			for (; s < end && *s >= '0' && *s <= '9'; ++s, ++_expDigits)
+			{
+				if (_exp < 100000)
+					_exp = _exp * 10 + (*s - '0');
 			}
-			else
+			if (!_expDigits)
+				return RaiseError("Wrong numeric constant");
+
+			_exponent += _negativeExp ? -_exp : _exp;
+		}
+
+		if (!_val.isFloat)
+		{
+			if (!_exponent && _mantissa <= (_negative ? 0x8000000000000000ull : 0x7fffffffffffffffull))
 			{
-				_result = sscanf(_start, "%f", &_val.fValue);
+				int64 _value = _negative ? (int64)(0 - _mantissa) : (int64)_mantissa;
+				_val.is64 = _value < INT32_MIN || _value > INT32_MAX;
+				if (_val.is64)
+					_val.i64Value = _value;
+				else
+					_val.iValue = (int)_value;
+				return true;
 			}
+			_val.isFloat = true; // out of range of int64
 		}
-		else if (!_readed)
+
+		// one exact operation if mantissa and power of ten are representable (nearly all literals), otherwise strtod
+		static const double _pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+		double _value;
+		if (!_truncated && _mantissa <= (1ull << 53) && _exponent >= -22 && _exponent <= 22)
 		{
-			return RaiseError("Wrong numeric constant");
+			_value = (double)_mantissa;
+			_value = _exponent < 0 ? _value / _pow10[-_exponent] : _value * _pow10[_exponent];
+			if (_negative)
+				_value = -_value;
 		}
 		else
+			_value = ToDouble(_start, s);
+
+		// float is used if it keeps the value exactly, so printed double is parsed to double again
+		_val.is64 = !(_value >= -FLT_MAX && _value <= FLT_MAX) || (double)(float)_value != _value;
+		if (_val.is64)
+			_val.dValue = _value;
+		else
+			_val.fValue = (float)_value;
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	double Tokenizer::ToDouble(const char* _start, const char* _end)
+	{
+		char _buff[128];
+		String _long;
+		size_t _length = _end - _start;
+		char* _str = _buff;
+		if (_length >= sizeof(_buff))
 		{
-			_val.isFloat = false;
-			_result = sscanf(_start, "%d", &_val.iValue);
+			_long.resize(_length + 1);
+			_str = &_long[0];
 		}
+		memcpy(_str, _start, _length);
+		_str[_length] = 0;
 
-		if (!_result)
-			return RaiseError("Wrong numeric constant");
+		// strtod expects decimal point of current locale
+		char _point = *localeconv()->decimal_point;
+		if (_point != '.')
+		{
+			char* _dot = strchr(_str, '.');
+			if (_dot)
+				*_dot = _point;
+		}
 
-		return true;
+		return strtod(_str, nullptr);
 	}
 	//----------------------------------------------------------------------------//
 	bool Tokenizer::IsString(void) const
 	{
-		return *s == '"';
+		return **this == '"';
 	}
 	//----------------------------------------------------------------------------//
 	bool Tokenizer::ParseString(String& _val)
@@ -137,83 +227,184 @@ namespace Easy2D
 		Advance();
 		for (;;)
 		{
-			if (s[0] == '\\')
+			// plain characters are copied at once
+			const char* _span = FindStringEnd(s, end);
+			_val.append(s, _span - s);
+			s = _span;
+
+			if (EoF())
+				return RaiseError("EoF in string constant");
+
+			if (*s == '"')
 			{
-				switch (s[1])
-				{
-				case '\\':
-					Advance(2);
-					_val += "\\";
-					break;
-				case '/':
-					Advance(2);
-					_val += "/";
-					break;
-				case 'b':
-					Advance(2);
-					_val += "\b";
-					break;
-				case 'f':
-					Advance(2);
-					_val += "\f";
-					break;
-				case 'n':
-					Advance(2);
-					_val += "\n";
-					break;
-				case 'r':
-					Advance(2);
-					_val += "\r";
-					break;
-				case 't':
-					Advance(2);
-					_val += "\t";
-					break;
-				case 'u':
-				{
-					Advance(2);
-					char _buff[5];
-					for (uint i = 0; i < 4; ++i)
-					{
-						if (!AnyOf("0123456789abcdefABCDEF"))
-							return RaiseError("Expected numeric literal");
-						_buff[i] = *s;
-						Advance();
-					}
-					_buff[4] = 0;
-					uint16 _char = 0;
-					sscanf(_buff, "%hx", &_char);
+				Advance();
+				break;
+			}
+
+			char _char;
+			if (!ParseEscape(_char))
+				return false;
+			_val += _char;
+		}
 
-					if (_char > 0xff)
-						return RaiseError("Unicode character not supported"); // TODO:
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool Tokenizer::ParseString(char* _dst, uint& _length)
+	{
+		if (!IsString())
+			return RaiseError("Expected string constant not found");
 
-					_val += (char)_char;
+		Advance();
+		char* _start = _dst;
+		for (;;)
+		{
+			// unescaped string is not longer than source, so _dst never overtakes s
+			const char* _span = FindStringEnd(s, end);
+			if (_dst != s)
+				memmove(_dst, s, _span - s);
+			_dst += _span - s;
+			s = _span;
 
-				} break;
+			if (EoF())
+				return RaiseError("EoF in string constant");
 
-				default:
-					return RaiseError("Unknown escape sequence");
-				}
-			}
-			else if (*s == '"')
+			if (*s == '"')
 			{
 				Advance();
 				break;
 			}
-			else if (AnyOf("\n\r"))
-			{
-				return RaiseError("New line in string constant");
-			}
-			else
+
+			if (!ParseEscape(*_dst++))
+				return false;
+		}
+
+		*_dst = 0; // at most at position of closing quote
+		_length = (uint)(_dst - _start);
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool Tokenizer::ParseEscape(char& _char)
+	{
+		if (*s != '\\')
+			return RaiseError("New line in string constant");
+
+		switch ((*this)[1])
+		{
+		case '"':
+			Advance(2);
+			_char = '"';
+			break;
+		case '\\':
+			Advance(2);
+			_char = '\\';
+			break;
+		case '/':
+			Advance(2);
+			_char = '/';
+			break;
+		case 'b':
+			Advance(2);
+			_char = '\b';
+			break;
+		case 'f':
+			Advance(2);
+			_char = '\f';
+			break;
+		case 'n':
+			Advance(2);
+			_char = '\n';
+			break;
+		case 'r':
+			Advance(2);
+			_char = '\r';
+			break;
+		case 't':
+			Advance(2);
+			_char = '\t';
+			break;
+		case 'u':
+		{
+			Advance(2);
+			char _buff[5];
+			for (uint i = 0; i < 4; ++i)
 			{
-				_val.append(s, 1);
+				if (!AnyOf("0123456789abcdefABCDEF"))
+					return RaiseError("Expected numeric literal");
+				_buff[i] = *s;
 				Advance();
 			}
+			_buff[4] = 0;
+			uint16 _code = 0;
+			sscanf(_buff, "%hx", &_code);
+
+			if (_code > 0xff)
+				return RaiseError("Unicode character not supported"); // TODO:
+
+			_char = (char)_code;
+
+		} break;
+
+		default:
+			return RaiseError("Unknown escape sequence");
 		}
 
 		return true;
 	}
 	//----------------------------------------------------------------------------//
+	const char* Tokenizer::SkipSpaces(const char* _s, const char* _end)
+	{
+#ifdef JSON_SSE2
+		// most runs are short (separator or new line with indentation), so the first character is checked before loading vector
+		while (_end - _s >= 16 && (*_s == ' ' || *_s == '\t' || *_s == '\n' || *_s == '\r'))
+		{
+			__m128i _chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_s));
+			__m128i _spaces = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(_chars, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(_chars, _mm_set1_epi8('\t'))),
+				_mm_or_si128(_mm_cmpeq_epi8(_chars, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(_chars, _mm_set1_epi8('\r'))));
+			uint32 _mask = ~(uint32)_mm_movemask_epi8(_spaces) & 0xffff;
+			if (_mask)
+				return _s + FirstBit(_mask);
+			_s += 16;
+		}
+#endif
+		while (_s < _end && (*_s == ' ' || *_s == '\t' || *_s == '\n' || *_s == '\r'))
+			++_s;
+		return _s;
+	}
+	//----------------------------------------------------------------------------//
+	const char* Tokenizer::FindStringEnd(const char* _s, const char* _end)
+	{
+#ifdef JSON_SSE2
+		while (_end - _s >= 16)
+		{
+			__m128i _chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_s));
+			__m128i _special = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(_chars, _mm_set1_epi8('"')), _mm_cmpeq_epi8(_chars, _mm_set1_epi8('\\'))),
+				_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(_chars, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(_chars, _mm_set1_epi8('\r'))), _mm_cmpeq_epi8(_chars, _mm_setzero_si128())));
+			uint32 _mask = (uint32)_mm_movemask_epi8(_special);
+			if (_mask)
+				return _s + FirstBit(_mask);
+			_s += 16;
+		}
+#endif
+		while (_s < _end && *_s != '"' && *_s != '\\' && *_s != '\n' && *_s != '\r' && *_s)
+			++_s;
+		return _s;
+	}
+	//----------------------------------------------------------------------------//
+	uint Tokenizer::FirstBit(uint32 _mask)
+	{
+		ASSERT(_mask != 0);
+#ifdef _MSC_VER
+		unsigned long _index;
+		_BitScanForward(&_index, _mask);
+		return (uint)_index;
+#else
+		return (uint)__builtin_ctz(_mask);
+#endif
+	}
+	//----------------------------------------------------------------------------//
 	bool Tokenizer::RaiseError(const char* _error)
 	{
 		e = _error;
@@ -264,9 +455,12 @@ namespace Easy2D
 		if (IsString())
 			_String() = _other._String();
 		else if (IsNode())
+		{
 			_Node() = _other._Node();
+			_BuildIndex();
+		}
 		else
-			m_int = _other.m_int;
+			m_int64 = _other.m_int64;
 	}
 	//----------------------------------------------------------------------------//
 	Json::Json(Json&& _temp)
@@ -275,9 +469,12 @@ namespace Easy2D
 		if (IsString())
 			_String() = std::move(_temp._String());
 		else if (IsNode())
+		{
 			_Node() = std::move(_temp._Node());
+			std::swap(m_index, _temp.m_index);
+		}
 		else
-			m_int = _temp.m_int;
+			m_int64 = _temp.m_int64;
 	}
 	//----------------------------------------------------------------------------//
 	Json::Json(bool _value)
@@ -304,6 +501,16 @@ namespace Easy2D
 		_Float() = _value;
 	}
 	//----------------------------------------------------------------------------//
+	Json::Json(int64 _value)
+	{
+		SetInt64(_value);
+	}
+	//----------------------------------------------------------------------------//
+	Json::Json(double _value)
+	{
+		SetDouble(_value);
+	}
+	//----------------------------------------------------------------------------//
 	Json::Json(const char* _value)
 	{
 		SetType(Type::String);
@@ -328,22 +535,32 @@ namespace Easy2D
 		if (IsString())
 			_String() = _rhs._String();
 		else if (IsNode())
+		{
 			_Node() = _rhs._Node();
+			_BuildIndex();
+		}
 		else
-			m_int = _rhs.m_int;
+			m_int64 = _rhs.m_int64;
 
 		return *this;
 	}
 	//----------------------------------------------------------------------------//
 	Json& Json::operator = (Json&& _rhs)
 	{
+		if (&_rhs == this)
+			return *this;
+
 		SetType(_rhs.m_type);
 		if (IsString())
 			_String() = std::move(_rhs._String());
 		else if (IsNode())
+		{
 			_Node() = std::move(_rhs._Node());
+			_DropIndex();
+			std::swap(m_index, _rhs.m_index);
+		}
 		else
-			m_int = _rhs.m_int;
+			m_int64 = _rhs.m_int64;
 		return *this;
 	}
 	//----------------------------------------------------------------------------//
@@ -358,8 +575,11 @@ namespace Easy2D
 				break;
 			case Type::Array:
 			case Type::Object:
+				_DropIndex();
 				_Node().~Node();
 				break;
+			default:
+				break;
 			};
 
 			m_type = _type;
@@ -372,9 +592,10 @@ namespace Easy2D
 			case Type::Array:
 			case Type::Object:
 				new(&_Node()) Node();
+				m_index = nullptr;
 				break;
 			default:
-				m_int = 0;
+				m_int64 = 0;
 				break;
 			};
 		}
@@ -412,6 +633,12 @@ namespace Easy2D
 			return m_int != 0;
 		case Type::Float:
 			return m_flt != 0;
+		case Type::Int64:
+			return m_int64 != 0;
+		case Type::Double:
+			return m_dbl != 0;
+		default:
+			break;
 		}
 		return false;
 	}
@@ -426,6 +653,12 @@ namespace Easy2D
 			return m_int;
 		case Type::Float:
 			return (int)m_flt;
+		case Type::Int64:
+			return (int)m_int64;
+		case Type::Double:
+			return (int)m_dbl;
+		default:
+			break;
 		}
 		return 0;
 	}
@@ -440,6 +673,52 @@ namespace Easy2D
 			return (float)m_int;
 		case Type::Float:
 			return m_flt;
+		case Type::Int64:
+			return (float)m_int64;
+		case Type::Double:
+			return (float)m_dbl;
+		default:
+			break;
+		}
+		return 0;
+	}
+	//----------------------------------------------------------------------------//
+	int64 Json::AsInt64(void) const
+	{
+		switch (m_type)
+		{
+		case Type::Null:
+		case Type::Bool:
+		case Type::Int:
+			return m_int;
+		case Type::Float:
+			return (int64)m_flt;
+		case Type::Int64:
+			return m_int64;
+		case Type::Double:
+			return (int64)m_dbl;
+		default:
+			break;
+		}
+		return 0;
+	}
+	//----------------------------------------------------------------------------//
+	double Json::AsDouble(void) const
+	{
+		switch (m_type)
+		{
+		case Type::Null:
+		case Type::Bool:
+		case Type::Int:
+			return m_int;
+		case Type::Float:
+			return m_flt;
+		case Type::Int64:
+			return (double)m_int64;
+		case Type::Double:
+			return m_dbl;
+		default:
+			break;
 		}
 		return 0;
 	}
@@ -456,8 +735,18 @@ namespace Easy2D
 			return StringUtils::Format("%d", m_int);
 		case Type::Float:
 			return StringUtils::Format("%f", m_flt);
+		case Type::Int64:
+			return StringUtils::Format("%lld", (long long)m_int64);
+		case Type::Double:
+		{
+			String _str;
+			_PrintDouble(_str, m_dbl);
+			return _str;
+		}
 		case Type::String:
 			return _String();
+		default:
+			break;
 		}
 		return "";
 	}
@@ -469,6 +758,8 @@ namespace Easy2D
 		case Type::Array:
 		case Type::Object:
 			return (uint)_Node().size();
+		default:
+			break;
 		}
 		return 0;
 	}
@@ -476,7 +767,10 @@ namespace Easy2D
 	Json& Json::Clear(void)
 	{
 		if (IsNode())
+		{
 			_Node().clear();
+			_DropIndex();
+		}
 		return *this;
 	}
 	//----------------------------------------------------------------------------//
@@ -556,6 +850,11 @@ namespace Easy2D
 			return *_value;
 
 		_Node().push_back({ _key, Null });
+		if (m_index)
+			_AddToIndex((uint32)_Node().size() - 1, _Hash(_key));
+		else if (_Node().size() > IndexThreshold)
+			_BuildIndex();
+
 		return _Node().back().second;
 	}
 	//----------------------------------------------------------------------------//
@@ -567,28 +866,20 @@ namespace Easy2D
 	//----------------------------------------------------------------------------//
 	Json* Json::Find(const String& _key)
 	{
-		if (IsObject())
-		{
-			for (auto& i : _Node())
-			{
-				if (i.first == _key)
-					return &i.second;
-			}
-		}
-		return nullptr;
+		if (!IsObject())
+			return nullptr;
+
+		if (!m_index && _Node().size() > IndexThreshold)
+			_BuildIndex(); // discarded by Container()
+
+		uint32 _pos = _Position(_key);
+		return _pos != ~0u ? &_Node()[_pos].second : nullptr;
 	}
 	//----------------------------------------------------------------------------//
 	const Json* Json::Find(const String& _key) const
 	{
-		if (IsObject())
-		{
-			for (auto& i : _Node())
-			{
-				if (i.first == _key)
-					return &i.second;
-			}
-		}
-		return nullptr;
+		uint32 _pos = IsObject() ? _Position(_key) : ~0u;
+		return _pos != ~0u ? &_Node()[_pos].second : nullptr;
 	}
 	//----------------------------------------------------------------------------//
 	Json& Json::Set(const String& _key, const Json& _value)
@@ -599,23 +890,19 @@ namespace Easy2D
 	//----------------------------------------------------------------------------//
 	bool Json::Erase(const String& _key)
 	{
-		if (IsObject())
-		{
-			for (auto i = _Node().begin(); i != _Node().end(); ++i)
-			{
-				if (i->first == _key)
-				{
-					_Node().erase(i);
-					return true;
-				}
-			}
-		}
-		return false;
+		if (!Find(_key)) // builds index if needed
+			return false;
+
+		_Node().erase(_Node().begin() + _Position(_key));
+		if (m_index)
+			_BuildIndex(); // positions of next keys are changed
+		return true;
 	}
 	//----------------------------------------------------------------------------//
 	Json::Node& Json::Container(void)
 	{
 		SetType(Type::Object);
+		_DropIndex();
 		return _Node();
 	}
 	//----------------------------------------------------------------------------//
@@ -624,10 +911,93 @@ namespace Easy2D
 		return IsObject() ? _Node() : EmptyObject._Node();
 	}
 	//----------------------------------------------------------------------------//
-	bool Json::Parse(const char* _str, String* _error)
+	uint32 Json::_Hash(const String& _key)
+	{
+		return Checksum::Fnv1a(_key.data(), _key.length());
+	}
+	//----------------------------------------------------------------------------//
+	uint32 Json::_Position(const String& _key) const
+	{
+		const Node& _node = _Node();
+		if (m_index)
+		{
+			uint32 _hash = _Hash(_key);
+			uint32 _mask = (uint32)m_index->slots.size() - 1;
+			for (uint32 i = _hash & _mask;; i = (i + 1) & _mask)
+			{
+				const Index::Slot& _slot = m_index->slots[i];
+				if (!_slot.pos)
+					return ~0u;
+				if (_slot.hash == _hash && _node[_slot.pos - 1].first == _key)
+					return _slot.pos - 1;
+			}
+		}
+
+		for (uint32 i = 0, _size = (uint32)_node.size(); i < _size; ++i)
+		{
+			if (_node[i].first == _key)
+				return i;
+		}
+		return ~0u;
+	}
+	//----------------------------------------------------------------------------//
+	void Json::_BuildIndex(void)
+	{
+		if (!IsObject() || _Node().size() <= IndexThreshold)
+		{
+			_DropIndex();
+			return;
+		}
+
+		if (!m_index)
+			m_index = new Index;
+
+		uint32 _size = 64;
+		while (_size < _Node().size() * 2)
+			_size *= 2;
+		m_index->slots.assign(_size, { 0, 0 });
+		m_index->used = 0;
+
+		for (uint32 i = 0, _num = (uint32)_Node().size(); i < _num; ++i)
+			_AddToIndex(i, _Hash(_Node()[i].first));
+	}
+	//----------------------------------------------------------------------------//
+	void Json::_AddToIndex(uint32 _pos, uint32 _hash)
+	{
+		if ((m_index->used + 1) * 2 > m_index->slots.size())
+		{
+			_BuildIndex(); // adds all keys including new one
+			return;
+		}
+
+		const Node& _node = _Node();
+		uint32 _mask = (uint32)m_index->slots.size() - 1;
+		for (uint32 i = _hash & _mask;; i = (i + 1) & _mask)
+		{
+			Index::Slot& _slot = m_index->slots[i];
+			if (!_slot.pos)
+			{
+				_slot.hash = _hash;
+				_slot.pos = _pos + 1;
+				++m_index->used;
+				return;
+			}
+			if (_slot.hash == _hash && _node[_slot.pos - 1].first == _node[_pos].first)
+				return; // duplicate key, the first one is found as by linear search
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void Json::_DropIndex(void)
+	{
+		delete m_index;
+		m_index = nullptr;
+	}
+	//----------------------------------------------------------------------------//
+	bool Json::Parse(const char* _str, size_t _length, String* _error)
 	{
 		Tokenizer _stream;
 		_stream.s = _str;
+		_stream.end = _str + _length;
 
 		if (!_Parse(_stream))
 		{
@@ -651,42 +1021,100 @@ namespace Easy2D
 		return _str;
 	}
 	//----------------------------------------------------------------------------//
-	bool Json::Load(Stream* _src)
+	bool Json::ParseBinary(const void* _data, size_t _size, String* _error)
 	{
-		ASSERT(_src != nullptr);
-
-		Array<char> _data;
-		_data.resize(_src->Size());
-		_src->Read(_data.data(), (uint)_data.size());
+		if (!IsBinary(_data, _size))
+		{
+			if (_error)
+				*_error = " : JSON error : Invalid binary header";
+			return false;
+		}
 
-		String _err;
-		if (!Parse(_data.data(), &_err))
+		const uint8* _ptr = reinterpret_cast<const uint8*>(_data) + sizeof(uint32);
+		if (!_ParseBinary(_ptr, _ptr + _size - sizeof(uint32), 0))
 		{
-			LOG("%s%s", _src->Name().c_str(), _err.c_str());
+			if (_error)
+				*_error = StringUtils::Format("(%u) : JSON error : Invalid binary data", (uint)(_ptr - reinterpret_cast<const uint8*>(_data)));
+			SetNull();
 			return false;
 		}
+
 		return true;
 	}
 	//----------------------------------------------------------------------------//
-	void Json::Save(Stream* _dst)
+	void Json::PrintBinary(Array<uint8>& _dst) const
 	{
-		ASSERT(_dst != nullptr);
-
-		String _str = Print();
-		_dst->Write(_str.c_str(), (uint)_str.length());
+		uint32 _magic = BinaryMagic;
+		_dst.insert(_dst.end(), reinterpret_cast<const uint8*>(&_magic), reinterpret_cast<const uint8*>(&_magic + 1));
+		_PrintBinary(_dst);
 	}
 	//----------------------------------------------------------------------------//
-	bool Json::_Parse(Tokenizer& _str)
+	bool Json::IsBinary(const void* _data, size_t _size)
 	{
-		//http://www.json.org/json-ru.html
-
-		_str.NextToken();
-
-		if (_str.e)
+		uint32 _magic;
+		if (!_data || _size < sizeof(_magic))
 			return false;
-
-		if (_str.EoF()) // eof
-		{
+		memcpy(&_magic, _data, sizeof(_magic));
+		return _magic == BinaryMagic;
+	}
+	//----------------------------------------------------------------------------//
+	bool Json::Load(Stream* _src)
+	{
+		ASSERT(_src != nullptr);
+
+		String _err;
+		size_t _size = (size_t)(_src->Size() - _src->Tell());
+		const char* _mem = reinterpret_cast<const char*>(_src->Data());
+		Array<char> _data;
+
+		if (_mem) // parse in place
+		{
+			_mem += _src->Tell();
+		}
+		else
+		{
+			_data.resize(_size);
+			_size = _src->Read(_data.data(), _size);
+			_mem = _data.data();
+		}
+
+		bool _result = IsBinary(_mem, _size) ? ParseBinary(_mem, _size, &_err) : Parse(_mem, _size, &_err);
+		if (!_result)
+		{
+			LOG("%s%s", _src->Name().c_str(), _err.c_str());
+			return false;
+		}
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void Json::Save(Stream* _dst)
+	{
+		ASSERT(_dst != nullptr);
+
+		String _str = Print();
+		_dst->Write(_str.c_str(), _str.length());
+	}
+	//----------------------------------------------------------------------------//
+	void Json::SaveBinary(Stream* _dst)
+	{
+		ASSERT(_dst != nullptr);
+
+		Array<uint8> _data;
+		PrintBinary(_data);
+		_dst->Write(_data.data(), _data.size());
+	}
+	//----------------------------------------------------------------------------//
+	bool Json::_Parse(Tokenizer& _str)
+	{
+		//http://www.json.org/json-ru.html
+
+		_str.NextToken();
+
+		if (_str.e)
+			return false;
+
+		if (_str.EoF()) // eof
+		{
 			SetNull();
 		}
 		else if (_str.IsNumber()) // int or float
@@ -695,8 +1123,12 @@ namespace Easy2D
 			if (!_str.ParseNumber(_val))
 				return false;
 
-			if (_val.isFloat)
+			if (_val.isFloat && _val.is64)
+				SetDouble(_val.dValue);
+			else if (_val.isFloat)
 				SetFloat(_val.fValue);
+			else if (_val.is64)
+				SetInt64(_val.i64Value);
 			else
 				SetInt(_val.iValue);
 		}
@@ -727,6 +1159,8 @@ namespace Easy2D
 			SetType(Type::Array);
 			for (;;)
 			{
+				_str.NextToken();
+
 				if (_str[0] == ']')
 				{
 					++_str;
@@ -747,7 +1181,7 @@ namespace Easy2D
 		else if (_str[0] == '{') // object
 		{
 			++_str;
-			SetType(Type::Object);
+			SetType(Type::Object)._DropIndex();
 			for (;;)
 			{
 				_str.NextToken();
@@ -755,6 +1189,7 @@ namespace Easy2D
 				if (_str[0] == '}')
 				{
 					++_str;
+					_BuildIndex();
 					break;
 				}
 
@@ -806,6 +1241,12 @@ namespace Easy2D
 		case Type::Float:
 			_dst += StringUtils::Format("%f", _Float());
 			break;
+		case Type::Int64:
+			_dst += StringUtils::Format("%lld", (long long)m_int64);
+			break;
+		case Type::Double:
+			_PrintDouble(_dst, m_dbl);
+			break;
 		case Type::String:
 		{
 			_PrintString(_dst, _String(), _depth);
@@ -884,6 +1325,31 @@ namespace Easy2D
 		}
 	}
 	//----------------------------------------------------------------------------//
+	void Json::_PrintDouble(String& _dst, double _value)
+	{
+		if (!(_value >= -DBL_MAX && _value <= DBL_MAX))
+		{
+			_dst += "null"; // json has no infinity and nan
+			return;
+		}
+
+		char _buff[64];
+		char _point = *localeconv()->decimal_point;
+		for (int _precision = 15; _precision <= 17; ++_precision)
+		{
+			snprintf(_buff, sizeof(_buff), "%.*g", _precision, _value);
+			char* _dot = strchr(_buff, _point);
+			if (_dot)
+				*_dot = '.';
+			if (Tokenizer::ToDouble(_buff, _buff + strlen(_buff)) == _value)
+				break;
+		}
+
+		_dst += _buff;
+		if (!strpbrk(_buff, ".e"))
+			_dst += ".0"; // parsed as number with fraction
+	}
+	//----------------------------------------------------------------------------//
 	void Json::_PrintString(String& _dst, const String& _src, int _depth)
 	{
 		_dst += "\"";
@@ -901,6 +1367,494 @@ namespace Easy2D
 		_dst += "\"";
 	}
 	//----------------------------------------------------------------------------//
+	bool Json::_ParseBinary(const uint8*& _data, const uint8* _end, int _depth)
+	{
+		if (_data >= _end || _depth > 256)
+			return false;
+
+		uint32 _size = 0;
+		Type _type = (Type)*_data++;
+		switch (_type)
+		{
+		case Type::Null:
+			SetNull();
+			return true;
+		case Type::Bool:
+			if (_data >= _end)
+				return false;
+			SetBool(*_data++ != 0);
+			return true;
+		case Type::Int64:
+		case Type::Double:
+			if (_end - _data < (ptrdiff_t)sizeof(uint64))
+				return false;
+			SetType(_type);
+			memcpy(&m_int64, _data, sizeof(uint64));
+			_data += sizeof(uint64);
+			return true;
+		case Type::Int:
+		case Type::Float:
+		case Type::String:
+		case Type::Array:
+		case Type::Object:
+			if (_end - _data < (ptrdiff_t)sizeof(uint32))
+				return false;
+			memcpy(&_size, _data, sizeof(uint32)); // value of number or length
+			_data += sizeof(uint32);
+			break;
+		default:
+			return false;
+		}
+
+		if (_type == Type::Int)
+		{
+			SetInt((int)_size);
+		}
+		else if (_type == Type::Float)
+		{
+			SetType(Type::Float);
+			memcpy(&m_flt, &_size, sizeof(float));
+		}
+		else if (_type == Type::String)
+		{
+			if ((size_t)(_end - _data) < _size)
+				return false;
+			SetType(Type::String)._String().assign(reinterpret_cast<const char*>(_data), _size);
+			_data += _size;
+		}
+		else
+		{
+			if ((size_t)(_end - _data) < _size) // each item is at least one byte
+				return false;
+
+			Node& _node = SetType(_type)._Node();
+			_DropIndex();
+			_node.resize(_size);
+			for (KeyValue& _item : _node)
+			{
+				if (_type == Type::Object)
+				{
+					uint32 _length;
+					if (_end - _data < (ptrdiff_t)sizeof(uint32))
+						return false;
+					memcpy(&_length, _data, sizeof(uint32));
+					_data += sizeof(uint32);
+					if ((size_t)(_end - _data) < _length)
+						return false;
+					_item.first.assign(reinterpret_cast<const char*>(_data), _length);
+					_data += _length;
+				}
+				if (!_item.second._ParseBinary(_data, _end, _depth + 1))
+					return false;
+			}
+			_BuildIndex();
+		}
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void Json::_PrintBinary(Array<uint8>& _dst) const
+	{
+		_dst.push_back((uint8)m_type);
+
+		uint32 _value = 0;
+		switch (m_type)
+		{
+		case Type::Null:
+			return;
+		case Type::Bool:
+			_dst.push_back(_Bool() ? 1 : 0);
+			return;
+		case Type::Int64:
+		case Type::Double:
+		{
+			const uint8* _ptr = reinterpret_cast<const uint8*>(&m_int64);
+			_dst.insert(_dst.end(), _ptr, _ptr + sizeof(uint64));
+		} return;
+		case Type::Int:
+			_value = (uint32)_Int();
+			break;
+		case Type::Float:
+			memcpy(&_value, &m_flt, sizeof(float));
+			break;
+		case Type::String:
+			_value = (uint32)_String().length();
+			break;
+		default:
+			_value = (uint32)_Node().size();
+			break;
+		}
+
+		const uint8* _ptr = reinterpret_cast<const uint8*>(&_value);
+		_dst.insert(_dst.end(), _ptr, _ptr + sizeof(uint32));
+
+		if (m_type == Type::String)
+		{
+			_dst.insert(_dst.end(), _String().begin(), _String().end());
+		}
+		else if (IsNode())
+		{
+			for (const KeyValue& _item : _Node())
+			{
+				if (m_type == Type::Object)
+				{
+					uint32 _length = (uint32)_item.first.length();
+					_ptr = reinterpret_cast<const uint8*>(&_length);
+					_dst.insert(_dst.end(), _ptr, _ptr + sizeof(uint32));
+					_dst.insert(_dst.end(), _item.first.begin(), _item.first.end());
+				}
+				_item.second._PrintBinary(_dst);
+			}
+		}
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// JsonDocument::Value
+	//----------------------------------------------------------------------------//
+
+	const JsonDocument::Value JsonDocument::Value::Null;
+
+	//----------------------------------------------------------------------------//
+	const JsonDocument::Value& JsonDocument::Value::Get(const char* _key, uint _length) const
+	{
+		const Value* _value = Find(_key, _length);
+		return _value ? *_value : Null;
+	}
+	//----------------------------------------------------------------------------//
+	const JsonDocument::Value* JsonDocument::Value::Find(const char* _key, uint _length) const
+	{
+		if (!IsObject())
+			return nullptr;
+
+		if (m_size > Json::IndexThreshold)
+		{
+			const uint32* _index = _Index();
+			uint32 _mask = _IndexSize(m_size) - 1;
+			for (uint32 _slot = Checksum::Fnv1a(_key, _length) & _mask; _index[_slot]; _slot = (_slot + 1) & _mask)
+			{
+				const Value& _item = m_items[_index[_slot] - 1];
+				if (_item.m_keyLength == _length && !memcmp(_item.m_key, _key, _length))
+					return &_item;
+			}
+			return nullptr;
+		}
+
+		for (const Value* i = m_items, *e = m_items + m_size; i < e; ++i)
+		{
+			if (i->m_keyLength == _length && !memcmp(i->m_key, _key, _length))
+				return i;
+		}
+		return nullptr;
+	}
+	//----------------------------------------------------------------------------//
+	Json JsonDocument::Value::ToJson(void) const
+	{
+		switch (m_type)
+		{
+		case Json::Type::String:
+			return Json(String(m_str, m_size));
+
+		case Json::Type::Array:
+		{
+			Json _json(Json::Type::Array);
+			_json.Resize(m_size);
+			for (uint i = 0; i < m_size; ++i)
+				_json[i] = m_items[i].ToJson();
+			return _json;
+		}
+
+		case Json::Type::Object:
+		{
+			Json _json(Json::Type::Object);
+			for (Iterator i = Begin(), e = End(); i < e; ++i)
+				_json.GetOrAdd(String(i->m_key, i->m_keyLength)) = i->ToJson();
+			return _json;
+		}
+
+		default: // scalars
+			break;
+		}
+
+		return _Scalar();
+	}
+	//----------------------------------------------------------------------------//
+	Json JsonDocument::Value::_Scalar(void) const
+	{
+		switch (m_type)
+		{
+		case Json::Type::Bool:
+			return Json(m_bool);
+		case Json::Type::Int:
+			return Json(m_int);
+		case Json::Type::Float:
+			return Json(m_flt);
+		case Json::Type::Int64:
+			return Json(m_int64);
+		case Json::Type::Double:
+			return Json(m_dbl);
+		default:
+			break;
+		}
+		return Json(m_type); // empty string or container, without allocations
+	}
+	//----------------------------------------------------------------------------//
+	uint32 JsonDocument::Value::_IndexSize(uint32 _size)
+	{
+		uint32 _slots = 16;
+		while (_slots < _size * 2)
+			_slots <<= 1;
+		return _slots;
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// JsonDocument
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	bool JsonDocument::Parse(const char* _str, size_t _length, String* _error)
+	{
+		return Parse(Array<char>(_str, _str + _length), _error);
+	}
+	//----------------------------------------------------------------------------//
+	bool JsonDocument::Parse(Array<char>&& _text, String* _error)
+	{
+		Clear();
+		m_text = std::move(_text);
+
+		Tokenizer _stream;
+		_stream.s = m_text.data();
+		_stream.end = m_text.data() + m_text.size();
+
+		bool _result = _Parse(_stream, m_root);
+		if (!_result && _error)
+		{
+			int _l, _c;
+			Tokenizer::GetErrorPos(m_text.data(), _stream.s, _l, _c);
+			*_error = StringUtils::Format("(%d:%d) : JSON error : %s", _l, _c, _stream.e);
+		}
+
+		Array<Value>().swap(m_stack); // it can be as large as the largest container
+		if (!_result)
+			Clear();
+
+		return _result;
+	}
+	//----------------------------------------------------------------------------//
+	bool JsonDocument::Load(Stream* _src)
+	{
+		ASSERT(_src != nullptr);
+
+		Array<char> _text((size_t)(_src->Size() - _src->Tell()));
+		_text.resize(_src->Read(_text.data(), _text.size()));
+
+		if (Json::IsBinary(_text.data(), _text.size()))
+		{
+			LOG("Error: %s is binary json, document can be parsed only from text", _src->Name().c_str());
+			return false;
+		}
+
+		String _err;
+		if (!Parse(std::move(_text), &_err))
+		{
+			LOG("%s%s", _src->Name().c_str(), _err.c_str());
+			return false;
+		}
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void JsonDocument::Clear(void)
+	{
+		for (uint8* _block : m_blocks)
+			delete[] _block;
+		m_blocks.clear();
+		m_ptr = nullptr;
+		m_blockEnd = nullptr;
+		m_arenaSize = 0;
+
+		Array<char>().swap(m_text);
+		m_stack.clear();
+		m_root = Value();
+	}
+	//----------------------------------------------------------------------------//
+	bool JsonDocument::_Parse(Tokenizer& _str, Value& _dst)
+	{
+		_str.NextToken();
+
+		if (_str.e)
+			return false;
+
+		if (_str.EoF()) // eof
+		{
+			_dst.m_type = Json::Type::Null;
+		}
+		else if (_str.IsNumber()) // int or float
+		{
+			Tokenizer::Number _val;
+			if (!_str.ParseNumber(_val))
+				return false;
+
+			if (_val.isFloat && _val.is64)
+				_dst.m_type = Json::Type::Double, _dst.m_dbl = _val.dValue;
+			else if (_val.isFloat)
+				_dst.m_type = Json::Type::Float, _dst.m_flt = _val.fValue;
+			else if (_val.is64)
+				_dst.m_type = Json::Type::Int64, _dst.m_int64 = _val.i64Value;
+			else
+				_dst.m_type = Json::Type::Int, _dst.m_int = _val.iValue;
+		}
+		else if (_str.IsString()) // string, unescaped in place of its literal
+		{
+			char* _text = const_cast<char*>(_str.s); // m_text
+			if (!_str.ParseString(_text, _dst.m_size))
+				return false;
+			_dst.m_type = Json::Type::String;
+			_dst.m_str = _text;
+		}
+		else if (_str.Cmpi("true", 4)) // bool
+		{
+			_str += 4;
+			_dst.m_type = Json::Type::Bool;
+			_dst.m_bool = true;
+		}
+		else if (_str.Cmpi("false", 5))	// bool
+		{
+			_str += 5;
+			_dst.m_type = Json::Type::Bool;
+			_dst.m_bool = false;
+		}
+		else if (_str.Cmpi("null", 4)) // null
+		{
+			_str += 4;
+			_dst.m_type = Json::Type::Null;
+		}
+		else if (_str[0] == '[') // array
+		{
+			++_str;
+			size_t _first = m_stack.size();
+			for (;;)
+			{
+				_str.NextToken();
+
+				if (_str[0] == ']')
+				{
+					++_str;
+					break;
+				}
+
+				if (_str.EoF())
+					return _str.RaiseError("Unexpectd EoF");
+
+				Value _item; // m_stack can grow while it is parsed
+				if (!_Parse(_str, _item))
+					return false;
+				m_stack.push_back(_item);
+
+				_str.NextToken();
+				if (_str[0] == ',') // divisor (not necessarily) 
+					++_str;
+			}
+			_dst.m_type = Json::Type::Array;
+			_EndNode(_dst, _first);
+		}
+		else if (_str[0] == '{') // object
+		{
+			++_str;
+			size_t _first = m_stack.size();
+			for (;;)
+			{
+				_str.NextToken();
+
+				if (_str[0] == '}')
+				{
+					++_str;
+					break;
+				}
+
+				if (_str.EoF())
+					return _str.RaiseError("Unexpectd EoF");
+
+				Value _item;
+				char* _key = const_cast<char*>(_str.s); // m_text
+				if (!_str.ParseString(_key, _item.m_keyLength))
+					return false;
+				_item.m_key = _key;
+
+				_str.NextToken();
+				if (_str[0] == ':')
+					++_str;
+				else
+					return _str.RaiseError("Expected ':' not found");
+
+				if (!_Parse(_str, _item))
+					return false;
+				m_stack.push_back(_item);
+
+				_str.NextToken();
+				if (_str[0] == ',') // divisor (not necessarily) 
+					++_str;
+			}
+			_dst.m_type = Json::Type::Object;
+			_EndNode(_dst, _first);
+		}
+		else
+		{
+			return _str.RaiseError("Unknown symbol");
+		}
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void JsonDocument::_EndNode(Value& _dst, size_t _first)
+	{
+		uint32 _size = (uint32)(m_stack.size() - _first);
+		uint32 _slots = _dst.m_type == Json::Type::Object && _size > Json::IndexThreshold ? Value::_IndexSize(_size) : 0;
+
+		_dst.m_size = _size;
+		_dst.m_items = nullptr;
+		if (!_size)
+			return;
+
+		Value* _items = reinterpret_cast<Value*>(_Allocate(_size * sizeof(Value) + _slots * sizeof(uint32)));
+		memcpy(_items, m_stack.data() + _first, _size * sizeof(Value));
+		m_stack.resize(_first);
+		_dst.m_items = _items;
+
+		if (_slots)
+		{
+			uint32* _index = reinterpret_cast<uint32*>(_items + _size);
+			memset(_index, 0, _slots * sizeof(uint32));
+			for (uint32 i = 0; i < _size; ++i)
+			{
+				uint32 _slot = Checksum::Fnv1a(_items[i].m_key, _items[i].m_keyLength) & (_slots - 1);
+				while (_index[_slot])
+					_slot = (_slot + 1) & (_slots - 1);
+				_index[_slot] = i + 1;
+			}
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void* JsonDocument::_Allocate(size_t _size)
+	{
+		_size = (_size + 7) & ~(size_t)7;
+		if ((size_t)(m_blockEnd - m_ptr) < _size)
+		{
+			size_t _blockSize = m_arenaSize < MinBlockSize ? MinBlockSize : (m_arenaSize > MaxBlockSize ? MaxBlockSize : m_arenaSize);
+			if (_blockSize < _size)
+				_blockSize = _size;
+
+			m_ptr = new uint8[_blockSize];
+			m_blockEnd = m_ptr + _blockSize;
+			m_blocks.push_back(m_ptr);
+			m_arenaSize += _blockSize;
+		}
+
+		void* _ptr = m_ptr;
+		m_ptr += _size;
+		return _ptr;
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	//
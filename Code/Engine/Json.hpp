@@ -10,29 +10,33 @@ namespace Easy2D
 	// Tokenizer
 	//----------------------------------------------------------------------------//
 
-	//!
+	//! Scanner of json text. Whitespace and contents of strings are scanned by 16 bytes with SSE2 where it is available.
 	struct Tokenizer
 	{
 		//!
 		struct Number
 		{
 			bool isFloat = false;
+			bool is64 = false; //!< value needs 64 bits: integer out of range of int (i64Value) or number which float does not represent exactly (dValue)
 			union
 			{
 				int iValue = 0;
 				float fValue;
+				int64 i64Value;
+				double dValue;
 			};
 		};
 
 		const char* s = nullptr;
+		const char* end = nullptr; //!< end of source
 		const char* e = nullptr;
 
 		//!
-		operator char(void) const { return *s; }
+		operator char(void) const { return s < end ? *s : 0; }
 		//!
-		char operator * (void) const { return *s; }
+		char operator * (void) const { return s < end ? *s : 0; }
 		//!
-		char operator [] (int _index) const { return s[_index]; }
+		char operator [] (int _index) const { return s + _index < end ? s[_index] : 0; }
 		//!
 		const char* operator ++ (void) { Advance(); return s; }
 		//!
@@ -52,28 +56,41 @@ namespace Easy2D
 
 		//!
 		bool IsNumber(void) const;
-		//!
+		//! Parse number in one pass. Result is correctly rounded and does not depend on locale.
 		bool ParseNumber(Number& _val);
+		//! Locale-independent strtod of [_start, _end)
+		static double ToDouble(const char* _start, const char* _end);
 
 		//!
 		bool IsString(void) const;
 		//!
 		bool ParseString(String& _val);
+		//! Parse string to _dst, which can point to the source itself: unescaped string is not longer than its literal. Result is null-terminated.
+		bool ParseString(char* _dst, uint& _length);
+		//! Parse escape sequence at backslash. Other characters which stop plain part of string are new lines, they are error.
+		bool ParseEscape(char& _char);
 
 		//!
-		bool EoF(void) const { return !*s; }
+		bool EoF(void) const { return s >= end || !*s; }
 
 		//!
-		bool Cmp(const char* _rhs, int _num) const { return strncmp(s, _rhs, _num) == 0; }
+		bool Cmp(const char* _rhs, int _num) const { return end - s >= _num && strncmp(s, _rhs, _num) == 0; }
 		//!
-		bool Cmpi(const char* _rhs, int _num) const { return strnicmp(s, _rhs, _num) == 0; }
+		bool Cmpi(const char* _rhs, int _num) const { return end - s >= _num && strnicmp(s, _rhs, _num) == 0; }
 		//!
-		bool AnyOf(const char* _cset) const { return *s && strchr(_cset, *s); }
+		bool AnyOf(const char* _cset) const { return s < end && *s && strchr(_cset, *s); }
 
 		//!
 		bool RaiseError(const char* _error);
 		//!
 		static void GetErrorPos(const char* _start, const char* _pos, int& _line, int& _column);
+
+		//! \return first character of [_s, _end) which is not space, tab or new line, or _end
+		static const char* SkipSpaces(const char* _s, const char* _end);
+		//! \return first quote, backslash, new line or zero character of [_s, _end), or _end
+		static const char* FindStringEnd(const char* _s, const char* _end);
+		//! \return index of lowest set bit of non-zero mask
+		static uint FirstBit(uint32 _mask);
 	};
 
 	//----------------------------------------------------------------------------//
@@ -94,6 +111,8 @@ namespace Easy2D
 			String,
 			Array,
 			Object,
+			Int64, //!< integer out of range of int
+			Double, //!< number which needs more precision than float
 		};
 
 		typedef Pair<String, Json> KeyValue;
@@ -122,6 +141,10 @@ namespace Easy2D
 		//!
 		Json(float _value);
 		//!
+		Json(int64 _value);
+		//!
+		Json(double _value);
+		//!
 		Json(const char* _value);
 		//!
 		Json(const String& _value);
@@ -138,11 +161,11 @@ namespace Easy2D
 		//!
 		bool IsBool(void) const { return m_type == Type::Bool; }
 		//!
-		bool IsInt(void) const { return m_type == Type::Int; }
+		bool IsInt(void) const { return m_type == Type::Int || m_type == Type::Int64; }
 		//!
-		bool IsFloat(void) const { return m_type == Type::Int; }
+		bool IsFloat(void) const { return m_type == Type::Float || m_type == Type::Double; }
 		//!
-		bool IsNumeric(void) const { return m_type == Type::Int || m_type == Type::Float; }
+		bool IsNumeric(void) const { return IsInt() || IsFloat(); }
 		//!
 		bool IsString(void) const { return m_type == Type::String; }
 		//!
@@ -163,6 +186,10 @@ namespace Easy2D
 		//!
 		Json& SetFloat(float _value) { SetType(Type::Float).m_flt = _value; return *this; }
 		//!
+		Json& SetInt64(int64 _value) { SetType(Type::Int64).m_int64 = _value; return *this; }
+		//!
+		Json& SetDouble(double _value) { SetType(Type::Double).m_dbl = _value; return *this; }
+		//!
 		Json& SetString(const String& _value) { SetType(Type::String)._String() = _value; return *this; }
 		//!
 		Json& SetString(String&& _value) { SetType(Type::String)._String() = std::move(_value); return *this; }
@@ -178,6 +205,10 @@ namespace Easy2D
 		//!
 		float AsFloat(void) const;
 		//!
+		int64 AsInt64(void) const;
+		//!
+		double AsDouble(void) const;
+		//!
 		String AsString(void) const;
 
 		//!
@@ -250,7 +281,7 @@ namespace Easy2D
 
 		//!Find value of key
 		Json* Find(const String& _key);
-		//!Find value of key
+		//!Find value of key. Does not change the object, so it can be called from several threads.
 		const Json* Find(const String& _key) const;
 
 		//!	Add key with value to object. \return this
@@ -258,7 +289,7 @@ namespace Easy2D
 		//! Remove key from object
 		bool Erase(const String& _key);
 
-		//!
+		//! Node can be changed directly, so hash index of keys is discarded; it is built again by next non-const lookup.
 		Node& Container(void);
 		//!
 		const Node& Container(void) const;
@@ -272,14 +303,31 @@ namespace Easy2D
 		ConstIterator End(void) const { return Container().end(); }
 
 		//!
-		bool Parse(const char* _str, String* _error = nullptr);
+		bool Parse(const char* _str, String* _error = nullptr) { return Parse(_str, strlen(_str), _error); }
+		//! Parse string of given length. String is not required to be null-terminated.
+		bool Parse(const char* _str, size_t _length, String* _error = nullptr);
 		//!
 		String Print(void) const;
 
+		//! Binary form: BinaryMagic, then values as type byte and payload. Strings and containers are prefixed by 32-bit length, Int64 and Double have 64-bit payload.
+		bool ParseBinary(const void* _data, size_t _size, String* _error = nullptr);
 		//!
+		void PrintBinary(Array<uint8>& _dst) const;
+		//! \return true if data starts with BinaryMagic
+		static bool IsBinary(const void* _data, size_t _size);
+
+		//! Load text or binary form
 		bool Load(Stream* _src);
 		//!
 		void Save(Stream* _dst);
+		//!
+		void SaveBinary(Stream* _dst);
+
+		enum : uint32
+		{
+			BinaryMagic = 0x4a443245, //!< "E2DJ"
+			IndexThreshold = 16, //!< objects with more keys have hash index, smaller ones are searched linearly
+		};
 
 		//!
 		static const Json Null;
@@ -289,12 +337,43 @@ namespace Easy2D
 		static const Json EmptyObject;
 
 	protected:
+		//! Open addressing hash table of positions of keys of large object. Order of keys is kept by Node.
+		struct Index
+		{
+			//!
+			struct Slot
+			{
+				uint32 hash;
+				uint32 pos; //!< position in Node + 1, 0 = empty slot
+			};
+
+			Array<Slot> slots; //!< size is power of two, at most half is used
+			uint32 used = 0;
+		};
+
+		//!
+		static uint32 _Hash(const String& _key);
+		//! Find key with index or linear search. \return position of key in Node or ~0u
+		uint32 _Position(const String& _key) const;
+		//! Build index if object has more than IndexThreshold keys, otherwise delete it
+		void _BuildIndex(void);
+		//! Add key at position of Node to index. Index grows when half of it is used.
+		void _AddToIndex(uint32 _pos, uint32 _hash);
+		//!
+		void _DropIndex(void);
+
 		//!
 		bool _Parse(Tokenizer& _str);
 		//!
 		void _Print(String& _dst, int _depth) const;
 		//!
 		static void _PrintString(String& _dst, const String& _src, int _depth);
+		//! Print shortest form of double which is parsed to the same value
+		static void _PrintDouble(String& _dst, double _value);
+		//!
+		bool _ParseBinary(const uint8*& _data, const uint8* _end, int _depth);
+		//!
+		void _PrintBinary(Array<uint8>& _dst) const;
 
 		//!
 		bool& _Bool(void) { return m_bool; }
@@ -321,11 +400,199 @@ namespace Easy2D
 		union
 		{
 			bool m_bool;
-			int m_int = 0;
+			int m_int;
 			float m_flt;
-			uint8 m_str[sizeof(String)];
-			uint8 m_node[sizeof(Node)];
+			int64 m_int64 = 0;
+			double m_dbl;
+			alignas(String) uint8 m_str[sizeof(String)];
+			struct
+			{
+				alignas(Node) uint8 m_node[sizeof(Node)];
+				Index* m_index; //!< hash index of large object or nullptr
+			};
+		};
+	};
+
+	//----------------------------------------------------------------------------//
+	// JsonDocument
+	//----------------------------------------------------------------------------//
+
+	//! Read-only json document for large files.
+	/*!	Document owns the text and arena of values. Strings and keys are unescaped in place and point to the text,
+		elements of arrays and objects are allocated from the arena, so parsing does not allocate memory for each value
+		and destruction frees a few blocks instead of walking the tree. Values have the read-only interface of Json;
+		ToJson() makes a copy which can be changed.
+	*/
+	class JsonDocument : public NonCopyable
+	{
+	public:
+		//!
+		class Value
+		{
+		public:
+			typedef const Value* Iterator;
+
+			//!
+			Json::Type Type(void) const { return m_type; }
+			//!
+			bool IsNull(void) const { return m_type == Json::Type::Null; }
+			//!
+			bool IsBool(void) const { return m_type == Json::Type::Bool; }
+			//!
+			bool IsInt(void) const { return m_type == Json::Type::Int || m_type == Json::Type::Int64; }
+			//!
+			bool IsFloat(void) const { return m_type == Json::Type::Float || m_type == Json::Type::Double; }
+			//!
+			bool IsNumeric(void) const { return IsInt() || IsFloat(); }
+			//!
+			bool IsString(void) const { return m_type == Json::Type::String; }
+			//!
+			bool IsArray(void) const { return m_type == Json::Type::Array; }
+			//!
+			bool IsObject(void) const { return m_type == Json::Type::Object; }
+			//!
+			bool IsNode(void) const { return m_type == Json::Type::Array || m_type == Json::Type::Object; }
+
+			//!
+			bool AsBool(void) const { return _Scalar().AsBool(); }
+			//!
+			int AsInt(void) const { return _Scalar().AsInt(); }
+			//!
+			float AsFloat(void) const { return _Scalar().AsFloat(); }
+			//!
+			int64 AsInt64(void) const { return _Scalar().AsInt64(); }
+			//!
+			double AsDouble(void) const { return _Scalar().AsDouble(); }
+			//!
+			String AsString(void) const { return IsString() ? String(m_str, m_size) : _Scalar().AsString(); }
+			//! \return null-terminated string in the text of document or empty string if value is not string. String can contain zero characters, see Length().
+			const char* CStr(void) const { return IsString() ? m_str : ""; }
+			//! \return length of string
+			uint Length(void) const { return IsString() ? m_size : 0; }
+
+			//!
+			operator bool(void) const { return AsBool(); }
+			//!
+			operator int(void) const { return AsInt(); }
+			//!
+			operator uint(void) const { return AsInt(); }
+			//!
+			operator float(void) const { return AsFloat(); }
+			//!
+			operator String(void) const { return AsString(); }
+
+			//! \return number of elements of array or object
+			uint Size(void) const { return IsNode() ? m_size : 0; }
+
+			//!
+			const Value& operator [] (uint _index) const { return Get(_index); }
+			//!
+			const Value& operator [] (int _index) const { return Get(_index); }
+			//!
+			const Value& Get(uint _index) const { return _index < Size() ? m_items[_index] : Null; }
+
+			//!
+			const Value& operator [] (const String& _key) const { return Get(_key.c_str(), (uint)_key.length()); }
+			//!
+			const Value& operator [] (const char* _key) const { return Get(_key, (uint)strlen(_key)); }
+			//! Get value of key
+			const Value& Get(const char* _key, uint _length) const;
+			//! Find value of key
+			const Value* Find(const String& _key) const { return Find(_key.c_str(), (uint)_key.length()); }
+			//! Find value of key
+			const Value* Find(const char* _key, uint _length) const;
+
+			//! \return key of element of object or nullptr
+			const char* Key(void) const { return m_key; }
+			//!
+			uint KeyLength(void) const { return m_keyLength; }
+
+			//! Elements of array or object
+			Iterator Begin(void) const { return IsNode() ? m_items : nullptr; }
+			//!
+			Iterator End(void) const { return IsNode() ? m_items + m_size : nullptr; }
+
+			//! Copy value to Json
+			Json ToJson(void) const;
+
+			//!
+			static const Value Null;
+
+		protected:
+			friend class JsonDocument;
+
+			//! \return Json with the same scalar value
+			Json _Scalar(void) const;
+			//! Index is placed in arena after elements of objects with more than Json::IndexThreshold keys
+			const uint32* _Index(void) const { return reinterpret_cast<const uint32*>(m_items + m_size); }
+			//! Number of slots of index of object with _size keys
+			static uint32 _IndexSize(uint32 _size);
+
+			Json::Type m_type = Json::Type::Null;
+			uint32 m_size = 0; //!< length of string or number of elements
+			uint32 m_keyLength = 0;
+			const char* m_key = nullptr; //!< key of element of object
+			union
+			{
+				bool m_bool;
+				int m_int;
+				float m_flt;
+				int64 m_int64 = 0;
+				double m_dbl;
+				const char* m_str;
+				const Value* m_items;
+			};
+		};
+
+		enum : size_t
+		{
+			MinBlockSize = 64 * 1024,
+			MaxBlockSize = 1024 * 1024, //!< blocks grow twice up to this size, so there are few of them and unused tail is small
 		};
+
+		//!
+		JsonDocument(void) = default;
+		//!
+		~JsonDocument(void) { Clear(); }
+
+		//! Parse copy of text
+		bool Parse(const char* _str, size_t _length, String* _error = nullptr);
+		//! Parse text and keep it; strings of values point to it
+		bool Parse(Array<char>&& _text, String* _error = nullptr);
+		//! Load text form. Binary form is parsed to Json already without copies of strings, so it is not supported.
+		bool Load(Stream* _src);
+		//! Free the text and arena
+		void Clear(void);
+
+		//!
+		const Value& Root(void) const { return m_root; }
+		//!
+		const Value& operator [] (const char* _key) const { return m_root[_key]; }
+		//!
+		const Value& operator [] (const String& _key) const { return m_root[_key]; }
+		//!
+		const Value& operator [] (uint _index) const { return m_root[_index]; }
+		//!
+		const Value& operator [] (int _index) const { return m_root[_index]; }
+
+		//! \return size of the text and arena
+		size_t MemoryUsage(void) const { return m_text.capacity() + m_arenaSize; }
+
+	protected:
+		//!
+		bool _Parse(Tokenizer& _str, Value& _dst);
+		//! Move elements of container from m_stack to arena
+		void _EndNode(Value& _dst, size_t _first);
+		//! \return memory of arena aligned to 8 bytes
+		void* _Allocate(size_t _size);
+
+		Array<char> m_text;
+		Value m_root;
+		Array<Value> m_stack; //!< elements of containers being parsed
+		Array<uint8*> m_blocks;
+		uint8* m_ptr = nullptr; //!< free memory of last block
+		uint8* m_blockEnd = nullptr;
+		size_t m_arenaSize = 0;
 	};
 
 	//----------------------------------------------------------------------------//
@@ -1,4 +1,5 @@
 #include "Object.hpp"
+#include <mutex>
 
 namespace Easy2D
 {
@@ -15,7 +16,12 @@ namespace Easy2D
 	//----------------------------------------------------------------------------//
 	RefCounted::~RefCounted(void)
 	{
-		ASSERT(m_rc == nullptr);
+		if (m_rc) // not deleted by Release (object on stack or member)
+		{
+			ASSERT(m_rc->ref == 0);
+			m_rc->object = nullptr;
+			m_rc->Release();
+		}
 	}
 	//----------------------------------------------------------------------------//
 	void RefCounted::AddRef(void)
@@ -33,6 +39,8 @@ namespace Easy2D
 	{
 		m_rc->object = nullptr;
 		m_rc->Release();
+		m_rc = nullptr;
+		delete this;
 	}
 	//----------------------------------------------------------------------------//
 
@@ -42,10 +50,14 @@ namespace Easy2D
 
 	HashMap<uint, Object::TypeInfo> Object::s_types;
 
+	//! types can be registered by engines of several contexts at once
+	static std::mutex s_typesMutex;
+
 	//----------------------------------------------------------------------------//
 	Object::TypeInfo* Object::GetOrCreateTypeInfo(const char* _name)
 	{
 		uint _type = StringUtils::Hash(_name);
+		std::lock_guard<std::mutex> _lock(s_typesMutex);
 		auto _iter = s_types.find(_type);
 		if (_iter != s_types.end())
 			return &_iter->second;
@@ -59,19 +71,36 @@ namespace Easy2D
 		return &_typeInfo;
 	}
 	//----------------------------------------------------------------------------//
+	Object::TypeInfo* Object::_Register(const char* _name, FactoryPfn _factory, uint _flags)
+	{
+		TypeInfo* _info = GetOrCreateTypeInfo(_name);
+		std::lock_guard<std::mutex> _lock(s_typesMutex); // read by GetFactory on worker threads
+		_info->Factory = _factory;
+		_info->flags |= _flags;
+		return _info;
+	}
+	//----------------------------------------------------------------------------//
 	Object::TypeInfo* Object::GetTypeInfo(uint _type)
 	{
+		std::lock_guard<std::mutex> _lock(s_typesMutex);
 		auto _iter = s_types.find(_type);
 		if (_iter != s_types.end())
 			return &_iter->second;
 		return nullptr;
 	}
 	//----------------------------------------------------------------------------//
+	Object::FactoryPfn Object::GetFactory(const char* _name)
+	{
+		std::lock_guard<std::mutex> _lock(s_typesMutex);
+		auto _iter = s_types.find(StringUtils::Hash(_name));
+		return _iter != s_types.end() ? _iter->second.Factory : nullptr;
+	}
+	//----------------------------------------------------------------------------//
 	ObjectPtr Object::Create(const char* _name)
 	{
-		TypeInfo* _typeinfo = GetTypeInfo(_name);
-		if (_typeinfo && _typeinfo->Factory)
-			return _typeinfo->Factory();
+		FactoryPfn _factory = GetFactory(_name);
+		if (_factory)
+			return _factory();
 
 		LOG("Error: Factory for %s not found", _name);
 		return nullptr;
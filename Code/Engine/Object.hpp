@@ -16,8 +16,8 @@ namespace Easy2D
 		struct Counter
 		{
 			RefCounted* object;
-			int ref = 0;
-			int weak = 1;
+			std::atomic<int> ref = { 0 }; //!< atomic: objects can be shared between threads
+			std::atomic<int> weak = { 1 };
 
 			//! Increments the counter of weak references
 			void AddRef(void)
@@ -34,13 +34,15 @@ namespace Easy2D
 
 		//!
 		RefCounted(void);
-		//!
+		//! Object on stack or held as member must not be referenced by a smart pointer: last Release deletes it.
 		virtual ~RefCounted(void);
 
 		//! Increments the counter of strong references
 		void AddRef(void);
 		//! Decrements the counter of strong references
 		void Release(void);
+		//! \return number of strong references
+		int GetRefCount(void) { return m_rc->ref; }
 
 	protected:
 		//! Delete this object. You can overload this function for another behavior on deletion.
@@ -215,20 +217,19 @@ namespace Easy2D
 		static TypeInfo* GetTypeInfo(const char* _name) { return GetTypeInfo(StringUtils::Hash(_name)); }
 		//!
 		template <class T> static TypeInfo* GetOrCreateTypeInfo(void) { return GetOrCreateTypeInfo(T::TypeName); }
+		//! \return factory of type or nullptr. Safe while types are registered on other threads.
+		static FactoryPfn GetFactory(const char* _name);
 		//!
 		static ObjectPtr Create(const char* _name);
 		//!
 		template <class T> static SharedPtr<T> Create(void) { return Create(T::TypeName).Cast<T>(); }
 		//!
-		template <class T> static TypeInfo* Register(uint _flags = 0)
-		{
-			TypeInfo* _info = GetOrCreateTypeInfo<T>();
-			_info->Factory = &Object::Factory<T>;
-			_info->AddFlags(_flags);
-			return _info;
-		}
+		template <class T> static TypeInfo* Register(uint _flags = 0) { return _Register(T::TypeName, &Object::Factory<T>, _flags); }
 
 	private:
+		//! Create type info and set its factory and flags under lock of types
+		static TypeInfo* _Register(const char* _name, FactoryPfn _factory, uint _flags);
+
 		static HashMap<uint, TypeInfo> s_types;
 	};
 
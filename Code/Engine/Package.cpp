@@ -0,0 +1,479 @@
+#include "Package.hpp"
+#include "Math.hpp"
+#include "Thread.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// Package
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	Package::~Package(void)
+	{
+		Close();
+	}
+	//----------------------------------------------------------------------------//
+	bool Package::Open(const String& _name)
+	{
+		Close();
+
+		m_name = _name;
+
+		MappedFileStreamPtr _mapped = new MappedFileStream;
+		if (_mapped->Open(_name, Stream::Access::Random))
+		{
+			m_stream = _mapped.Cast<Stream>();
+		}
+		else
+		{
+			FileStreamPtr _file = new FileStream;
+			if (!_file->Open(_name, FileStream::Mode::ReadOnly))
+				return false;
+
+			if (!_file->IsPositional())
+			{
+				LOG("Error: Package \"%s\" does not support positional reading", _name.c_str());
+				return false;
+			}
+			m_stream = _file.Cast<Stream>();
+		}
+
+		Header& _h = m_header;
+		if (m_stream->ReadAt(0, &_h, sizeof(_h)) != sizeof(_h) || _h.magic != Magic)
+		{
+			LOG("Error: \"%s\" is not a package", _name.c_str());
+			Close();
+			return false;
+		}
+		if (_h.version != Version)
+		{
+			LOG("Error: Package \"%s\" has unsupported version %d", _name.c_str(), _h.version);
+			Close();
+			return false;
+		}
+
+		uint64 _tableSize = (uint64)_h.numEntries * sizeof(Entry) + ((uint64)_h.numBuckets + 1) * sizeof(uint32);
+		uint64 _size = m_stream->Size();
+		if (!_h.numBuckets || _h.dirSize < _tableSize || _h.dirOffset > _size || _h.dirSize > _size - _h.dirOffset)
+		{
+			LOG("Error: Package \"%s\" has invalid directory", _name.c_str());
+			Close();
+			return false;
+		}
+
+		Array<uint8> _dir((size_t)_h.dirSize);
+		if (m_stream->ReadAt(_h.dirOffset, _dir.data(), _dir.size()) != _dir.size() || Checksum::Crc32(_dir.data(), _dir.size()) != _h.dirChecksum)
+		{
+			LOG("Error: Package \"%s\" has corrupted directory", _name.c_str());
+			Close();
+			return false;
+		}
+
+		const uint8* _src = _dir.data();
+		m_entries.resize(_h.numEntries);
+		memcpy(m_entries.data(), _src, _h.numEntries * sizeof(Entry));
+		_src += _h.numEntries * sizeof(Entry);
+
+		m_buckets.resize(_h.numBuckets + 1);
+		memcpy(m_buckets.data(), _src, m_buckets.size() * sizeof(uint32));
+		_src += m_buckets.size() * sizeof(uint32);
+
+		m_namesData.assign((const char*)_src, (const char*)(_dir.data() + _dir.size()));
+		m_namesData.push_back(0);
+		m_names = m_namesData.data();
+
+		// buckets are ranges of entries: start at 0, end at numEntries and never decrease
+		bool _valid = m_buckets.front() == 0 && m_buckets.back() == _h.numEntries;
+		for (uint32 i = 0; _valid && i < _h.numBuckets; ++i)
+			_valid = m_buckets[i] <= m_buckets[i + 1];
+
+		for (size_t i = 0; _valid && i < m_entries.size(); ++i)
+		{
+			const Entry& _e = m_entries[i];
+			_valid = _e.name < m_namesData.size() && _e.offset <= _size && _e.packedSize <= _size - _e.offset;
+		}
+
+		if (!_valid)
+		{
+			LOG("Error: Package \"%s\" has invalid directory", _name.c_str());
+			Close();
+			return false;
+		}
+
+		LOG("Package \"%s\": %d entries", _name.c_str(), _h.numEntries);
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void Package::Close(void)
+	{
+		m_stream = nullptr;
+		m_header = Header();
+		m_entries.clear();
+		m_buckets.clear();
+		m_namesData.clear();
+		m_names = nullptr;
+	}
+	//----------------------------------------------------------------------------//
+	const Package::Entry* Package::Find(const String& _name)
+	{
+		if (m_entries.empty())
+			return nullptr;
+
+		String _key = PathUtils::Normalize(_name);
+		uint32 _hash = Hash(_key);
+		uint32 _bucket = (uint32)(((uint64)_hash * m_header.numBuckets) >> 32);
+
+		const Entry* _first = m_entries.data() + m_buckets[_bucket];
+		const Entry* _last = m_entries.data() + m_buckets[_bucket + 1];
+		const Entry* _e = std::lower_bound(_first, _last, _hash, [](const Entry& _a, uint32 _b) { return _a.hash < _b; });
+
+		for (; _e < _last && _e->hash == _hash; ++_e)
+		{
+			if (!StringUtils::Cmpi(m_names + _e->name, _key.c_str()))
+				return _e;
+		}
+		return nullptr;
+	}
+	//----------------------------------------------------------------------------//
+	StreamPtr Package::OpenEntry(const Entry* _entry)
+	{
+		if (!_entry || !m_stream)
+			return nullptr;
+
+		StreamPtr _stream = new PackageStream(this, _entry);
+
+		switch ((Codec)_entry->codec)
+		{
+		case Codec::None:
+			return _stream;
+
+		case Codec::Lz4:
+			if (_entry->size <= FileSystem::LargeFileSize)
+			{
+				const uint8* _src = _stream->Data();
+				Array<uint8> _packed;
+				if (!_src)
+				{
+					_packed.resize((size_t)_entry->packedSize);
+					if (_stream->Read(_packed.data(), _packed.size()) != _packed.size())
+						return nullptr;
+					_src = _packed.data();
+				}
+
+				MemoryStreamPtr _data = new MemoryStream(_stream->Name());
+				_data->Reserve((size_t)_entry->size);
+				if (!Lz4::DecompressFrame(_src, (size_t)_entry->packedSize, _data->Buffer()) || _data->Size() != _entry->size)
+				{
+					LOG("Error: Unable to decompress entry \"%s\" of package \"%s\"", EntryName(_entry), m_name.c_str());
+					return nullptr;
+				}
+				return _data.Cast<Stream>();
+			}
+			return new DecompressStream(_stream);
+		}
+
+		LOG("Error: Entry \"%s\" of package \"%s\" has unsupported codec %d", EntryName(_entry), m_name.c_str(), _entry->codec);
+		return nullptr;
+	}
+	//----------------------------------------------------------------------------//
+	bool Package::Verify(const Entry* _entry)
+	{
+		if (!_entry || !m_stream)
+			return false;
+
+		uint32 _crc = 0;
+		const uint8* _data = m_stream->Data();
+		if (_data)
+		{
+			_crc = Checksum::Crc32(_data + _entry->offset, (size_t)_entry->packedSize);
+		}
+		else
+		{
+			uint8 _buff[64 * 1024];
+			for (uint64 _pos = 0; _pos < _entry->packedSize;)
+			{
+				size_t _size = (size_t)Min<uint64>(sizeof(_buff), _entry->packedSize - _pos);
+				if (m_stream->ReadAt(_entry->offset + _pos, _buff, _size) != _size)
+					return false;
+				_crc = Checksum::Crc32(_buff, _size, _crc);
+				_pos += _size;
+			}
+		}
+
+		if (_crc != _entry->checksum)
+		{
+			LOG("Error: Entry \"%s\" of package \"%s\" is corrupted", EntryName(_entry), m_name.c_str());
+			return false;
+		}
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	uint32 Package::Hash(const String& _name)
+	{
+		String _key = FileSystem::IndexKey(_name);
+		return Checksum::Fnv1a(_key.c_str(), _key.length());
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// PackageStream
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	PackageStream::PackageStream(Package* _package, const Package::Entry* _entry) :
+		m_name(_package->Name() + "/" + _package->EntryName(_entry)),
+		m_package(_package),
+		m_offset(_entry->offset),
+		m_size(_entry->packedSize)
+	{
+		const uint8* _data = _package->m_stream->Data();
+		if (_data)
+			m_data = _data + m_offset;
+	}
+	//----------------------------------------------------------------------------//
+	void PackageStream::Seek(int64 _offset, SeekOrigin _origin)
+	{
+		int64 _pos = _offset;
+		if (_origin == SeekOrigin::Current)
+			_pos += m_pos;
+		else if (_origin == SeekOrigin::End)
+			_pos += m_size;
+		if (_pos < 0)
+			_pos = 0;
+		else if ((uint64)_pos > m_size)
+			_pos = m_size;
+		m_pos = (uint64)_pos;
+	}
+	//----------------------------------------------------------------------------//
+	size_t PackageStream::Read(void* _dst, size_t _size)
+	{
+		_size = ReadAt(m_pos, _dst, _size);
+		m_pos += _size;
+		return _size;
+	}
+	//----------------------------------------------------------------------------//
+	size_t PackageStream::ReadAt(uint64 _offset, void* _dst, size_t _size)
+	{
+		ASSERT(!_size || _dst);
+		if (!m_package || _offset >= m_size)
+			return 0;
+		if (_size > m_size - _offset)
+			_size = (size_t)(m_size - _offset);
+
+		if (m_data)
+		{
+			memcpy(_dst, m_data + _offset, _size);
+			return _size;
+		}
+		return m_package->m_stream->ReadAt(m_offset + _offset, _dst, _size);
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// PackageWriter
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	PackageWriter::PackageWriter(uint32 _alignment) :
+		m_alignment(Max<uint32>(_alignment, 1))
+	{
+	}
+	//----------------------------------------------------------------------------//
+	void PackageWriter::Add(const String& _name, const void* _data, size_t _size)
+	{
+		Item _item;
+		_item.name = PathUtils::Normalize(_name);
+		_item.data.assign((const uint8*)_data, (const uint8*)_data + _size);
+		m_items.push_back(std::move(_item));
+	}
+	//----------------------------------------------------------------------------//
+	void PackageWriter::AddFile(const String& _name, const String& _path)
+	{
+		Item _item;
+		_item.name = PathUtils::Normalize(_name);
+		_item.path = _path;
+		m_items.push_back(std::move(_item));
+	}
+	//----------------------------------------------------------------------------//
+	void PackageWriter::AddDirectory(const String& _path, const String& _prefix)
+	{
+		String _dir = _path;
+		if (!_dir.empty() && !PathUtils::IsDelimeter(_dir.back()))
+			_dir += "/";
+
+		Array<FileInfo> _files;
+		if (!FileSystem::ListFiles(_dir, _files))
+		{
+			LOG("Error: Unable to read directory \"%s\"", _path.c_str());
+			return;
+		}
+
+		for (const FileInfo& _file : _files)
+		{
+			if (_file.isDir)
+				AddDirectory(_dir + _file.name, _prefix + _file.name + "/");
+			else
+				AddFile(_prefix + _file.name, _dir + _file.name);
+		}
+	}
+	//----------------------------------------------------------------------------//
+	bool PackageWriter::Save(const String& _name)
+	{
+		struct Ref
+		{
+			uint32 hash;
+			Item* item;
+		};
+
+		Array<Ref> _refs;
+		_refs.reserve(m_items.size());
+		for (Item& _item : m_items)
+			_refs.push_back({ Package::Hash(_item.name), &_item });
+
+		std::stable_sort(_refs.begin(), _refs.end(), [](const Ref& _a, const Ref& _b) { return _a.hash < _b.hash; });
+
+		for (size_t i = 1; i < _refs.size(); ++i)
+		{
+			if (_refs[i].hash == _refs[i - 1].hash && !StringUtils::Cmpi(_refs[i].item->name.c_str(), _refs[i - 1].item->name.c_str()))
+			{
+				LOG("Error: Duplicate entry \"%s\" in package \"%s\"", _refs[i].item->name.c_str(), _name.c_str());
+				return false;
+			}
+		}
+
+		FileStream _dst;
+		if (!_dst.Open(_name, FileStream::Mode::Overwrite))
+			return false;
+
+		Package::Header _header;
+		_header.alignment = m_alignment;
+		_header.numEntries = (uint32)_refs.size();
+		_header.numBuckets = _header.numEntries / 4 + 1;
+		_dst.Write(&_header, sizeof(_header));
+
+		Array<Package::Entry> _entries;
+		Array<char> _names;
+		static const uint8 _zeros[4096] = { 0 };
+
+		for (size_t _first = 0; _first < _refs.size(); _first += BatchSize)
+		{
+			uint _count = (uint)Min<size_t>(BatchSize, _refs.size() - _first);
+			std::atomic<bool> _failed = { false };
+			auto _pack = [this, &_refs, &_failed, _first](uint i)
+			{
+				if (!_Pack(*_refs[_first + i].item))
+					_failed = true;
+			};
+
+			if (gThreadPool)
+				gThreadPool->ParallelFor(_count, _pack);
+			else
+			{
+				for (uint i = 0; i < _count; ++i)
+					_pack(i);
+			}
+
+			if (_failed)
+				return false;
+
+			for (uint i = 0; i < _count; ++i)
+			{
+				const Ref& _ref = _refs[_first + i];
+				Item& _item = *_ref.item;
+
+				for (uint64 _pad = (m_alignment - _dst.Tell() % m_alignment) % m_alignment; _pad;)
+				{
+					size_t _n = (size_t)Min<uint64>(_pad, sizeof(_zeros));
+					_dst.Write(_zeros, _n);
+					_pad -= _n;
+				}
+
+				const Array<uint8>& _data = _item.codec == Package::Codec::None ? _item.data : _item.packed;
+
+				Package::Entry _e;
+				_e.hash = _ref.hash;
+				_e.name = (uint32)_names.size();
+				_e.offset = _dst.Tell();
+				_e.size = _item.data.size();
+				_e.packedSize = _data.size();
+				_e.codec = (uint32)_item.codec;
+				_e.checksum = Checksum::Crc32(_data.data(), _data.size());
+				_entries.push_back(_e);
+
+				_names.insert(_names.end(), _item.name.begin(), _item.name.end());
+				_names.push_back(0);
+
+				if (_dst.Write(_data.data(), _data.size()) != _data.size())
+				{
+					LOG("Error: Unable to write file \"%s\"", _name.c_str());
+					return false;
+				}
+
+				// release data of batch
+				if (!_item.path.empty())
+					Array<uint8>().swap(_item.data);
+				Array<uint8>().swap(_item.packed);
+			}
+		}
+
+		Array<uint32> _buckets(_header.numBuckets + 1, 0);
+		for (const Package::Entry& _e : _entries)
+			++_buckets[(uint32)(((uint64)_e.hash * _header.numBuckets) >> 32) + 1];
+		for (uint32 i = 1; i <= _header.numBuckets; ++i)
+			_buckets[i] += _buckets[i - 1];
+
+		Array<uint8> _dir;
+		_dir.insert(_dir.end(), (const uint8*)_entries.data(), (const uint8*)(_entries.data() + _entries.size()));
+		_dir.insert(_dir.end(), (const uint8*)_buckets.data(), (const uint8*)(_buckets.data() + _buckets.size()));
+		_dir.insert(_dir.end(), _names.begin(), _names.end());
+
+		_header.dirOffset = _dst.Tell();
+		_header.dirSize = _dir.size();
+		_header.dirChecksum = Checksum::Crc32(_dir.data(), _dir.size());
+		_dst.Write(_dir.data(), _dir.size());
+
+		_dst.Seek(0, Stream::SeekOrigin::Set);
+		_dst.Write(&_header, sizeof(_header));
+		_dst.Flush();
+
+		LOG("Package \"%s\": %d entries, %d bytes", _name.c_str(), _header.numEntries, (int)_dst.Size());
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool PackageWriter::_Pack(Item& _item)
+	{
+		if (!_item.path.empty())
+		{
+			FileStream _src;
+			if (!_src.Open(_item.path, FileStream::Mode::ReadOnly))
+				return false;
+
+			_item.data.resize((size_t)_src.Size());
+			if (_src.Read(_item.data.data(), _item.data.size()) != _item.data.size())
+			{
+				LOG("Error: Unable to read file \"%s\"", _item.path.c_str());
+				return false;
+			}
+		}
+
+		_item.codec = Package::Codec::None;
+		_item.packed.clear();
+
+		if (m_codec == Package::Codec::Lz4 && !_item.data.empty())
+		{
+			Lz4::CompressFrame(_item.data.data(), _item.data.size(), _item.packed);
+			if (_item.packed.size() <= _item.data.size() - _item.data.size() / 16)
+				_item.codec = Package::Codec::Lz4;
+			else
+				Array<uint8>().swap(_item.packed);
+		}
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "File.hpp"
+#include "Compression.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// Package
+	//----------------------------------------------------------------------------//
+
+	typedef SharedPtr<class Package> PackagePtr;
+
+	//! Read-only archive of files.
+	/*!	Layout:	Header | aligned entry data ... | Entry[numEntries] | names (zero-terminated)
+		Entries are sorted by hash of name and splitted to buckets by the high bits of hash,
+		so lookup is a binary search within one small range. The directory is read once on Open.
+	*/
+	class Package : public Object
+	{
+	public:
+		RTTI("Package");
+
+		enum : uint32
+		{
+			Magic = 0x50443245, //!< "E2DP"
+			Version = 1,
+			DefaultAlignment = 4096,
+		};
+
+		//!
+		enum class Codec : uint8
+		{
+			None = 0,
+			Lz4 = 1, //!< LZ4 frame
+		};
+
+		//!
+		struct Header
+		{
+			uint32 magic = Magic;
+			uint32 version = Version;
+			uint32 alignment = DefaultAlignment;
+			uint32 numEntries = 0;
+			uint64 dirOffset = 0; //!< offset of entries
+			uint64 dirSize = 0; //!< size of entries, buckets and names
+			uint32 numBuckets = 0;
+			uint32 dirChecksum = 0; //!< crc32 of directory
+		};
+
+		//!
+		struct Entry
+		{
+			uint32 hash;
+			uint32 name; //!< offset of name in names block
+			uint64 offset;
+			uint64 size;
+			uint64 packedSize;
+			uint32 codec;
+			uint32 checksum; //!< crc32 of packed data
+		};
+
+		//!
+		Package(void) = default;
+
+		//! Open archive and read directory
+		bool Open(const String& _name);
+		//!
+		bool IsOpened(void) { return m_stream != nullptr; }
+		//!
+		void Close(void);
+		//!
+		const String& Name(void) { return m_name; }
+
+		//! \return entry or nullptr
+		const Entry* Find(const String& _name);
+		//!
+		const char* EntryName(const Entry* _entry) { return m_names + _entry->name; }
+		//!
+		const Array<Entry>& Entries(void) { return m_entries; }
+		//! Open stream for reading of entry
+		/*!	Compressed entry smaller than FileSystem::LargeFileSize is decompressed to memory, larger one is decompressed on reading. */
+		StreamPtr OpenEntry(const Entry* _entry);
+		//! Compare checksum of entry data
+		bool Verify(const Entry* _entry);
+
+		//! Hash of normalized case-insensitive name
+		static uint32 Hash(const String& _name);
+
+	protected:
+		//! Package is shared with its streams (PackageStream::m_package), so it must be created on heap only
+		~Package(void);
+
+		friend class PackageStream;
+
+		String m_name;
+		StreamPtr m_stream;
+		Header m_header;
+		Array<Entry> m_entries;
+		Array<uint32> m_buckets; //!< numBuckets + 1 indices of first entry in bucket
+		Array<char> m_namesData;
+		const char* m_names = nullptr;
+	};
+
+	//----------------------------------------------------------------------------//
+	// PackageStream
+	//----------------------------------------------------------------------------//
+
+	//! Stream of stored (packed) data of one entry of package
+	class PackageStream : public Stream
+	{
+	public:
+		RTTI("PackageFile");
+
+		//!
+		PackageStream(Package* _package, const Package::Entry* _entry);
+
+		//!
+		const String& Name(void) override { return m_name; }
+
+		//!
+		bool IsOpened(void) override { return m_package != nullptr; }
+		//!
+		void Close(void) override { m_package = nullptr; m_data = nullptr; }
+
+		//!
+		uint64 Size(void) override { return m_size; }
+		//!
+		bool EoF(void) override { return m_pos >= m_size; }
+		//!
+		void Seek(int64 _offset, SeekOrigin _origin = SeekOrigin::Current) override;
+		//!
+		uint64 Tell(void) override { return m_pos; }
+
+		//!
+		bool IsReadOnly(void) override { return true; }
+		//!
+		size_t Read(void* _dst, size_t _size) override;
+		//!
+		size_t Write(const void* _src, size_t _size) override { return 0; }
+		//!
+		void Flush(void) override { }
+
+		//!
+		bool IsPositional(void) override { return m_package != nullptr; }
+		//!
+		size_t ReadAt(uint64 _offset, void* _dst, size_t _size) override;
+
+		//!
+		const uint8* Data(void) override { return m_data; }
+		//!
+		void Advise(Access _access) override { }
+
+	protected:
+		String m_name;
+		PackagePtr m_package;
+		uint64 m_offset; //!< offset in package
+		uint64 m_size;
+		uint64 m_pos = 0;
+		const uint8* m_data = nullptr;
+	};
+
+	//----------------------------------------------------------------------------//
+	// PackageWriter
+	//----------------------------------------------------------------------------//
+
+	//! Builder of package
+	class PackageWriter : public NonCopyable
+	{
+	public:
+		//!
+		PackageWriter(uint32 _alignment = Package::DefaultAlignment);
+
+		//! Add entry from memory
+		void Add(const String& _name, const void* _data, size_t _size);
+		//! Add entry from file on disk. Data is read on Save.
+		void AddFile(const String& _name, const String& _path);
+		//! Add all files of directory recursively
+		void AddDirectory(const String& _path, const String& _prefix = "");
+		//! Set codec of entries. Entry is stored raw if compression does not save at least 1/16 of size.
+		void SetCodec(Package::Codec _codec) { m_codec = _codec; }
+		//!
+		Package::Codec GetCodec(void) { return m_codec; }
+		//!
+		uint NumEntries(void) { return (uint)m_items.size(); }
+
+		//! Write package to file. Entries are read and compressed in parallel if gThreadPool exists.
+		bool Save(const String& _name);
+
+	protected:
+		enum : uint
+		{
+			BatchSize = 64, //!< number of entries read and compressed at once
+		};
+
+		//!
+		struct Item
+		{
+			String name;
+			String path;
+			Array<uint8> data;
+			Array<uint8> packed;
+			Package::Codec codec = Package::Codec::None;
+		};
+
+		//! Read file of item and compress data
+		bool _Pack(Item& _item);
+
+		uint32 m_alignment;
+		Package::Codec m_codec = Package::Codec::None;
+		Array<Item> m_items;
+	};
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
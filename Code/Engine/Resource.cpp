@@ -1,4 +1,9 @@
 #include "Resource.hpp"
+#include "FileWatcher.hpp"
+#include "Json.hpp"
+#include "Math.hpp"
+#include "Thread.hpp"
+#include <chrono>
 
 namespace Easy2D
 {
@@ -9,7 +14,16 @@ namespace Easy2D
 	//----------------------------------------------------------------------------//
 	bool Resource::Load(Stream* _src)
 	{
-		LOG("Error: Load not supported for %s", TypeName);
+		LoadRecord _record;
+		bool _loaded = _MeasureBeginLoad(_src, _record) && _MeasureEndLoad(_record);
+		if (gResources)
+			gResources->AddLoadRecord(_record);
+		return _loaded;
+	}
+	//----------------------------------------------------------------------------//
+	bool Resource::BeginLoad(Stream* _src)
+	{
+		LOG("Error: Load not supported for %s", GetTypeName());
 		return false;
 	}
 	//----------------------------------------------------------------------------//
@@ -19,13 +33,47 @@ namespace Easy2D
 		return false;
 	}
 	//----------------------------------------------------------------------------//
+	bool Resource::_MeasureBeginLoad(Stream* _src, LoadRecord& _record)
+	{
+		_record.type = GetTypeName();
+		_record.name = m_name;
+		_record.thread = ThreadPool::ThreadIndex();
+
+		MeteredStreamPtr _metered = _src ? new MeteredStream(_src) : nullptr;
+		auto _start = std::chrono::steady_clock::now();
+		_record.succeeded = BeginLoad(_metered ? _metered.Get() : _src);
+		float _time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count();
+
+		if (_metered)
+		{
+			_record.ioTime += _metered->ReadTime();
+			_record.decodeTime += Max(_time - _metered->ReadTime(), 0.0f);
+			_record.bytesRead += _metered->BytesRead();
+		}
+		else
+			_record.decodeTime += _time;
+
+		return _record.succeeded;
+	}
+	//----------------------------------------------------------------------------//
+	bool Resource::_MeasureEndLoad(LoadRecord& _record)
+	{
+		auto _start = std::chrono::steady_clock::now();
+		_record.succeeded = EndLoad();
+		_record.uploadTime += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count();
+		_record.cpuSize = GetCpuSize();
+		_record.gpuSize = GetGpuSize();
+		return _record.succeeded;
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	// ResourceCache
 	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
-	ResourceCache::ResourceCache(void)
+	ResourceCache::ResourceCache(void) :
+		m_mainThread(std::this_thread::get_id())
 	{
 	}
 	//----------------------------------------------------------------------------//
@@ -37,14 +85,40 @@ namespace Easy2D
 	{
 		switch (_type)
 		{
-		case SystemEvent::Startup:
+		case SystemEvent::BeginFrame:
 		{
-			//TODO:
+			++m_frame;
+			_AddPending();
+			_Upload();
+			_UpdateGroups();
+			Trim();
 
 		} break;
 		case SystemEvent::Shutdown:
 		{
-			m_resources.clear();
+			{
+				std::lock_guard<std::mutex> _lock(m_uploadMutex);
+				m_uploads = {};
+			}
+			{
+				std::lock_guard<std::mutex> _lock(m_pendingMutex);
+				m_pending.clear();
+			}
+			for (Shard& _shard : m_shards)
+			{
+				std::lock_guard<std::mutex> _lock(_shard.mutex);
+				_shard.names.clear();
+			}
+			m_groups.clear();
+			m_reloads.clear();
+			m_slots.clear();
+			m_freeSlot = ~0u;
+			m_types.clear();
+
+		} break;
+		case SystemEvent::FileChanged:
+		{
+			_OnFileChanged(*reinterpret_cast<const String*>(_arg));
 
 		} break;
 		}
@@ -54,42 +128,950 @@ namespace Easy2D
 	//----------------------------------------------------------------------------//
 	Resource* ResourceCache::GetResource(const char* _type, const String& _name, uint _typeid, bool _tmp)
 	{
+		bool _created;
+		Resource* _res = _Create(_type, _name, _typeid, _tmp, _created);
+		if (_res && _created)
+			_LoadSync(_res);
+
+		return _res;
+	}
+	//----------------------------------------------------------------------------//
+	Resource* ResourceCache::GetResourceAsync(const char* _type, const String& _name, uint _typeid, int _priority)
+	{
+		if (!gThreadPool)
+			return GetResource(_type, _name, _typeid);
+
+		bool _created;
+		Resource* _res = _Create(_type, _name, _typeid, false, _created);
+		if (_res && _created)
+			_LoadAsync(_res, _priority);
+
+		return _res;
+	}
+	//----------------------------------------------------------------------------//
+	ResourcePtr ResourceCache::FindResource(const char* _type, const String& _name, uint _typeid)
+	{
+		bool _created;
+		return _Find(_type, _name, _typeid, false, _created);
+	}
+	//----------------------------------------------------------------------------//
+	ResourcePtr ResourceCache::RequestResource(const char* _type, const String& _name, uint _typeid, int _priority)
+	{
+		if (std::this_thread::get_id() == m_mainThread)
+			return GetResourceAsync(_type, _name, _typeid, _priority);
+
+		ASSERT(gThreadPool != nullptr);
+
+		bool _created;
+		ResourcePtr _res = _Find(_type, _name, _typeid, true, _created);
+		if (_res && _created)
+			_LoadAsync(_res, _priority);
+
+		return _res;
+	}
+	//----------------------------------------------------------------------------//
+	bool ResourceCache::Cancel(Resource* _res)
+	{
+		if (!_res || _res->m_state != Resource::State::Loading)
+			return false;
+
+		_res->m_canceled = true;
+		_res->m_state = Resource::State::Unloaded;
+
+		_Remove(_res); // the pending task holds the resource
+
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::SetUploadBudget(float _milliseconds, uint64 _bytes)
+	{
+		m_uploadTime = _milliseconds;
+		m_uploadBytes = _bytes;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::Reload(Resource* _res)
+	{
+		ASSERT(_res != nullptr);
+
+		ResourcePtr _new = Object::Create(_res->GetTypeName()).Cast<Resource>();
+		if (!_new)
+		{
+			LOG("Error: Unable to create %s \"%s\"", _res->GetTypeName(), _res->GetName().c_str());
+			return;
+		}
+		_new->SetName(_res->GetName());
+		_new->AddSource(_res->GetName());
+
+		if (!gThreadPool)
+		{
+			StreamPtr _src = gFileSystem->OpenFile(_new->GetName());
+			Array<Resource::Dependency> _deps;
+			if (_src && _src->IsOpened())
+				_Declare(_new, _src, _deps);
+
+			if (_src && _src->IsOpened() && _new->Load(_src))
+			{
+				_res->_Swap(_new);
+				_res->m_state = Resource::State::Ready;
+				_SetDependencies(_res, _deps, false, ThreadPool::Normal);
+				_Invalidate(_res);
+				_UpdateSize(_res);
+				_Watch(_res);
+				_ReloadDependents(_res);
+			}
+			return;
+		}
+
+		// only last reload of resource will be applied
+		uint _id = ++m_reloadCounter;
+		m_reloads[_res] = _id;
+
+		ResourcePtr _old = _res;
+		gThreadPool->Push([this, _old, _new, _id]()
+		{
+			LoadRecord _record;
+			auto _start = std::chrono::steady_clock::now();
+			StreamPtr _src = gFileSystem->OpenFile(_new->GetName());
+			_record.ioTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count();
+
+			Array<Resource::Dependency> _deps;
+			bool _loaded = false;
+			if (_src && _src->IsOpened())
+			{
+				_Declare(_new, _src, _deps);
+				_loaded = _new->_MeasureBeginLoad(_src, _record);
+			}
+
+			gThreadPool->PushMain([this, _old, _new, _id, _loaded, _deps, _record]() mutable
+			{
+				auto _last = m_reloads.find(_old);
+				if (_last == m_reloads.end() || _last->second != _id)
+					return; // outdated
+				m_reloads.erase(_last);
+
+				bool _reloaded = _loaded && _new->_MeasureEndLoad(_record);
+				AddLoadRecord(_record);
+				if (!_reloaded)
+				{
+					LOG("Error: Unable to reload %s \"%s\"", _old->GetTypeName(), _old->GetName().c_str());
+					return;
+				}
+
+				_old->_Swap(_new);
+				_old->m_state = Resource::State::Ready;
+				_SetDependencies(_old, _deps, true, ThreadPool::Normal);
+				_Invalidate(_old);
+				_UpdateSize(_old);
+				LOG("%s \"%s\" was reloaded", _old->GetTypeName(), _old->GetName().c_str());
+
+				_Watch(_old);
+				_ReloadDependents(_old);
+			});
+		});
+	}
+	//----------------------------------------------------------------------------//
+	String ResourceCache::_Key(uint _typeid, const String& _name)
+	{
+		return StringUtils::Format("%08x:", _typeid) + FileSystem::IndexKey(_name);
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::SetBudget(uint _typeid, uint64 _bytes)
+	{
+		m_types[_typeid].budget = _bytes;
+	}
+	//----------------------------------------------------------------------------//
+	uint64 ResourceCache::GetBudget(uint _typeid)
+	{
+		auto _it = m_types.find(_typeid);
+		return _it != m_types.end() ? _it->second.budget : 0;
+	}
+	//----------------------------------------------------------------------------//
+	uint64 ResourceCache::GetSize(uint _typeid)
+	{
+		auto _it = m_types.find(_typeid);
+		return _it != m_types.end() ? _it->second.cpuSize + _it->second.gpuSize : 0;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::Trim(void)
+	{
+		// resource is unused if only the cache holds it; loading resources are held by their tasks
+		Array<std::pair<uint, uint32>> _candidates; // last use, index of slot
+		for (uint32 i = 0; i < (uint32)m_slots.size(); ++i)
+		{
+			Slot& _slot = m_slots[i];
+			if (!_slot.resource || _slot.resource->GetRefCount() > 1)
+				continue;
+
+			if (_slot.temporary)
+			{
+				if (_Evict(_slot.resource))
+					++m_stats.evictions;
+				continue;
+			}
+
+			const TypeUsage& _usage = m_types[_slot.type];
+			if (_usage.budget && _usage.cpuSize + _usage.gpuSize > _usage.budget)
+				_candidates.push_back({ _slot.lastUse, i });
+		}
+
+		std::sort(_candidates.begin(), _candidates.end());
+		for (const auto& _candidate : _candidates)
+		{
+			Slot& _slot = m_slots[_candidate.second];
+			const TypeUsage& _usage = m_types[_slot.type];
+			if (_slot.resource && _usage.cpuSize + _usage.gpuSize > _usage.budget && _Evict(_slot.resource))
+				++m_stats.evictions;
+		}
+	}
+	//----------------------------------------------------------------------------//
+	ResourceCache::Stats ResourceCache::GetStats(void)
+	{
+		Stats _stats = m_stats;
+		for (Shard& _shard : m_shards)
+		{
+			std::lock_guard<std::mutex> _lock(_shard.mutex);
+			_stats.resources += (uint)_shard.names.size();
+			_stats.hits += _shard.hits;
+			_stats.misses += _shard.misses;
+		}
+		for (const auto& _type : m_types)
+		{
+			_stats.cpuSize += _type.second.cpuSize;
+			_stats.gpuSize += _type.second.gpuSize;
+		}
+		return _stats;
+	}
+	//----------------------------------------------------------------------------//
+	ResourcePtr ResourceCache::_Find(const char* _type, const String& _name, uint _typeid, bool _create, bool& _created)
+	{
+		_created = false;
+
 		if (!_typeid)
 			_typeid = StringUtils::Hash(_type);
-		uint _id = StringUtils::Hash(_name.c_str());
-		auto& _cache = m_resources[_typeid];
-
-		auto& _exists = _cache.find(_id);
-		if (_exists != _cache.end())
-			return _exists->second;
+		String _key = _Key(_typeid, _name);
+		Shard& _shard = _Shard(_key);
 
+		std::lock_guard<std::mutex> _lock(_shard.mutex);
+		auto _exists = _shard.names.find(_key);
+		if (_exists != _shard.names.end())
 		{
-			// TODO: find in temporary resources
+			++_shard.hits;
+			return _exists->second; // name is erased before the cache releases resource
 		}
+		if (!_create)
+			return nullptr;
 
-		Object::TypeInfo* _typeinfo = Object::GetOrCreateTypeInfo(_type);
-		if (!_typeinfo->Factory)
+		// created under lock, so concurrent requests of the same resource wait for it instead of loading it again
+		Object::FactoryPfn _factory = Object::GetFactory(_type);
+		if (!_factory)
 		{
 			LOG("Error: Unable to create %s \"%s\"", _type, _name.c_str());
 			return nullptr;
 		}
 
-		ResourcePtr _res = _typeinfo->Factory().Cast<Resource>();
+		ResourcePtr _res = _factory().Cast<Resource>();
 		ASSERT(_res != nullptr);
 
-		if (_tmp)
+		_res->SetName(_name);
+		_res->AddSource(_name);
+		_res->m_state = Resource::State::Loading;
+		_shard.names[_key] = _res;
+		++_shard.misses;
+		_created = true;
+
+		std::lock_guard<std::mutex> _pendingLock(m_pendingMutex);
+		m_pending.push_back({ _res, _key, _typeid });
+
+		return _res;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_EraseName(Resource* _res, const String& _key)
+	{
+		Shard& _shard = _Shard(_key);
+		std::lock_guard<std::mutex> _lock(_shard.mutex);
+		auto _it = _shard.names.find(_key);
+		if (_it != _shard.names.end() && _it->second == _res)
+			_shard.names.erase(_it);
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_AddPending(void)
+	{
+		Array<Pending> _pending;
+		{
+			std::lock_guard<std::mutex> _lock(m_pendingMutex);
+			_pending.swap(m_pending);
+		}
+
+		for (Pending& _new : _pending)
+		{
+			uint32 _index = m_freeSlot;
+			if (_index != ~0u)
+			{
+				m_freeSlot = m_slots[_index].nextFree;
+			}
+			else
+			{
+				_index = (uint32)m_slots.size();
+				m_slots.push_back(Slot());
+			}
+
+			Slot& _slot = m_slots[_index];
+			_slot.resource = _new.resource;
+			_slot.key = _new.key;
+			_slot.type = _new.type;
+			_slot.lastUse = m_frame;
+			_slot.temporary = false;
+			_new.resource->m_slot = _index;
+		}
+	}
+	//----------------------------------------------------------------------------//
+	Resource* ResourceCache::_Create(const char* _type, const String& _name, uint _typeid, bool _tmp, bool& _created)
+	{
+		ResourcePtr _res = _Find(_type, _name, _typeid, true, _created);
+		if (!_res)
+			return nullptr;
+
+		if (_res->m_slot == ~0u)
+			_AddPending(); // new resource or resource requested by worker
+
+		Slot& _slot = m_slots[_res->m_slot];
+		_slot.lastUse = m_frame;
+		if (_created)
+			_slot.temporary = _tmp;
+		else if (!_tmp)
+			_slot.temporary = false;
+
+		return _res; // held by slot
+	}
+	//----------------------------------------------------------------------------//
+	bool ResourceCache::_Evict(Resource* _res)
+	{
+		{
+			// other threads take resources under lock of shard
+			Shard& _shard = _Shard(m_slots[_res->m_slot].key);
+			std::lock_guard<std::mutex> _lock(_shard.mutex);
+			if (_res->GetRefCount() > 1)
+				return false;
+			_shard.names.erase(m_slots[_res->m_slot].key);
+		}
+		_Remove(_res);
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_LoadSync(Resource* _res)
+	{
+		_res->m_state = Resource::State::Loading;
+
+		LoadRecord _record;
+		auto _start = std::chrono::steady_clock::now();
+		StreamPtr _src = gFileSystem->OpenFile(_res->GetName());
+		_record.ioTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count();
+
+		bool _loaded = false;
+		if (_src && _src->IsOpened())
 		{
-			// TODO
+			Array<Resource::Dependency> _deps;
+			_Declare(_res, _src, _deps);
+			_SetDependencies(_res, _deps, false, ThreadPool::Normal); // dependencies have own records
+
+			_loaded = _res->_MeasureBeginLoad(_src, _record) && _res->_MeasureEndLoad(_record);
 		}
 		else
 		{
-			_cache[_id] = _res;
+			_record.type = _res->GetTypeName();
+			_record.name = _res->GetName();
 		}
+		AddLoadRecord(_record);
 
-		_res->SetName(_name);
-		_res->Load(gFileSystem->OpenFile(_name));
+		_res->m_state = _loaded ? Resource::State::Ready : Resource::State::Failed;
+		_UpdateSize(_res);
+		_Watch(_res);
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_LoadAsync(Resource* _res, int _priority)
+	{
+		_res->m_state = Resource::State::Loading;
+		++m_numLoading;
 
-		return _res;
+		ResourcePtr _ref = _res;
+		gThreadPool->Push([this, _ref, _priority]()
+		{
+			bool _loaded = false;
+			Array<Resource::Dependency> _deps;
+			LoadRecord _record;
+			_record.type = _ref->GetTypeName();
+			_record.name = _ref->GetName();
+			if (!_ref->m_canceled)
+			{
+				auto _start = std::chrono::steady_clock::now();
+				StreamPtr _src = gFileSystem->OpenFile(_ref->GetName());
+				_record.ioTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count();
+				if (_src && _src->IsOpened())
+				{
+					_Declare(_ref, _src, _deps);
+					_Prefetch(_deps, _priority);
+					_loaded = _ref->_MeasureBeginLoad(_src, _record);
+				}
+			}
+
+			std::lock_guard<std::mutex> _lock(m_uploadMutex);
+			m_uploads.push({ _priority, m_uploadOrder++, _ref, _loaded, std::move(_deps), false, std::move(_record) });
+		}, _priority);
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_Declare(Resource* _res, Stream* _src, Array<Resource::Dependency>& _deps)
+	{
+		uint64 _pos = _src->Tell();
+		_res->GetDependencies(_src, _deps);
+		_src->Seek(_pos, Stream::SeekOrigin::Set);
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_Prefetch(const Array<Resource::Dependency>& _deps, int _priority)
+	{
+		for (const Resource::Dependency& _dep : _deps)
+		{
+			if (!_dep.type.empty())
+				continue; // resources are loaded by own tasks
+
+			String _name = _dep.name;
+			gThreadPool->Push([_name]()
+			{
+				StreamPtr _file = gFileSystem->OpenFile(_name);
+				if (_file && _file->IsOpened())
+					_file->Prefetch(_file->Tell(), _file->Size() - _file->Tell());
+			}, _priority);
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_SetDependencies(Resource* _res, const Array<Resource::Dependency>& _deps, bool _async, int _priority)
+	{
+		if (_res->m_slot >= m_slots.size() || m_slots[_res->m_slot].resource != _res)
+			return;
+
+		uint32 _index = _res->m_slot; // slots can be reallocated by new dependencies
+		_Unlink(_res);
+
+		for (const Resource::Dependency& _dep : _deps)
+		{
+			if (_dep.type.empty())
+			{
+				const Array<String>& _sources = _res->GetSources();
+				if (std::find(_sources.begin(), _sources.end(), _dep.name) == _sources.end())
+					_res->AddSource(_dep.name); // resource is reloaded when file is changed
+				continue;
+			}
+
+			bool _created;
+			Resource* _depRes = _Create(_dep.type.c_str(), _dep.name, 0, true, _created);
+			if (!_depRes)
+				continue;
+			if (_created)
+			{
+				if (_async && gThreadPool)
+					_LoadAsync(_depRes, _priority);
+				else
+					_LoadSync(_depRes);
+			}
+
+			if (_depRes == _res || _DependsOn(_depRes, _res))
+			{
+				LOG("Error: Cyclic dependency of %s \"%s\" on %s \"%s\"", _res->GetTypeName(), _res->GetName().c_str(), _depRes->GetTypeName(), _depRes->GetName().c_str());
+				continue;
+			}
+
+			m_slots[_index].dependencies.push_back(_depRes);
+			m_slots[_depRes->m_slot].dependents.push_back(_res);
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_Unlink(Resource* _res)
+	{
+		Slot& _slot = m_slots[_res->m_slot];
+		for (const ResourcePtr& _dep : _slot.dependencies)
+		{
+			if (_dep->m_slot < m_slots.size() && m_slots[_dep->m_slot].resource == _dep)
+			{
+				Array<Resource*>& _dependents = m_slots[_dep->m_slot].dependents;
+				_dependents.erase(std::remove(_dependents.begin(), _dependents.end(), _res), _dependents.end());
+			}
+		}
+		_slot.dependencies.clear(); // temporary dependencies without other dependents are removed by Trim
+	}
+	//----------------------------------------------------------------------------//
+	bool ResourceCache::_DependsOn(Resource* _res, Resource* _dep)
+	{
+		if (_res->m_slot >= m_slots.size() || m_slots[_res->m_slot].resource != _res)
+			return false;
+
+		for (const ResourcePtr& _child : m_slots[_res->m_slot].dependencies)
+		{
+			if (_child == _dep || _DependsOn(_child, _dep))
+				return true;
+		}
+		return false;
+	}
+	//----------------------------------------------------------------------------//
+	bool ResourceCache::_IsWaiting(Resource* _res)
+	{
+		if (_res->m_slot >= m_slots.size() || m_slots[_res->m_slot].resource != _res)
+			return false;
+
+		for (const ResourcePtr& _dep : m_slots[_res->m_slot].dependencies)
+		{
+			if (_dep->m_state == Resource::State::Loading)
+				return true;
+		}
+		return false;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_ReloadDependents(Resource* _res)
+	{
+		if (_res->m_slot >= m_slots.size() || m_slots[_res->m_slot].resource != _res)
+			return;
+
+		Array<Resource*> _dependents = m_slots[_res->m_slot].dependents;
+		for (Resource* _dependent : _dependents)
+			Reload(_dependent);
+	}
+	//----------------------------------------------------------------------------//
+	String ResourceCache::DumpDependencies(void)
+	{
+		String _dst;
+		for (const Slot& _slot : m_slots)
+		{
+			if (_slot.resource && _slot.dependents.empty())
+				_Dump(_slot.resource, 0, _dst);
+		}
+		return _dst;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::AddLoadRecord(const LoadRecord& _record)
+	{
+		{
+			std::lock_guard<std::mutex> _lock(m_loadMutex);
+			LoadStats& _stats = m_loadStats[_record.type];
+			++_stats.loads;
+			if (!_record.succeeded)
+				++_stats.failed;
+			_stats.ioTime += _record.ioTime;
+			_stats.decodeTime += _record.decodeTime;
+			_stats.uploadTime += _record.uploadTime;
+			_stats.maxTime = Max(_stats.maxTime, _record.TotalTime());
+			_stats.bytesRead += _record.bytesRead;
+			_stats.cpuSize += _record.cpuSize;
+			_stats.gpuSize += _record.gpuSize;
+
+			m_loadRecords.push_back(_record);
+			if (m_loadRecords.size() > MaxLoadRecords)
+				m_loadRecords.pop_front();
+		}
+
+		if (m_slowLoadTime > 0 && _record.TotalTime() > m_slowLoadTime)
+		{
+			LOG("Warning: Slow load of %s \"%s\": %.2f ms (io %.2f, decode %.2f, upload %.2f), %u KB", _record.type.c_str(), _record.name.c_str(),
+				_record.TotalTime(), _record.ioTime, _record.decodeTime, _record.uploadTime, (uint)(_record.bytesRead / 1024));
+		}
+	}
+	//----------------------------------------------------------------------------//
+	Array<LoadRecord> ResourceCache::GetLoadRecords(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_loadMutex);
+		return Array<LoadRecord>(m_loadRecords.begin(), m_loadRecords.end());
+	}
+	//----------------------------------------------------------------------------//
+	HashMap<String, ResourceCache::LoadStats> ResourceCache::GetLoadStats(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_loadMutex);
+		return m_loadStats;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::ClearLoadRecords(void)
+	{
+		std::lock_guard<std::mutex> _lock(m_loadMutex);
+		m_loadRecords.clear();
+		m_loadStats.clear();
+	}
+	//----------------------------------------------------------------------------//
+	String ResourceCache::PrintLoadReport(uint _slowest)
+	{
+		HashMap<String, LoadStats> _stats = GetLoadStats();
+		Array<LoadRecord> _records = GetLoadRecords();
+
+		Array<String> _types;
+		for (const auto& _it : _stats)
+			_types.push_back(_it.first);
+		std::sort(_types.begin(), _types.end());
+
+		String _dst = StringUtils::Format("%-16s %6s %6s %10s %10s %10s %10s %10s %10s %10s\n", "Type", "Loads", "Failed", "IO ms", "Decode ms", "Upload ms", "Max ms", "Read KB", "CPU KB", "GPU KB");
+		for (const String& _type : _types)
+		{
+			const LoadStats& _s = _stats[_type];
+			_dst += StringUtils::Format("%-16s %6u %6u %10.2f %10.2f %10.2f %10.2f %10u %10u %10u\n", _type.c_str(), _s.loads, _s.failed, _s.ioTime, _s.decodeTime, _s.uploadTime,
+				_s.maxTime, (uint)(_s.bytesRead / 1024), (uint)(_s.cpuSize / 1024), (uint)(_s.gpuSize / 1024));
+		}
+
+		std::sort(_records.begin(), _records.end(), [](const LoadRecord& _a, const LoadRecord& _b) { return _a.TotalTime() > _b.TotalTime(); });
+		if (_records.size() > _slowest)
+			_records.resize(_slowest);
+		if (!_records.empty())
+			_dst += "Slowest loads:\n";
+		for (const LoadRecord& _r : _records)
+		{
+			_dst += StringUtils::Format("%10.2f ms  %s \"%s\" (io %.2f, decode %.2f, upload %.2f), %u KB, thread %u%s\n", _r.TotalTime(), _r.type.c_str(), _r.name.c_str(),
+				_r.ioTime, _r.decodeTime, _r.uploadTime, (uint)(_r.bytesRead / 1024), _r.thread, _r.succeeded ? "" : ", failed");
+		}
+
+		return _dst;
+	}
+	//----------------------------------------------------------------------------//
+	bool ResourceCache::SaveLoadReport(const String& _path)
+	{
+		HashMap<String, LoadStats> _stats = GetLoadStats();
+		Array<LoadRecord> _records = GetLoadRecords();
+
+		Json _report = Json::EmptyObject;
+		Json& _types = _report["Types"];
+		_types = Json::EmptyObject;
+		for (const auto& _it : _stats)
+		{
+			const LoadStats& _s = _it.second;
+			Json& _type = _types[_it.first];
+			_type["Loads"] = _s.loads;
+			_type["Failed"] = _s.failed;
+			_type["IoTime"] = _s.ioTime;
+			_type["DecodeTime"] = _s.decodeTime;
+			_type["UploadTime"] = _s.uploadTime;
+			_type["MaxTime"] = _s.maxTime;
+			_type["ReadKB"] = (uint)(_s.bytesRead / 1024);
+			_type["CpuKB"] = (uint)(_s.cpuSize / 1024);
+			_type["GpuKB"] = (uint)(_s.gpuSize / 1024);
+		}
+
+		Json& _loads = _report["Loads"];
+		_loads = Json::EmptyArray;
+		for (const LoadRecord& _r : _records)
+		{
+			Json& _load = _loads.Append();
+			_load["Type"] = _r.type;
+			_load["Name"] = _r.name;
+			_load["Thread"] = _r.thread;
+			_load["IoTime"] = _r.ioTime;
+			_load["DecodeTime"] = _r.decodeTime;
+			_load["UploadTime"] = _r.uploadTime;
+			_load["ReadKB"] = (uint)(_r.bytesRead / 1024);
+			_load["CpuKB"] = (uint)(_r.cpuSize / 1024);
+			_load["GpuKB"] = (uint)(_r.gpuSize / 1024);
+			_load["Succeeded"] = _r.succeeded;
+		}
+
+		String _text = _report.Print();
+		FileStream _dst;
+		if (!_dst.Open(_path, FileStream::Mode::Overwrite) || _dst.Write(_text.c_str(), _text.length()) != _text.length() || !_dst.Sync())
+		{
+			LOG("Error: Unable to save load report \"%s\"", _path.c_str());
+			return false;
+		}
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	bool ResourceCache::LoadGroup(const String& _manifest, const GroupCallback& _onLoaded, int _priority)
+	{
+		Json _desc;
+		StreamPtr _src = gFileSystem->OpenFile(_manifest);
+		if (!_src || !_src->IsOpened() || !_desc.Load(_src) || !_desc.IsObject())
+		{
+			LOG("Error: Unable to load group \"%s\"", _manifest.c_str());
+			return false;
+		}
+
+		Group _group;
+		_group.name = _manifest;
+		_group.callback = _onLoaded;
+		for (auto _type = _desc.Begin(); _type != _desc.End(); ++_type)
+		{
+			for (uint i = 0; i < _type->second.Size(); ++i)
+			{
+				String _name = _type->second[i].AsString();
+
+				// resources of group are temporary, so they are removed after UnloadGroup if nobody else uses them
+				bool _created;
+				Resource* _res = _Create(_type->first.c_str(), _name, 0, true, _created);
+				if (!_res)
+					continue;
+				if (_created)
+				{
+					if (gThreadPool)
+						_LoadAsync(_res, _priority);
+					else
+						_LoadSync(_res);
+				}
+
+				FileInfo _info;
+				_group.resources.push_back(_res);
+				_group.sizes.push_back(gFileSystem->GetFileInfo(_name, _info) ? _info.size : 0);
+			}
+		}
+
+		m_groups[FileSystem::IndexKey(_manifest)] = std::move(_group); // replaced group releases its resources after new references were added
+		return true;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::UnloadGroup(const String& _manifest)
+	{
+		m_groups.erase(FileSystem::IndexKey(_manifest));
+	}
+	//----------------------------------------------------------------------------//
+	ResourceCache::GroupProgress ResourceCache::GetGroupProgress(const String& _manifest)
+	{
+		GroupProgress _progress;
+		auto _it = m_groups.find(FileSystem::IndexKey(_manifest));
+		if (_it == m_groups.end())
+			return _progress;
+
+		const Group& _group = _it->second;
+		_progress.resources = (uint)_group.resources.size();
+		for (size_t i = 0; i < _group.resources.size(); ++i)
+		{
+			Resource::State _state = _group.resources[i]->GetState();
+			_progress.bytes += _group.sizes[i];
+			if (_state == Resource::State::Loading)
+			{
+				_progress.bytesRemaining += _group.sizes[i];
+				continue;
+			}
+			++_progress.loaded;
+			if (_state == Resource::State::Failed)
+				++_progress.failed;
+		}
+
+		if (_progress.bytes)
+			_progress.fraction = (float)(_progress.bytes - _progress.bytesRemaining) / _progress.bytes;
+		else
+			_progress.fraction = _progress.resources ? (float)_progress.loaded / _progress.resources : 1;
+
+		return _progress;
+	}
+	//----------------------------------------------------------------------------//
+	bool ResourceCache::IsGroupLoaded(const String& _manifest)
+	{
+		auto _it = m_groups.find(FileSystem::IndexKey(_manifest));
+		return _it != m_groups.end() && _it->second.loaded;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_UpdateGroups(void)
+	{
+		Array<std::pair<GroupCallback, bool>> _callbacks;
+		Array<String> _names;
+		for (auto& _it : m_groups)
+		{
+			Group& _group = _it.second;
+			if (_group.loaded)
+				continue;
+
+			bool _loading = false, _succeeded = true;
+			for (const ResourcePtr& _res : _group.resources)
+			{
+				Resource::State _state = _res->GetState();
+				_loading |= _state == Resource::State::Loading;
+				_succeeded &= _state == Resource::State::Ready;
+			}
+			if (_loading)
+				continue;
+
+			_group.loaded = true;
+			if (_group.callback)
+			{
+				_callbacks.push_back({ _group.callback, _succeeded });
+				_names.push_back(_group.name);
+			}
+		}
+
+		// callbacks can load and unload groups
+		for (size_t i = 0; i < _callbacks.size(); ++i)
+			_callbacks[i].first(_names[i], _callbacks[i].second);
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_Dump(Resource* _res, uint _depth, String& _dst)
+	{
+		static const char* _states[] = { "Unloaded", "Loading", "Ready", "Failed" };
+
+		const Slot& _slot = m_slots[_res->m_slot];
+		_dst += String(_depth * 2, ' ');
+		_dst += StringUtils::Format("%s \"%s\" %s%s, %u KB\n", _res->GetTypeName(), _res->GetName().c_str(), _states[(int)_res->GetState()],
+			_slot.temporary ? " (temporary)" : "", (uint)((_slot.cpuSize + _slot.gpuSize) / 1024));
+
+		const Array<String>& _sources = _res->GetSources();
+		for (size_t i = 1; i < _sources.size(); ++i)
+			_dst += String(_depth * 2 + 2, ' ') + "file \"" + _sources[i] + "\"\n";
+
+		for (const ResourcePtr& _dep : _slot.dependencies)
+			_Dump(_dep, _depth + 1, _dst);
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_Remove(Resource* _res)
+	{
+		if (_res->m_slot == ~0u)
+			_AddPending(); // requested by worker in this frame
+
+		if (_res->m_slot >= m_slots.size() || m_slots[_res->m_slot].resource != _res)
+			return;
+
+		ResourcePtr _hold = _res; // dependents can hold the last reference
+		_Unlink(_res);
+		for (Resource* _dependent : m_slots[_res->m_slot].dependents)
+		{
+			Array<ResourcePtr>& _deps = m_slots[_dependent->m_slot].dependencies;
+			_deps.erase(std::remove(_deps.begin(), _deps.end(), _hold), _deps.end());
+		}
+		m_slots[_res->m_slot].dependents.clear();
+
+		uint32 _index = _res->m_slot;
+		Slot& _slot = m_slots[_index];
+		_EraseName(_res, _slot.key);
+		_slot.key.clear();
+
+		TypeUsage& _usage = m_types[_slot.type];
+		_usage.cpuSize -= _slot.cpuSize;
+		_usage.gpuSize -= _slot.gpuSize;
+		_slot.cpuSize = 0;
+		_slot.gpuSize = 0;
+
+		_Invalidate(_res);
+		_slot.nextFree = m_freeSlot;
+		m_freeSlot = _index;
+		_res->m_slot = ~0u;
+		_slot.resource = nullptr; // can delete resource
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_Invalidate(Resource* _res)
+	{
+		if (_res->m_slot >= m_slots.size() || m_slots[_res->m_slot].resource != _res)
+			return;
+
+		uint32& _generation = m_slots[_res->m_slot].generation;
+		if (!++_generation)
+			_generation = 1; // zero is generation of null handle
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_UpdateSize(Resource* _res)
+	{
+		if (_res->m_slot >= m_slots.size() || m_slots[_res->m_slot].resource != _res)
+			return;
+
+		Slot& _slot = m_slots[_res->m_slot];
+		TypeUsage& _usage = m_types[_slot.type];
+		_usage.cpuSize -= _slot.cpuSize;
+		_usage.gpuSize -= _slot.gpuSize;
+		_slot.cpuSize = _res->GetCpuSize();
+		_slot.gpuSize = _res->GetGpuSize();
+		_usage.cpuSize += _slot.cpuSize;
+		_usage.gpuSize += _slot.gpuSize;
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_Upload(void)
+	{
+		auto _start = std::chrono::steady_clock::now();
+		uint64 _bytes = 0;
+		bool _first = true;
+		Array<Upload> _waiting;
+
+		for (;;)
+		{
+			Upload _upload;
+			{
+				std::lock_guard<std::mutex> _lock(m_uploadMutex);
+				if (m_uploads.empty())
+					break;
+
+				const Upload& _next = m_uploads.top();
+				if (!_first && !_next.resource->m_canceled)
+				{
+					float _time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _start).count();
+					if (_time >= m_uploadTime || _bytes + _next.resource->GetUploadSize() > m_uploadBytes)
+						break; // next frame
+				}
+
+				_upload = _next;
+				m_uploads.pop();
+			}
+
+			Resource* _res = _upload.resource;
+			if (_res->m_slot == ~0u)
+				_AddPending();
+			if (_res->m_canceled)
+			{
+				--m_numLoading;
+				continue;
+			}
+
+			if (!_upload.linked)
+			{
+				// dependencies are loaded in background too, resource waits for them
+				_SetDependencies(_res, _upload.dependencies, true, _upload.priority);
+				_upload.linked = true;
+			}
+			if (_IsWaiting(_res))
+			{
+				_waiting.push_back(std::move(_upload));
+				continue;
+			}
+
+			--m_numLoading;
+			_first = false;
+			_bytes += _res->GetUploadSize();
+
+			bool _loaded = _upload.loaded && _res->_MeasureEndLoad(_upload.record);
+			AddLoadRecord(_upload.record);
+			if (_loaded)
+			{
+				_res->m_state = Resource::State::Ready;
+			}
+			else
+			{
+				LOG("Error: Unable to load %s \"%s\"", _res->GetTypeName(), _res->GetName().c_str());
+				_res->m_state = Resource::State::Failed;
+			}
+
+			_UpdateSize(_res);
+			_Watch(_res);
+		}
+
+		std::lock_guard<std::mutex> _lock(m_uploadMutex);
+		for (Upload& _upload : _waiting)
+			m_uploads.push(std::move(_upload));
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_Watch(Resource* _res)
+	{
+		if (gFileWatcher)
+		{
+			for (const String& _source : _res->GetSources())
+				gFileWatcher->Watch(_source);
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void ResourceCache::_OnFileChanged(const String& _name)
+	{
+		String _key = FileSystem::IndexKey(_name);
+		Array<Resource*> _changed;
+
+		for (const Slot& _slot : m_slots)
+		{
+			if (!_slot.resource)
+				continue;
+
+			for (const String& _source : _slot.resource->GetSources())
+			{
+				if (FileSystem::IndexKey(_source) == _key)
+				{
+					_changed.push_back(_slot.resource);
+					break;
+				}
+			}
+		}
+
+		for (Resource* _res : _changed)
+			Reload(_res);
 	}
 	//----------------------------------------------------------------------------//
 
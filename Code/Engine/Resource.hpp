@@ -3,6 +3,7 @@
 #include "Object.hpp"
 #include "System.hpp"
 #include "File.hpp"
+#include "Thread.hpp"
 
 namespace Easy2D
 {
@@ -12,6 +13,24 @@ namespace Easy2D
 	
 	typedef SharedPtr<class Resource> ResourcePtr;
 
+	//! Measurements of one loading of resource
+	struct LoadRecord
+	{
+		String type;
+		String name;
+		uint thread = 0; //!< ThreadPool::ThreadIndex of thread which decoded resource, 0 for other threads
+		float ioTime = 0; //!< milliseconds of opening and reading of files
+		float decodeTime = 0; //!< milliseconds of BeginLoad without reading
+		float uploadTime = 0; //!< milliseconds of EndLoad
+		uint64 bytesRead = 0;
+		uint64 cpuSize = 0; //!< Resource::GetCpuSize after loading
+		uint64 gpuSize = 0; //!< Resource::GetGpuSize after loading
+		bool succeeded = false;
+
+		//! \return milliseconds of whole loading
+		float TotalTime(void) const { return ioTime + decodeTime + uploadTime; }
+	};
+
 	//!
 	class Resource abstract : public Object
 	{
@@ -19,29 +38,183 @@ namespace Easy2D
 		RTTI("Resource");
 
 		//!
+		enum class State
+		{
+			Unloaded,
+			Loading, //!< loading in background (ResourceCache::GetResourceAsync)
+			Ready,
+			Failed,
+		};
+
+		//! Resource or file which is needed to load resource
+		struct Dependency
+		{
+			String type; //!< type of resource or empty string for file which is read by BeginLoad
+			String name;
+		};
+
+		//! Declare dependencies before loading. Called with stream of resource before BeginLoad (possibly on worker thread), position of stream is restored after.
+		//! ResourceCache loads dependencies of whole tree at once and calls EndLoad after the dependencies are loaded.
+		virtual void GetDependencies(Stream* _src, Array<Dependency>& _deps) { }
+		//! Load resource. Calls BeginLoad and EndLoad by default and reports measurements to ResourceCache (AddLoadRecord).
 		virtual bool Load(Stream* _src);
+		//! First part of loading: reading and decoding. Can be called from worker thread, so must not use graphics.
+		virtual bool BeginLoad(Stream* _src);
+		//! Second part of loading on main thread: creation of graphics objects.
+		virtual bool EndLoad(void) { return true; }
 		//!
 		virtual bool Save(Stream* _dst);
+		//! Approximate number of bytes which EndLoad sends to GPU. Used for upload budget of asynchronous loading.
+		virtual size_t GetUploadSize(void) { return 0; }
+		//! Approximate size of data in system memory. Used for memory budget of ResourceCache.
+		virtual size_t GetCpuSize(void) { return 0; }
+		//! Approximate size of data in video memory. Used for memory budget of ResourceCache.
+		virtual size_t GetGpuSize(void) { return 0; }
+
+		//!
+		State GetState(void) { return m_state; }
+		//!
+		bool IsReady(void) { return m_state == State::Ready; }
 
 		//!
 		void SetName(const String& _name) { m_name = _name; }
 		//!
 		const String& GetName(void) { return m_name; }
 
+		//! Add file that is used by resource. Resource is reloaded when one of its sources was changed.
+		void AddSource(const String& _name) { m_sources.push_back(_name); }
+		//!
+		const Array<String>& GetSources(void) { return m_sources; }
+
+		//! Exchange content with other resource of same type. Used to replace live resource after reloading.
+		virtual void _Swap(Resource* _other) { std::swap(m_sources, _other->m_sources); }
+
 	protected:
+		friend class ResourceCache;
+
+		//! Call BeginLoad with measured stream, add times and bytes to record. _src can be nullptr.
+		bool _MeasureBeginLoad(Stream* _src, LoadRecord& _record);
+		//! Call EndLoad, add its time and sizes of resource to record
+		bool _MeasureEndLoad(LoadRecord& _record);
+
 		String m_name;
+		Array<String> m_sources;
+		std::atomic<State> m_state = { State::Unloaded };
+		std::atomic<bool> m_canceled = { false }; //!< asynchronous loading was canceled
+		uint32 m_slot = ~0u; //!< index of slot in ResourceCache
+	};
+
+	//----------------------------------------------------------------------------//
+	// ResourceHandle
+	//----------------------------------------------------------------------------//
+
+	//! Weak reference to cached resource: index of slot in ResourceCache and generation of slot.
+	/*!	Dereferencing is array access and comparison of generation, without hashing of names.
+		Generation of slot is changed when resource is removed from cache or reloaded, so old handles become stale (Get returns nullptr)
+		and must be resolved again by ResourceCache::GetHandle. Handles must be used only on main thread.
+	*/
+	template <class T> class ResourceHandle
+	{
+	public:
+		//! Null handle
+		ResourceHandle(void) = default;
+		//!
+		ResourceHandle(uint32 _index, uint32 _generation) : m_index(_index), m_generation(_generation) { }
+
+		//! \return resource or nullptr if handle is null or stale
+		T* Get(void) const;
+		//!
+		T* operator -> (void) const
+		{
+			T* _res = Get();
+			ASSERT(_res != nullptr);
+			return _res;
+		}
+		//! \return false if handle is null or stale
+		explicit operator bool (void) const { return Get() != nullptr; }
+
+		//!
+		bool operator == (const ResourceHandle& _rhs) const { return m_index == _rhs.m_index && m_generation == _rhs.m_generation; }
+		//!
+		bool operator != (const ResourceHandle& _rhs) const { return !(*this == _rhs); }
+
+		//!
+		uint32 Index(void) const { return m_index; }
+		//! Generation of slot. Null handle has zero generation.
+		uint32 Generation(void) const { return m_generation; }
+
+	protected:
+		uint32 m_index = 0;
+		uint32 m_generation = 0;
 	};
 
 	//----------------------------------------------------------------------------//
 	// ResourceCache
 	//----------------------------------------------------------------------------//
 
-#define gResources ResourceCache::Instance
+#define gResources ResourceCache::Get()
 
-	//!
+	//! Cache of loaded resources.
+	/*!	Resources can be loaded synchronously (GetResource) or in background (GetResourceAsync): BeginLoad (reading and decoding)
+		is executed on worker thread, EndLoad (creation of graphics objects) on main thread at the beginning of frame.
+		Number of EndLoad calls per frame is limited by time and by size of uploaded data, so loading does not stall frames.
+		Memory of each type of resources can be limited (SetBudget): at the beginning of frame, resources which are held only by the cache
+		are removed in least recently used order until size of the type is within budget. Removed resources are loaded again on next request.
+		Dependencies declared by resources (Resource::GetDependencies) form a graph: resources hold their dependencies, dependencies which
+		were not requested directly are temporary (removed with the last dependent), and reload of resource reloads its dependents.
+		Groups of resources listed in json manifests are loaded in parallel and released together (LoadGroup, UnloadGroup).
+		Names are stored in shards with own locks, so worker threads can look up and request resources (FindResource, RequestResource);
+		concurrent requests of the same resource share one loading. Other methods must be called on main thread.
+	*/
 	class ResourceCache : public Module<ResourceCache>
 	{
 	public:
+		enum : uint64
+		{
+			DefaultUploadBytes = 8 * 1024 * 1024, //!< default max size of data uploaded per frame
+			MaxLoadRecords = 4096, //!< older records are discarded, aggregated statistics are kept
+			NumShards = 32, //!< number of independently locked parts of map of names
+		};
+
+		//! Called on main thread when all resources of group are loaded
+		typedef std::function<void(const String& _group, bool _succeeded)> GroupCallback;
+
+		//!
+		struct GroupProgress
+		{
+			uint resources = 0;
+			uint loaded = 0; //!< ready or failed
+			uint failed = 0;
+			uint64 bytes = 0; //!< size of files of resources
+			uint64 bytesRemaining = 0; //!< size of files of resources which are loading
+			float fraction = 0; //!< 1 when group is loaded
+		};
+
+		//!
+		struct Stats
+		{
+			uint hits = 0; //!< requests of cached resources
+			uint misses = 0; //!< requests which created new resource
+			uint evictions = 0; //!< resources removed by Trim
+			uint resources = 0;
+			uint64 cpuSize = 0;
+			uint64 gpuSize = 0;
+		};
+
+		//! Aggregated measurements of loadings of one type
+		struct LoadStats
+		{
+			uint loads = 0;
+			uint failed = 0;
+			float ioTime = 0; //!< milliseconds
+			float decodeTime = 0;
+			float uploadTime = 0;
+			float maxTime = 0; //!< the slowest loading
+			uint64 bytesRead = 0;
+			uint64 cpuSize = 0;
+			uint64 gpuSize = 0;
+		};
+
 		//!
 		ResourceCache(void);
 		//!
@@ -50,7 +223,8 @@ namespace Easy2D
 		//!
 		bool OnEvent(int _type, void* _arg) override;
 
-		//!
+		//! Get resource, load it if needed. Resource which is loading in background is returned as is (State::Loading). Main thread only.
+		//! \param _tmp resource is removed from cache as soon as it is not used (at the beginning of next frame), regardless of budget
 		Resource* GetResource(const char* _type, const String& _name, uint _typeid = 0, bool _tmp = false);
 		//!
 		template <class T> T* GetResource(const String& _name, bool _tmp = false)
@@ -58,11 +232,258 @@ namespace Easy2D
 			return static_cast<T*>(GetResource(T::TypeName, _name, T::TypeID, _tmp));
 		}
 
+		//! Get resource and load it in background if needed. Resources with higher priority are loaded and uploaded first.
+		//! \return resource in State::Loading, or existent resource in its current state
+		Resource* GetResourceAsync(const char* _type, const String& _name, uint _typeid = 0, int _priority = ThreadPool::Normal);
+		//!
+		template <class T> T* GetResourceAsync(const String& _name, int _priority = ThreadPool::Normal)
+		{
+			return static_cast<T*>(GetResourceAsync(T::TypeName, _name, T::TypeID, _priority));
+		}
+		//! Find cached resource from any thread. Resource can be in any state.
+		//! \return resource or nullptr if it is not in cache
+		ResourcePtr FindResource(const char* _type, const String& _name, uint _typeid = 0);
+		//!
+		template <class T> SharedPtr<T> FindResource(const String& _name)
+		{
+			return FindResource(T::TypeName, _name, T::TypeID).template Cast<T>();
+		}
+		//! Get resource from any thread and load it in background if needed (GetResourceAsync on main thread).
+		//! If several threads request the same resource, only the first one starts loading and all of them receive the same resource.
+		//! Resource requested by worker is added to cache (handles, budget, dependencies) at the beginning of frame.
+		ResourcePtr RequestResource(const char* _type, const String& _name, uint _typeid = 0, int _priority = ThreadPool::Normal);
+		//!
+		template <class T> SharedPtr<T> RequestResource(const String& _name, int _priority = ThreadPool::Normal)
+		{
+			return RequestResource(T::TypeName, _name, T::TypeID, _priority).template Cast<T>();
+		}
+
+		//! Cancel background loading of resource which is not needed anymore. Resource is removed from cache and becomes Unloaded.
+		//! \return false if resource is not loading
+		bool Cancel(Resource* _res);
+		//! Set limits of EndLoad calls of asynchronous loading per frame. At least one resource is finished per frame.
+		void SetUploadBudget(float _milliseconds, uint64 _bytes);
+		//! \return number of resources which are loading in background
+		uint NumLoading(void) { return m_numLoading; }
+
+		//! Load resource again. New content is decoded in worker thread and replaces old content at the beginning of frame.
+		void Reload(Resource* _res);
+
+		//! Resolve name to handle, load resource if needed. Resolve it once and keep the handle in frequently executed code.
+		template <class T> ResourceHandle<T> GetHandle(const String& _name, bool _async = false)
+		{
+			return GetHandle<T>(_async ? GetResourceAsync<T>(_name) : GetResource<T>(_name));
+		}
+		//! \return handle of resource or null handle if resource is not in cache
+		template <class T> ResourceHandle<T> GetHandle(T* _res)
+		{
+			if (!_res || _res->m_slot >= m_slots.size() || m_slots[_res->m_slot].resource != _res)
+				return ResourceHandle<T>();
+			return ResourceHandle<T>(_res->m_slot, m_slots[_res->m_slot].generation);
+		}
+		//! \return resource of handle or nullptr if handle is null or stale
+		Resource* Resolve(uint32 _index, uint32 _generation)
+		{
+			if (_index >= m_slots.size() || m_slots[_index].generation != _generation)
+				return nullptr;
+			m_slots[_index].lastUse = m_frame;
+			return m_slots[_index].resource;
+		}
+
+		//! Set max size (system and video memory) of resources of type. Zero is unlimited (default).
+		void SetBudget(uint _typeid, uint64 _bytes);
+		//!
+		template <class T> void SetBudget(uint64 _bytes) { SetBudget(T::TypeID, _bytes); }
+		//! \return budget of type
+		uint64 GetBudget(uint _typeid);
+		//! \return size of cached resources of type
+		uint64 GetSize(uint _typeid);
+		//! Remove unused temporary resources and least recently used resources of types which exceed budget. Called at the beginning of frame.
+		void Trim(void);
+		//!
+		Stats GetStats(void);
+		//! \return text tree of cached resources and their dependencies (for diagnostics)
+		String DumpDependencies(void);
+
+		//! Add measurements of loading. Called by loading code from any thread.
+		void AddLoadRecord(const LoadRecord& _record);
+		//! Log warning about each loading which takes longer. Zero disables warnings (default).
+		void SetSlowLoadThreshold(float _milliseconds) { m_slowLoadTime = _milliseconds; }
+		//! \return the last MaxLoadRecords measurements in order of loading
+		Array<LoadRecord> GetLoadRecords(void);
+		//! \return statistics of loadings by name of type
+		HashMap<String, LoadStats> GetLoadStats(void);
+		//! Discard records and statistics (e.g. after startup)
+		void ClearLoadRecords(void);
+		//! \return text table of statistics by type and _slowest loadings
+		String PrintLoadReport(uint _slowest = 10);
+		//! Save statistics and records to json file (for comparison of runs in benchmarks)
+		bool SaveLoadReport(const String& _path);
+
+		//! Load group of resources in background. Manifest is json object with names of resources by type: { "Texture": [ "a.json", "b.png" ], "Sprite": [ ... ] }.
+		//! Resources are loaded in parallel, _onLoaded is called at the beginning of frame after all of them are loaded or failed.
+		//! Group holds the resources until UnloadGroup; loading of group again replaces it.
+		//! \return false if manifest cannot be loaded
+		bool LoadGroup(const String& _manifest, const GroupCallback& _onLoaded = nullptr, int _priority = ThreadPool::Normal);
+		//! Release resources of group. Resources which were loaded by the group and are not used elsewhere are removed from cache.
+		void UnloadGroup(const String& _manifest);
+		//!
+		GroupProgress GetGroupProgress(const String& _manifest);
+		//! \return true if group exists and all its resources are loaded or failed
+		bool IsGroupLoaded(const String& _manifest);
+
 	protected:
+		//! Resource decoded on worker thread and waiting for EndLoad
+		struct Upload
+		{
+			int priority;
+			uint64 order;
+			ResourcePtr resource;
+			bool loaded; //!< BeginLoad succeeded
+			Array<Resource::Dependency> dependencies; //!< declared on worker thread
+			bool linked = false; //!< dependencies were added to graph
+			LoadRecord record; //!< measurements of loading on worker thread
+
+			bool operator < (const Upload& _rhs) const { return priority < _rhs.priority || (priority == _rhs.priority && order > _rhs.order); }
+		};
+
+		//! Cached resource. Slots of removed resources are reused.
+		struct Slot
+		{
+			ResourcePtr resource;
+			String key; //!< key in shard
+			uint32 generation = 1;
+			uint32 nextFree = ~0u;
+			uint type = 0;
+			uint64 cpuSize = 0;
+			uint64 gpuSize = 0;
+			uint lastUse = 0; //!< number of frame
+			bool temporary = false;
+			Array<ResourcePtr> dependencies;
+			Array<Resource*> dependents;
+		};
+
+		//!
+		struct Group
+		{
+			String name; //!< name of manifest
+			Array<ResourcePtr> resources;
+			Array<uint64> sizes; //!< size of file of each resource
+			GroupCallback callback;
+			bool loaded = false;
+		};
+
+		//! Names of part of resources
+		struct Shard
+		{
+			std::mutex mutex;
+			HashMap<String, Resource*> names; //!< key of resource -> resource (held by slot or by m_pending)
+			uint hits = 0; //!< counted per shard, so threads do not share one counter
+			uint misses = 0;
+		};
+
+		//! Resource created by worker thread and waiting for slot
+		struct Pending
+		{
+			ResourcePtr resource;
+			String key;
+			uint type;
+		};
+
+		//! Memory of resources of one type
+		struct TypeUsage
+		{
+			uint64 budget = 0;
+			uint64 cpuSize = 0;
+			uint64 gpuSize = 0;
+		};
+
+		//! \return key of resource in shard
+		static String _Key(uint _typeid, const String& _name);
+		//!
+		Shard& _Shard(const String& _key) { return m_shards[std::hash<String>()(_key) % NumShards]; }
+		//! Find resource (thread-safe). New resource is created in Loading state if _create is true and waits for slot in m_pending.
+		ResourcePtr _Find(const char* _type, const String& _name, uint _typeid, bool _create, bool& _created);
+		//! Erase name of resource from its shard if the name still refers to the resource
+		void _EraseName(Resource* _res, const String& _key);
+		//! Give slots to resources created by _Find
+		void _AddPending(void);
+		//! Find resource or create new one and add it to cache. \return nullptr if type is unknown
+		Resource* _Create(const char* _type, const String& _name, uint _typeid, bool _tmp, bool& _created);
+		//! Load new resource and its dependencies on main thread
+		void _LoadSync(Resource* _res);
+		//! Load new resource in background
+		void _LoadAsync(Resource* _res, int _priority);
+		//! Get dependencies of resource and restore position of stream
+		static void _Declare(Resource* _res, Stream* _src, Array<Resource::Dependency>& _deps);
+		//! Read files of dependencies in background
+		static void _Prefetch(const Array<Resource::Dependency>& _deps, int _priority);
+		//! Replace dependencies of resource in graph, load new ones
+		void _SetDependencies(Resource* _res, const Array<Resource::Dependency>& _deps, bool _async, int _priority);
+		//! Remove dependencies of resource from graph
+		void _Unlink(Resource* _res);
+		//! \return true if _res depends on _dep directly or indirectly
+		bool _DependsOn(Resource* _res, Resource* _dep);
+		//! \return true if some of dependencies of resource is loading
+		bool _IsWaiting(Resource* _res);
+		//! Reload resources which depend on reloaded resource
+		void _ReloadDependents(Resource* _res);
+		//! Print resource and its dependencies
+		void _Dump(Resource* _res, uint _depth, String& _dst);
+		//! Call callbacks of loaded groups
+		void _UpdateGroups(void);
+		//! Remove resource from cache if only the cache holds it. \return false if resource is used
+		bool _Evict(Resource* _res);
+		//! Remove resource from cache. Its handles become stale.
+		void _Remove(Resource* _res);
+		//! Change generation of slot of resource, so its handles become stale
+		void _Invalidate(Resource* _res);
+		//! Update memory usage of resource after loading
+		void _UpdateSize(Resource* _res);
+		//! EndLoad resources decoded in background within upload budget
+		void _Upload(void);
+		//! Watch sources of loaded resource
+		void _Watch(Resource* _res);
+		//! Reload resources which use changed file
+		void _OnFileChanged(const String& _name);
+
+		std::thread::id m_mainThread;
+		Shard m_shards[NumShards];
+		std::mutex m_pendingMutex;
+		Array<Pending> m_pending;
+
+		Array<Slot> m_slots;
+		uint32 m_freeSlot = ~0u; //!< first free slot
+		HashMap<uint, TypeUsage> m_types;
+		HashMap<String, Group> m_groups; //!< IndexKey of manifest -> group
+		uint m_frame = 0;
+		Stats m_stats; //!< hits and misses are counted by shards
+		HashMap<Resource*, uint> m_reloads; //!< resource -> number of last reload
+		uint m_reloadCounter = 0;
+
+		std::mutex m_uploadMutex;
+		std::priority_queue<Upload> m_uploads;
+		uint64 m_uploadOrder = 0;
+		float m_uploadTime = 2; //!< milliseconds per frame
+		uint64 m_uploadBytes = DefaultUploadBytes;
+		std::atomic<uint> m_numLoading = { 0 };
 
-		HashMap<uint, HashMap<uint, ResourcePtr>> m_resources;
+		std::mutex m_loadMutex;
+		std::deque<LoadRecord> m_loadRecords;
+		HashMap<String, LoadStats> m_loadStats; //!< type -> statistics
+		float m_slowLoadTime = 0; //!< milliseconds
 	};
 
+	//----------------------------------------------------------------------------//
+	// ResourceHandle
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	template <class T> T* ResourceHandle<T>::Get(void) const
+	{
+		return static_cast<T*>(gResources->Resolve(m_index, m_generation));
+	}
+
 	//----------------------------------------------------------------------------//
 	//
 	//----------------------------------------------------------------------------//
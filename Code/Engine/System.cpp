@@ -1,43 +1,32 @@
 #include "System.hpp"
+#include <atomic>
 
 namespace Easy2D
 {
 	//----------------------------------------------------------------------------//
-	// System
+	// Context
 	//----------------------------------------------------------------------------//
 
-	System* System::s_first = nullptr;
-	System* System::s_last = nullptr;
+	thread_local Context* Context::s_current = nullptr;
 
 	//----------------------------------------------------------------------------//
-	System::System(void)
+	Context::Context(void)
 	{
-		m_prev = s_last;
-		if (m_prev)
-			m_prev->m_next = this;
-		else
-			s_first = this;
-		s_last = this;
+		memset(m_instances, 0, sizeof(m_instances));
 	}
 	//----------------------------------------------------------------------------//
-	System::~System(void)
+	Context::~Context(void)
 	{
-		if (m_prev)
-			m_prev->m_next = m_next;
-		else
-			s_first = m_next;
-
-		if (m_next)
-			m_next->m_prev = m_prev;
-		else
-			s_last = m_prev;
+		Scope _scope(this);
+		while (m_last)
+			delete m_last;
 	}
 	//----------------------------------------------------------------------------//
-	bool System::SendEvent(int _event, void* _arg, bool _defaultOrder)
+	bool Context::SendEvent(int _event, void* _arg, bool _defaultOrder)
 	{
 		if (_defaultOrder)
 		{
-			for (System* i = s_last; i; i = i->m_prev)
+			for (System* i = m_last; i; i = i->m_prev)
 			{
 				if (i->OnEvent(_event, _arg))
 					return true;
@@ -45,7 +34,7 @@ namespace Easy2D
 		}
 		else
 		{
-			for (System* i = s_first; i; i = i->m_next)
+			for (System* i = m_first; i; i = i->m_next)
 			{
 				if (i->OnEvent(_event, _arg))
 					return true;
@@ -54,6 +43,50 @@ namespace Easy2D
 		return false;
 	}
 	//----------------------------------------------------------------------------//
+	Context* Context::Default(void)
+	{
+		static Context _default;
+		return &_default;
+	}
+	//----------------------------------------------------------------------------//
+	uint Context::_AllocSlot(void)
+	{
+		static std::atomic<uint> _counter(0);
+		uint _slot = _counter++;
+		ASSERT(_slot < MaxInstances);
+		return _slot;
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	// System
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	System::System(void) :
+		m_owner(Context::Current())
+	{
+		m_prev = m_owner->m_last;
+		if (m_prev)
+			m_prev->m_next = this;
+		else
+			m_owner->m_first = this;
+		m_owner->m_last = this;
+	}
+	//----------------------------------------------------------------------------//
+	System::~System(void)
+	{
+		if (m_prev)
+			m_prev->m_next = m_next;
+		else
+			m_owner->m_first = m_next;
+
+		if (m_next)
+			m_next->m_prev = m_prev;
+		else
+			m_owner->m_last = m_prev;
+	}
+	//----------------------------------------------------------------------------//
 
 	//----------------------------------------------------------------------------//
 	//
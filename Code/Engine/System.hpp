@@ -24,7 +24,105 @@ namespace Easy2D
 
 			Stop = StringUtils::ConstHash("SystemEvent::Stop"),
 			Shutdown = StringUtils::ConstHash("SystemEvent::Shutdown"),
+
+			FileChanged = StringUtils::ConstHash("SystemEvent::FileChanged"), //!< arg is const String* (relative name of file)
+		};
+	};
+
+	//----------------------------------------------------------------------------//
+	// Context
+	//----------------------------------------------------------------------------//
+
+	class System;
+
+	//! Set of systems and context singletons. Each thread has own current context.
+	class Context : public NonCopyable
+	{
+	public:
+		//!
+		enum : uint { MaxInstances = 64 };
+
+		//!
+		class Scope : public NonCopyable
+		{
+		public:
+			//! Make context current for this thread
+			Scope(Context* _context) : m_prev(s_current) { s_current = _context; }
+			//! Restore previous context
+			~Scope(void) { s_current = m_prev; }
+
+		private:
+			Context* m_prev;
 		};
+
+		//!
+		Context(void);
+		//!	Delete all systems of this context in reverse order
+		~Context(void);
+
+		//!
+		bool SendEvent(int _event, void* _arg = nullptr, bool _defaultOrder = true);
+
+		//! \return current context of this thread or default context
+		static Context* Current(void) { return s_current ? s_current : Default(); }
+		//! Make context current for this thread
+		static void SetCurrent(Context* _context) { s_current = _context; }
+		//! \return process-wide context
+		static Context* Default(void);
+
+		//!
+		void*& _Instance(uint _slot) { ASSERT(_slot < MaxInstances); return m_instances[_slot]; }
+		//!
+		static uint _AllocSlot(void);
+
+	protected:
+		friend class System;
+
+		System* m_first = nullptr;
+		System* m_last = nullptr;
+		void* m_instances[MaxInstances];
+
+		static thread_local Context* s_current;
+	};
+
+	//----------------------------------------------------------------------------//
+	// ContextSingleton
+	//----------------------------------------------------------------------------//
+
+	//! Singleton bound to current context
+	template <class T> class ContextSingleton
+	{
+	public:
+		//!
+		ContextSingleton(void) :
+			m_context(Context::Current())
+		{
+			ASSERT(m_context->_Instance(Slot()) == nullptr);
+			m_context->_Instance(Slot()) = static_cast<T*>(this);
+		}
+		//!
+		~ContextSingleton(void)
+		{
+			m_context->_Instance(Slot()) = nullptr;
+		}
+
+		//! \return instance of current context
+		static T* Get(void)
+		{
+			return static_cast<T*>(Context::Current()->_Instance(Slot()));
+		}
+		//!
+		static uint Slot(void)
+		{
+			static const uint _slot = Context::_AllocSlot();
+			return _slot;
+		}
+
+		//!
+		Context* GetContext(void) { return m_context; }
+
+	protected:
+		Context* m_context;
 	};
 
 	//----------------------------------------------------------------------------//
@@ -43,21 +141,21 @@ namespace Easy2D
 		virtual bool OnEvent(int _type, void* _arg) { return false; }
 
 		//!
-		static bool SendEvent(int _event, void* _arg = nullptr, bool _defaultOrder = true);
+		static bool SendEvent(int _event, void* _arg = nullptr, bool _defaultOrder = true) { return Context::Current()->SendEvent(_event, _arg, _defaultOrder); }
 
 	private:
+		friend class Context;
 
+		Context* m_owner = nullptr;
 		System* m_prev = nullptr;
 		System* m_next = nullptr;
-		static System* s_first;
-		static System* s_last;
 	};
 
 	//----------------------------------------------------------------------------//
 	// Module
 	//----------------------------------------------------------------------------//
 
-	template <class T> class Module : public System, public Singleton<T>
+	template <class T> class Module : public System, public ContextSingleton<T>
 	{
 
 	};
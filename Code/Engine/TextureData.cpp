@@ -0,0 +1,319 @@
+#include "TextureData.hpp"
+#include "Math.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// TextureData
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	void TextureData::Build(const uint8* _pixels, uint _width, uint _height, uint _channels, bool _compress, bool _mips, uint32 _type, Array<uint8>& _dst)
+	{
+		ASSERT(_pixels && _width && _height && _channels >= 1 && _channels <= 4);
+
+		Header _header;
+		_header.width = _width;
+		_header.height = _height;
+		_header.channels = _channels;
+		_header.compression = _compress ? (_channels == 4 ? Compression::Dxt5 : Compression::Dxt1) : Compression::None;
+		_header.levels = 1;
+		_header.type = _type;
+		for (uint _w = _width, _h = _height; _mips && (_w > 1 || _h > 1); _w = Max(_w / 2, 1u), _h = Max(_h / 2, 1u))
+			++_header.levels;
+
+		size_t _total = sizeof(_header);
+		for (uint i = 0; i < _header.levels; ++i)
+			_total += LevelSize(_header, Max(_width >> i, 1u), Max(_height >> i, 1u));
+
+		_dst.resize(_total);
+		memcpy(_dst.data(), &_header, sizeof(_header));
+		uint8* _out = _dst.data() + sizeof(_header);
+
+		const uint8* _src = _pixels;
+		Array<uint8> _level, _next, _rgba;
+		for (uint i = 0, _w = _width, _h = _height; i < _header.levels; ++i, _w = Max(_w / 2, 1u), _h = Max(_h / 2, 1u))
+		{
+			if (_header.compression != Compression::None)
+			{
+				_rgba.resize(_w * _h * 4);
+				for (uint p = 0, _n = _w * _h; p < _n; ++p)
+				{
+					const uint8* _s = _src + p * _channels;
+					uint8* _d = _rgba.data() + p * 4;
+					_d[0] = _s[0];
+					_d[1] = _channels >= 3 ? _s[1] : _s[0];
+					_d[2] = _channels >= 3 ? _s[2] : _s[0];
+					_d[3] = _channels == 4 ? _s[3] : 255;
+				}
+				CompressDxt(_rgba.data(), _w, _h, _header.compression == Compression::Dxt5, _out);
+			}
+			else
+			{
+				memcpy(_out, _src, _w * _h * _channels);
+			}
+			_out += LevelSize(_header, _w, _h);
+
+			if (i + 1 < _header.levels)
+			{
+				_next.resize(Max(_w / 2, 1u) * Max(_h / 2, 1u) * _channels);
+				_Downsample(_src, _w, _h, _channels, _next.data());
+				_level.swap(_next);
+				_src = _level.data();
+			}
+		}
+	}
+	//----------------------------------------------------------------------------//
+	const TextureData::Header* TextureData::Parse(const void* _data, size_t _size)
+	{
+		if (!_data || _size < sizeof(Header))
+			return nullptr;
+
+		const Header* _header = reinterpret_cast<const Header*>(_data);
+		if (_header->magic != Magic || _header->version != Version || !_header->width || !_header->height ||
+			_header->channels < 1 || _header->channels > 4 || _header->levels < 1 || _header->levels > 32)
+			return nullptr;
+
+		switch (_header->compression)
+		{
+		case Compression::None:
+		case Compression::Dxt1:
+		case Compression::Dxt5:
+			break;
+		default:
+			return nullptr;
+		}
+
+		size_t _total = sizeof(Header);
+		for (uint i = 0; i < _header->levels; ++i)
+			_total += LevelSize(*_header, Max(_header->width >> i, 1u), Max(_header->height >> i, 1u));
+
+		return _total <= _size ? _header : nullptr;
+	}
+	//----------------------------------------------------------------------------//
+	StreamPtr TextureData::Read(Stream* _src)
+	{
+		ASSERT(_src != nullptr);
+
+		uint64 _start = _src->Tell();
+		size_t _size = (size_t)(_src->Size() - _start);
+		if (_src->Data())
+			return Parse(_src->Data() + _start, _size) ? _src : nullptr;
+
+		Header _header;
+		if (_src->Read(&_header, sizeof(_header)) != sizeof(_header) || _header.magic != Magic)
+		{
+			_src->Seek(_start, Stream::SeekOrigin::Set);
+			return nullptr;
+		}
+
+		MemoryStreamPtr _data = new MemoryStream(_src->Name());
+		_data->Buffer().resize(_size);
+		memcpy(_data->Buffer().data(), &_header, sizeof(_header));
+		_src->Read(_data->Buffer().data() + sizeof(_header), _size - sizeof(_header));
+		if (!Parse(_data->Data(), _size))
+		{
+			LOG("Error: Texture data \"%s\" is invalid", _src->Name().c_str());
+			return nullptr;
+		}
+		return _data.Cast<Stream>();
+	}
+	//----------------------------------------------------------------------------//
+	const uint8* TextureData::Level(const Header* _header, uint _level, uint& _width, uint& _height, size_t& _size)
+	{
+		ASSERT(_header && _level < _header->levels);
+
+		const uint8* _data = reinterpret_cast<const uint8*>(_header + 1);
+		for (uint i = 0;; ++i)
+		{
+			_width = Max(_header->width >> i, 1u);
+			_height = Max(_header->height >> i, 1u);
+			_size = LevelSize(*_header, _width, _height);
+			if (i == _level)
+				return _data;
+			_data += _size;
+		}
+	}
+	//----------------------------------------------------------------------------//
+	size_t TextureData::LevelSize(const Header& _header, uint _width, uint _height)
+	{
+		switch (_header.compression)
+		{
+		case Compression::None:
+			return (size_t)_width * _height * _header.channels;
+		case Compression::Dxt1:
+			return (size_t)((_width + 3) / 4) * ((_height + 3) / 4) * 8;
+		case Compression::Dxt5:
+			return (size_t)((_width + 3) / 4) * ((_height + 3) / 4) * 16;
+		default: // unknown compression is rejected by Parse
+			return 0;
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void TextureData::CompressDxt(const uint8* _rgba, uint _width, uint _height, bool _alpha, uint8* _dst)
+	{
+		uint8 _block[64];
+		for (uint _by = 0; _by < _height; _by += 4)
+		{
+			for (uint _bx = 0; _bx < _width; _bx += 4)
+			{
+				// pixels outside of image repeat the edge
+				for (uint y = 0; y < 4; ++y)
+				{
+					for (uint x = 0; x < 4; ++x)
+						memcpy(_block + (y * 4 + x) * 4, _rgba + (Min(_by + y, _height - 1) * _width + Min(_bx + x, _width - 1)) * 4, 4);
+				}
+
+				if (_alpha)
+				{
+					_CompressAlpha(_block, _dst);
+					_dst += 8;
+				}
+				_CompressColor(_block, _dst);
+				_dst += 8;
+			}
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void TextureData::_Downsample(const uint8* _src, uint _width, uint _height, uint _channels, uint8* _dst)
+	{
+		uint _w = Max(_width / 2, 1u);
+		uint _h = Max(_height / 2, 1u);
+		for (uint y = 0; y < _h; ++y)
+		{
+			const uint8* _row0 = _src + Min(y * 2, _height - 1) * _width * _channels;
+			const uint8* _row1 = _src + Min(y * 2 + 1, _height - 1) * _width * _channels;
+			for (uint x = 0; x < _w; ++x)
+			{
+				uint _x0 = Min(x * 2, _width - 1) * _channels;
+				uint _x1 = Min(x * 2 + 1, _width - 1) * _channels;
+				for (uint c = 0; c < _channels; ++c)
+					*_dst++ = (uint8)((_row0[_x0 + c] + _row0[_x1 + c] + _row1[_x0 + c] + _row1[_x1 + c] + 2) >> 2);
+			}
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void TextureData::_CompressColor(const uint8* _block, uint8* _dst)
+	{
+		// endpoints are corners of bounding box along the main diagonal of colors
+		int _min[3] = { 255, 255, 255 }, _max[3] = { 0, 0, 0 }, _mean[3] = { 0, 0, 0 };
+		for (uint i = 0; i < 16; ++i)
+		{
+			for (uint c = 0; c < 3; ++c)
+			{
+				int _v = _block[i * 4 + c];
+				_min[c] = Min(_min[c], _v);
+				_max[c] = Max(_max[c], _v);
+				_mean[c] += _v;
+			}
+		}
+
+		int _covRG = 0, _covRB = 0;
+		for (uint i = 0; i < 16; ++i)
+		{
+			int _r = _block[i * 4] * 16 - _mean[0];
+			_covRG += _r * (_block[i * 4 + 1] * 16 - _mean[1]);
+			_covRB += _r * (_block[i * 4 + 2] * 16 - _mean[2]);
+		}
+
+		for (uint c = 0; c < 3; ++c)
+		{
+			int _inset = (_max[c] - _min[c]) >> 4; // extremes are rare, move endpoints inside
+			_min[c] += _inset;
+			_max[c] -= _inset;
+		}
+		if (_covRG < 0)
+			std::swap(_min[1], _max[1]);
+		if (_covRB < 0)
+			std::swap(_min[2], _max[2]);
+
+		uint16 _c0 = (uint16)((((_max[0] * 31 + 127) / 255) << 11) | (((_max[1] * 63 + 127) / 255) << 5) | ((_max[2] * 31 + 127) / 255));
+		uint16 _c1 = (uint16)((((_min[0] * 31 + 127) / 255) << 11) | (((_min[1] * 63 + 127) / 255) << 5) | ((_min[2] * 31 + 127) / 255));
+		if (_c0 < _c1)
+			std::swap(_c0, _c1); // four colors mode
+
+		uint32 _indices = 0;
+		if (_c0 != _c1)
+		{
+			int _palette[4][3];
+			for (uint i = 0; i < 2; ++i)
+			{
+				uint16 _c = i ? _c1 : _c0;
+				_palette[i][0] = ((_c >> 11) << 3) | (_c >> 13);
+				_palette[i][1] = (((_c >> 5) & 63) << 2) | ((_c >> 9) & 3);
+				_palette[i][2] = ((_c & 31) << 3) | ((_c >> 2) & 7);
+			}
+			for (uint c = 0; c < 3; ++c)
+			{
+				_palette[2][c] = (2 * _palette[0][c] + _palette[1][c]) / 3;
+				_palette[3][c] = (_palette[0][c] + 2 * _palette[1][c]) / 3;
+			}
+
+			for (uint i = 0; i < 16; ++i)
+			{
+				uint _best = 0;
+				int _bestDist = 1 << 30;
+				for (uint j = 0; j < 4; ++j)
+				{
+					int _dr = _block[i * 4] - _palette[j][0];
+					int _dg = _block[i * 4 + 1] - _palette[j][1];
+					int _db = _block[i * 4 + 2] - _palette[j][2];
+					int _dist = _dr * _dr + _dg * _dg + _db * _db;
+					if (_dist < _bestDist)
+						_best = j, _bestDist = _dist;
+				}
+				_indices |= _best << (i * 2);
+			}
+		}
+
+		_dst[0] = (uint8)_c0;
+		_dst[1] = (uint8)(_c0 >> 8);
+		_dst[2] = (uint8)_c1;
+		_dst[3] = (uint8)(_c1 >> 8);
+		for (uint i = 0; i < 4; ++i)
+			_dst[4 + i] = (uint8)(_indices >> (i * 8));
+	}
+	//----------------------------------------------------------------------------//
+	void TextureData::_CompressAlpha(const uint8* _block, uint8* _dst)
+	{
+		int _a0 = 0, _a1 = 255;
+		for (uint i = 0; i < 16; ++i)
+		{
+			_a0 = Max<int>(_a0, _block[i * 4 + 3]);
+			_a1 = Min<int>(_a1, _block[i * 4 + 3]);
+		}
+
+		uint64 _indices = 0;
+		if (_a0 != _a1)
+		{
+			// eight alphas mode (a0 > a1)
+			int _palette[8] = { _a0, _a1 };
+			for (int i = 1; i < 7; ++i)
+				_palette[i + 1] = ((7 - i) * _a0 + i * _a1) / 7;
+
+			for (uint i = 0; i < 16; ++i)
+			{
+				uint64 _best = 0;
+				int _bestDist = 1 << 30;
+				for (uint j = 0; j < 8; ++j)
+				{
+					int _d = _block[i * 4 + 3] - _palette[j];
+					int _dist = _d * _d;
+					if (_dist < _bestDist)
+						_best = j, _bestDist = _dist;
+				}
+				_indices |= _best << (i * 3);
+			}
+		}
+
+		_dst[0] = (uint8)_a0;
+		_dst[1] = (uint8)_a1;
+		for (uint i = 0; i < 6; ++i)
+			_dst[2 + i] = (uint8)(_indices >> (i * 8));
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
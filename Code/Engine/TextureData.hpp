@@ -0,0 +1,75 @@
+#pragma once
+
+#include "File.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// TextureData
+	//----------------------------------------------------------------------------//
+
+	//! Texture ready for upload: mip levels of pixels, optionally compressed to DXT blocks.
+	/*!	Layout: Header | level 0 | level 1 | ... Levels of compressed texture consist of 4x4 blocks, so their size is rounded up.
+		Built from decoded image once and stored in DerivedDataCache, so warm loads skip decoding and compression.
+	*/
+	struct TextureData
+	{
+		enum : uint32
+		{
+			Magic = 0x54443245, //!< "E2DT"
+			Version = 2,
+		};
+
+		//!
+		enum class Compression : uint32
+		{
+			None = 0,
+			Dxt1 = 1, //!< 8 bytes per block, no alpha
+			Dxt5 = 5, //!< 16 bytes per block
+		};
+
+		//!
+		struct Header
+		{
+			uint32 magic = Magic;
+			uint32 version = Version;
+			uint32 width = 0;
+			uint32 height = 0;
+			uint32 channels = 0; //!< channels of uncompressed pixels
+			Compression compression = Compression::None;
+			uint32 levels = 0;
+			uint32 type = 0; //!< Texture::Type
+		};
+
+		//! Build data from decoded pixels.
+		/*!	\param _compress compress to DXT1 (1-3 channels) or DXT5 (4 channels)
+			\param _mips generate full chain of mip levels
+			\param _type Texture::Type, stored for cooked textures which are loaded without descriptor
+		*/
+		static void Build(const uint8* _pixels, uint _width, uint _height, uint _channels, bool _compress, bool _mips, uint32 _type, Array<uint8>& _dst);
+		//! \return header or nullptr if data is not valid
+		static const Header* Parse(const void* _data, size_t _size);
+		//! Read cooked data. Stream is returned itself if it has direct access to data, otherwise the data is read to memory.
+		//! \return stream with valid data at Data() + Tell() or nullptr (position of _src is unchanged) if _src does not contain TextureData
+		static StreamPtr Read(Stream* _src);
+		//! \return data of level and its size
+		static const uint8* Level(const Header* _header, uint _level, uint& _width, uint& _height, size_t& _size);
+		//! \return size of level in bytes or 0 if compression is unknown
+		static size_t LevelSize(const Header& _header, uint _width, uint _height);
+
+		//! Compress RGBA pixels to DXT1 (_alpha = false) or DXT5 blocks
+		static void CompressDxt(const uint8* _rgba, uint _width, uint _height, bool _alpha, uint8* _dst);
+
+	protected:
+		//! Halve image by box filter. Odd edge is repeated.
+		static void _Downsample(const uint8* _src, uint _width, uint _height, uint _channels, uint8* _dst);
+		//! Compress color of 4x4 RGBA pixels to 8 bytes
+		static void _CompressColor(const uint8* _block, uint8* _dst);
+		//! Compress alpha of 4x4 RGBA pixels to 8 bytes
+		static void _CompressAlpha(const uint8* _block, uint8* _dst);
+	};
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
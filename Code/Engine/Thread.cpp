@@ -0,0 +1,190 @@
+#include "Thread.hpp"
+#include "Math.hpp"
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// ThreadPool
+	//----------------------------------------------------------------------------//
+
+	//! index of worker, 0 on other threads
+	static thread_local uint s_threadIndex = 0;
+
+	//----------------------------------------------------------------------------//
+	ThreadPool::ThreadPool(uint _numThreads)
+	{
+		if (!_numThreads)
+		{
+			_numThreads = std::thread::hardware_concurrency();
+			_numThreads = _numThreads > 1 ? _numThreads - 1 : 1;
+		}
+
+		m_threads.reserve(_numThreads);
+		for (uint i = 0; i < _numThreads; ++i)
+			m_threads.push_back(std::thread(&ThreadPool::_Worker, this, i + 1));
+	}
+	//----------------------------------------------------------------------------//
+	ThreadPool::~ThreadPool(void)
+	{
+		_Stop();
+	}
+	//----------------------------------------------------------------------------//
+	bool ThreadPool::OnEvent(int _type, void* _arg)
+	{
+		switch (_type)
+		{
+		case SystemEvent::BeginFrame:
+		{
+			ExecuteMain();
+
+		} break;
+		case SystemEvent::Shutdown:
+		{
+			_Stop();
+
+		} break;
+		}
+
+		return false;
+	}
+	//----------------------------------------------------------------------------//
+	void ThreadPool::Push(const Task& _task, int _priority)
+	{
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			if (!m_stop)
+			{
+				m_queue.push({ _priority, m_order++, Context::Current(), _task });
+				++m_pending;
+				m_signal.notify_one();
+				return;
+			}
+		}
+		_task(); // workers are stopped
+	}
+	//----------------------------------------------------------------------------//
+	void ThreadPool::PushMain(const Task& _task)
+	{
+		std::lock_guard<std::mutex> _lock(m_mainMutex);
+		if (!m_stop)
+			m_mainQueue.push_back(_task);
+	}
+	//----------------------------------------------------------------------------//
+	void ThreadPool::ExecuteMain(void)
+	{
+		Array<Task> _tasks;
+		{
+			std::lock_guard<std::mutex> _lock(m_mainMutex);
+			_tasks.swap(m_mainQueue);
+		}
+
+		for (Task& _task : _tasks)
+			_task();
+	}
+	//----------------------------------------------------------------------------//
+	void ThreadPool::ParallelFor(uint _count, const std::function<void(uint)>& _func, int _priority)
+	{
+		// shared with tasks which can start after the loop was finished
+		struct Loop : public RefCounted
+		{
+			std::function<void(uint)> func;
+			uint count;
+			std::atomic<uint> next = { 0 };
+			std::atomic<uint> done = { 0 };
+			std::mutex mutex;
+			std::condition_variable signal;
+
+			void Run(void)
+			{
+				for (uint i; (i = next++) < count;)
+				{
+					func(i);
+					if (++done == count)
+					{
+						std::lock_guard<std::mutex> _lock(mutex);
+						signal.notify_all();
+					}
+				}
+			}
+		};
+
+		if (_count <= 1)
+		{
+			if (_count)
+				_func(0);
+			return;
+		}
+
+		SharedPtr<Loop> _loop = new Loop;
+		_loop->func = _func;
+		_loop->count = _count;
+
+		uint _helpers = Min<uint>(_count - 1, NumThreads());
+		for (uint i = 0; i < _helpers; ++i)
+			Push([_loop]() { _loop->Run(); }, _priority);
+
+		_loop->Run();
+
+		std::unique_lock<std::mutex> _lock(_loop->mutex);
+		_loop->signal.wait(_lock, [&_loop] { return _loop->done == _loop->count; });
+	}
+	//----------------------------------------------------------------------------//
+	uint ThreadPool::ThreadIndex(void)
+	{
+		return s_threadIndex;
+	}
+	//----------------------------------------------------------------------------//
+	void ThreadPool::_Worker(uint _index)
+	{
+		s_threadIndex = _index;
+
+		for (;;)
+		{
+			Item _item;
+			{
+				std::unique_lock<std::mutex> _lock(m_mutex);
+				m_signal.wait(_lock, [this] { return m_stop || !m_queue.empty(); });
+				if (m_queue.empty())
+					return; // stopped and drained
+
+				_item = m_queue.top();
+				m_queue.pop();
+			}
+
+			{
+				Context::Scope _scope(_item.context);
+				_item.task();
+			}
+			--m_pending;
+		}
+	}
+	//----------------------------------------------------------------------------//
+	void ThreadPool::_Stop(void)
+	{
+		{
+			std::lock_guard<std::mutex> _lock(m_mutex);
+			std::lock_guard<std::mutex> _mainLock(m_mainMutex);
+			if (m_stop)
+				return;
+			m_stop = true;
+		}
+		m_signal.notify_all();
+
+		// queued tasks are executed: writes of files must not be lost
+		for (std::thread& _thread : m_threads)
+			_thread.join();
+		m_threads.clear();
+
+		// released outside of lock, destructors of captured objects can push tasks
+		Array<Task> _main;
+		{
+			std::lock_guard<std::mutex> _lock(m_mainMutex);
+			_main.swap(m_mainQueue);
+		}
+	}
+	//----------------------------------------------------------------------------//
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
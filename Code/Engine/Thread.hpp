@@ -0,0 +1,94 @@
+#pragma once
+
+#include "System.hpp"
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+
+namespace Easy2D
+{
+	//----------------------------------------------------------------------------//
+	// ThreadPool
+	//----------------------------------------------------------------------------//
+
+#define gThreadPool ThreadPool::Get()
+
+	//! Worker threads and queue of tasks for main thread.
+	/*!	Tasks are executed with context of thread that pushed them, so worker tasks can use modules (gFileSystem etc.).
+		Main-thread tasks are executed at the beginning of frame (SystemEvent::BeginFrame).
+	*/
+	class ThreadPool : public Module<ThreadPool>
+	{
+	public:
+		//!
+		typedef std::function<void(void)> Task;
+
+		//!
+		enum Priority : int
+		{
+			Low = -100,
+			Normal = 0,
+			High = 100,
+		};
+
+		//!	\param _numThreads number of workers, 0 = number of hardware threads - 1
+		ThreadPool(uint _numThreads = 0);
+		//!
+		~ThreadPool(void);
+
+		//!
+		bool OnEvent(int _type, void* _arg) override;
+
+		//! Execute task on worker thread. Tasks with higher priority are executed first.
+		//!	After shutdown of pool the task is executed on calling thread.
+		void Push(const Task& _task, int _priority = Normal);
+		//! Execute task on main thread at the beginning of next frame. Tasks pushed after shutdown are dropped.
+		void PushMain(const Task& _task);
+		//! Execute queued main-thread tasks
+		void ExecuteMain(void);
+		//! Call _func(i) for i in [0, _count) on workers and calling thread. Returns when all calls are finished.
+		/*!	Calling thread takes part in the work, so it can be called from worker task. */
+		void ParallelFor(uint _count, const std::function<void(uint)>& _func, int _priority = Normal);
+
+		//!
+		uint NumThreads(void) { return (uint)m_threads.size(); }
+		//! \return number of queued and running worker tasks
+		uint NumPending(void) { return m_pending; }
+		//! \return 1-based index of worker of calling thread or 0 if it is not a worker
+		static uint ThreadIndex(void);
+
+	protected:
+		//!
+		struct Item
+		{
+			int priority;
+			uint64 order;
+			Context* context;
+			Task task;
+
+			bool operator < (const Item& _rhs) const { return priority < _rhs.priority || (priority == _rhs.priority && order > _rhs.order); }
+		};
+
+		//! \param _index 1-based index of worker
+		void _Worker(uint _index);
+		//! Execute queued tasks, stop workers and drop tasks of main thread
+		void _Stop(void);
+
+		std::mutex m_mutex;
+		std::condition_variable m_signal;
+		std::priority_queue<Item> m_queue;
+		Array<std::thread> m_threads;
+		uint64 m_order = 0;
+		std::atomic<uint> m_pending = { 0 };
+		bool m_stop = false;
+
+		std::mutex m_mainMutex;
+		Array<Task> m_mainQueue;
+	};
+
+	//----------------------------------------------------------------------------//
+	//
+	//----------------------------------------------------------------------------//
+}
@@ -8,7 +8,7 @@ namespace Easy2D
 	// Time
 	//----------------------------------------------------------------------------//
 
-#define gTime Time::Instance
+#define gTime Time::Get()
 
 	class Time : public Module<Time>
 	{
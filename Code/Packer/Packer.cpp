@@ -0,0 +1,74 @@
+#include <Easy2D.hpp>
+
+using namespace Easy2D;
+
+//----------------------------------------------------------------------------//
+// PrintUsage
+//----------------------------------------------------------------------------//
+
+int PrintUsage(void)
+{
+	printf("Usage:\n");
+	printf("  Packer <output.pak> <directory> [-a <alignment>] [-c]   pack all files of directory, -c compresses entries (LZ4)\n");
+	printf("  Packer -l <package.pak>                                 list and verify entries\n");
+	return 1;
+}
+
+//----------------------------------------------------------------------------//
+// ListPackage
+//----------------------------------------------------------------------------//
+
+int ListPackage(const char* _name)
+{
+	PackagePtr _package = new Package;
+	if (!_package->Open(_name))
+		return 2;
+
+	int _errors = 0;
+	for (const Package::Entry& _e : _package->Entries())
+	{
+		bool _ok = _package->Verify(&_e);
+		printf("%10llu %10llu %-4s %08x %s%s\n", (unsigned long long)_e.size, (unsigned long long)_e.packedSize, _e.codec == (uint32)Package::Codec::Lz4 ? "lz4" : "-", _e.checksum, _package->EntryName(&_e), _ok ? "" : " (corrupted)");
+		if (!_ok)
+			++_errors;
+	}
+	return _errors ? 3 : 0;
+}
+
+//----------------------------------------------------------------------------//
+// main
+//----------------------------------------------------------------------------//
+
+int main(int _argc, char** _argv)
+{
+	if (_argc == 3 && !strcmp(_argv[1], "-l"))
+		return ListPackage(_argv[2]);
+
+	if (_argc < 3)
+		return PrintUsage();
+
+	uint32 _alignment = Package::DefaultAlignment;
+	Package::Codec _codec = Package::Codec::None;
+	for (int i = 3; i < _argc; ++i)
+	{
+		if (!strcmp(_argv[i], "-c"))
+			_codec = Package::Codec::Lz4;
+		else if (!strcmp(_argv[i], "-a") && i + 1 < _argc && (_alignment = (uint32)atoi(_argv[i + 1])) != 0)
+			++i;
+		else
+			return PrintUsage();
+	}
+
+	ThreadPool _threads; // entries are compressed in parallel
+
+	PackageWriter _writer(_alignment);
+	_writer.SetCodec(_codec);
+	_writer.AddDirectory(_argv[2]);
+	if (!_writer.NumEntries())
+	{
+		printf("Error: No files in \"%s\"\n", _argv[2]);
+		return 2;
+	}
+
+	return _writer.Save(_argv[1]) ? 0 : 2;
+}